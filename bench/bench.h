@@ -0,0 +1,56 @@
+/**
+ * @file bench.h
+ * @brief Timing helpers shared by the benchmarks
+ * @author Gabriel Abauzit
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifndef BENCH_ITERATIONS
+	#define BENCH_ITERATIONS 10000
+#endif
+
+/**
+ * @brief Monotonic clock in nanoseconds
+ */
+static inline uint64_t bench_now_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Prints the average time of one operation
+ */
+static inline void bench_report(const char* name, uint64_t elapsed_ns, unsigned iterations) {
+	printf("%-48s %10.1f ns/op\n", name, (double)elapsed_ns / iterations);
+}
+
+/**
+ * @brief Runs code iterations times and prints the average time of one run
+ */
+#define BENCH_RUN(name, iterations, code) do { \
+	unsigned bench_it_; \
+	uint64_t bench_start_ = bench_now_ns(); \
+	for (bench_it_ = 0; bench_it_ < (unsigned)(iterations); bench_it_++) { \
+		code; \
+	} \
+	bench_report((name), bench_now_ns() - bench_start_, (unsigned)(iterations)); \
+} while (0)
+
+/**
+ * @brief Prints a section title
+ */
+static inline void bench_title(const char* title) {
+	printf("╔══════════════════════════════════════════════════════════════╗\n");
+	printf("║ %-60s ║\n", title);
+	printf("╚══════════════════════════════════════════════════════════════╝\n");
+}
+
+#endif
@@ -0,0 +1,64 @@
+/**
+ * @file bench_amalgamation.c
+ * @details Hot kernels built against the per-file objects, and against the amalgamated kyber.c with BENCH_AMALGAMATED
+ * @author Gabriel Abauzit
+ */
+
+#include <stdlib.h>
+#ifdef BENCH_AMALGAMATED
+	#include "kyber.h"
+#else
+	#include "poly.h"
+	#include "polyvec.h"
+	#include "ntt.h"
+#endif
+#include "bench.h"
+
+void random_polyvec(polyvec_t* f) {
+	int i, j;
+
+	for (i = 0; i < KYBER_K; i++) {
+		for (j = 0; j < KYBER_N; j++) {
+			f->vec[i].coeffs[j] = barrett_reduce((int16_t)(rand() % KYBER_Q));
+		}
+	}
+}
+
+int main() {
+	int i;
+	polymat_t* A = polymat_new();
+	polyvec_t u, v, r;
+	poly_t a, b, c;
+	uint8_t bytes[KYBER_K * 32 * 12];
+
+	if (A == NULL) return EXIT_FAILURE;
+
+	for (i = 0; i < KYBER_K; i++) {
+		random_polyvec(&A->row[i]);
+	}
+	random_polyvec(&u);
+	random_polyvec(&v);
+	a = u.vec[0];
+	b = v.vec[0];
+
+#ifdef BENCH_AMALGAMATED
+	bench_title("HOT KERNELS, AMALGAMATED kyber.c");
+#else
+	bench_title("HOT KERNELS, PER-FILE OBJECTS");
+#endif
+
+	BENCH_RUN("NTT", BENCH_ITERATIONS, c = a; NTT(c.coeffs));
+	BENCH_RUN("NTT_inv", BENCH_ITERATIONS, c = a; NTT_inv(c.coeffs));
+	BENCH_RUN("NTT_multiply", BENCH_ITERATIONS, NTT_multiply(c.coeffs, a.coeffs, b.coeffs));
+	BENCH_RUN("poly_mult", BENCH_ITERATIONS, poly_mult(&c, &a, &b));
+	BENCH_RUN("poly_compress d = du", BENCH_ITERATIONS, c = a; poly_compress(&c, KYBER_DU));
+	BENCH_RUN("poly_decompress d = du", BENCH_ITERATIONS, c = a; poly_decompress(&c, KYBER_DU));
+	BENCH_RUN("polymat_ntt_product", BENCH_ITERATIONS, polymat_ntt_product(&r, A, &u, 0));
+	BENCH_RUN("polyvec_ntt_scalar_product", BENCH_ITERATIONS, polyvec_ntt_scalar_product(&c, &u, &v));
+	BENCH_RUN("polyvec_compress + byte_encode d = du", BENCH_ITERATIONS,
+		r = u; polyvec_compress(&r, KYBER_DU); polyvec_byte_encode(bytes, &r, KYBER_DU));
+
+	polymat_secure_free(&A);
+
+	return EXIT_SUCCESS;
+}
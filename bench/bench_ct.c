@@ -0,0 +1,50 @@
+/**
+ * @file bench_ct.c
+ * @details Implicit rejection on a ciphertext : bytewise constant time comparison and select against ct_differ and ct_cmov
+ * @author Gabriel Abauzit
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "ct.h"
+#include "serialize.h"
+#include "bench.h"
+
+__attribute__((noinline)) static uint8_t bytewise_differ(const uint8_t* a, const uint8_t* b, const size_t len) {
+	uint8_t diff = 0;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		diff |= a[i] ^ b[i];
+	}
+	return (uint8_t)((0 - (uint32_t)diff) >> 31);
+}
+
+__attribute__((noinline)) static void bytewise_cmov(uint8_t* r, const uint8_t* x, const size_t len, uint8_t b) {
+	size_t i;
+
+	b = (uint8_t)(0 - b);
+	for (i = 0; i < len; i++) {
+		r[i] ^= b & (r[i] ^ x[i]);
+	}
+}
+
+int main() {
+	static uint8_t a[CIPHERTEXT_BYTES], b[CIPHERTEXT_BYTES];
+	uint8_t K[32] = {0}, K_bar[32] = {1};
+	volatile uint8_t sink = 0;
+
+	memset(a, 0x5a, sizeof(a));
+	memcpy(b, a, sizeof(b));
+
+	bench_title("CIPHERTEXT COMPARISON");
+	BENCH_RUN("bytewise", BENCH_ITERATIONS, sink ^= bytewise_differ(a, b, CIPHERTEXT_BYTES));
+	BENCH_RUN("ct_differ", BENCH_ITERATIONS, sink ^= ct_differ(a, b, CIPHERTEXT_BYTES));
+
+	bench_title("SHARED SECRET SELECTION");
+	BENCH_RUN("bytewise", BENCH_ITERATIONS, bytewise_cmov(K, K_bar, sizeof(K), sink & 1));
+	BENCH_RUN("ct_cmov", BENCH_ITERATIONS, ct_cmov(K, K_bar, sizeof(K), sink & 1));
+
+	(void)sink;
+	return EXIT_SUCCESS;
+}
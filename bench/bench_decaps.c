@@ -0,0 +1,78 @@
+/**
+ * @file bench_decaps.c
+ * @details Decapsulation of many ciphertexts under the same key : one at a time against interleaved batches
+ * @author Gabriel Abauzit
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "polyvec.h"
+#include "keycache.h"
+#include "decaps.h"
+#include "bench.h"
+
+#ifndef DECAPS_CIPHERTEXTS
+	#define DECAPS_CIPHERTEXTS 256
+#endif
+
+// Stand-ins for G, J and the samplers, cheap so that the benchmark measures the lattice part
+void bench_derive(uint8_t K[DECAPS_KEY_BYTES], polyvec_t* r, polyvec_t* e1, poly_t* e2, const uint8_t m[KYBER_N / 8], const uint8_t ek_hash[KEYCACHE_FINGERPRINT_BYTES], void* arg) {
+	int i, j;
+
+	(void)ek_hash;
+	(void)arg;
+	memcpy(K, m, DECAPS_KEY_BYTES);
+	for (i = 0; i < KYBER_K; i++) {
+		for (j = 0; j < KYBER_N; j++) {
+			r->vec[i].coeffs[j] = (int16_t)((m[j / 8] >> (j % 8)) & 1);
+			e1->vec[i].coeffs[j] = (int16_t)(1 - r->vec[i].coeffs[j]);
+		}
+	}
+	memcpy(e2, &r->vec[0], sizeof(poly_t));
+}
+
+void bench_reject(uint8_t K_bar[DECAPS_KEY_BYTES], const uint8_t ct[CIPHERTEXT_BYTES], void* arg) {
+	(void)arg;
+	memcpy(K_bar, ct, DECAPS_KEY_BYTES);
+}
+
+int main() {
+	static prepared_key_t dk;
+	static uint8_t cts[DECAPS_CIPHERTEXTS][CIPHERTEXT_BYTES];
+	static uint8_t keys[DECAPS_CIPHERTEXTS][DECAPS_KEY_BYTES];
+	polymat_t* A = polymat_new();
+	polyvec_t s;
+	uint8_t s_bytes[KEYCACHE_VECTOR_BYTES], fingerprint[KEYCACHE_FINGERPRINT_BYTES] = {0};
+	decaps_primitives_t prim = {bench_derive, bench_reject, NULL};
+	int i, j;
+
+	if (A == NULL) return EXIT_FAILURE;
+
+	for (i = 0; i < KYBER_K; i++) {
+		for (j = 0; j < KYBER_K * KYBER_N; j++) {
+			A->row[i].vec[j / KYBER_N].coeffs[j % KYBER_N] = (int16_t)(rand() % KYBER_Q);
+		}
+		for (j = 0; j < KYBER_N; j++) {
+			s.vec[i].coeffs[j] = (int16_t)(rand() % KYBER_Q);
+		}
+	}
+	polyvec_byte_encode(s_bytes, &s, 12);
+	if (prepared_key_init(&dk, fingerprint, s_bytes, s_bytes, A) == EXIT_FAILURE) return EXIT_FAILURE;
+	for (i = 0; i < DECAPS_CIPHERTEXTS; i++) {
+		for (j = 0; j < CIPHERTEXT_BYTES; j++) {
+			cts[i][j] = (uint8_t)rand();
+		}
+	}
+
+	bench_title("DECAPSULATION UNDER THE SAME KEY");
+	printf("%d ciphertexts, batches of %d, times are per ciphertext\n", DECAPS_CIPHERTEXTS, DECAPS_BATCH);
+
+	BENCH_RUN("kem_dec one at a time", 16 * DECAPS_CIPHERTEXTS,
+		kem_dec(&dk, &prim, cts[bench_it_ % DECAPS_CIPHERTEXTS], keys[bench_it_ % DECAPS_CIPHERTEXTS]));
+	BENCH_RUN("kem_dec_many", 16 * DECAPS_CIPHERTEXTS,
+		if (bench_it_ % DECAPS_CIPHERTEXTS == 0) kem_dec_many(&dk, &prim, DECAPS_CIPHERTEXTS, (const uint8_t (*)[CIPHERTEXT_BYTES])cts, keys));
+
+	polymat_secure_free(&A);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file bench_dispatch.c
+ * @details Startup cost of the autotuner with and without its cache file, and the kernels before and after tuning
+ * @author Gabriel Abauzit
+ */
+
+#include <stdlib.h>
+#include "ntt.h"
+#include "encode.h"
+#include "poly.h"
+#include "dispatch.h"
+#include "bench.h"
+
+#define CACHE_PATH "bench_dispatch.cache"
+
+static void bench_kernels(void) {
+	static int16_t f[KYBER_N], g[KYBER_N];
+	static uint8_t bytes[KYBER_N * 12 / 8];
+	static poly_t p;
+	int i;
+
+	for (i = 0; i < KYBER_N; i++) {
+		f[i] = (int16_t)(rand() % KYBER_Q);
+		g[i] = (int16_t)(rand() % KYBER_Q);
+		p.coeffs[i] = f[i];
+	}
+
+	BENCH_RUN("NTT", BENCH_ITERATIONS, NTT(f));
+	BENCH_RUN("NTT_inv_scaled", BENCH_ITERATIONS, NTT_inv_scaled(f, NTT_INV_FACTOR_R1));
+	BENCH_RUN("NTT_multiply", BENCH_ITERATIONS, NTT_multiply(f, f, g));
+	BENCH_RUN("byte_decode (d = 10)", BENCH_ITERATIONS, byte_decode(f, bytes, KYBER_DU));
+	BENCH_RUN("byte_encode (d = 10)", BENCH_ITERATIONS, byte_encode(bytes, f, KYBER_DU));
+	BENCH_RUN("poly_compress (d = 10)", BENCH_ITERATIONS, poly_compress(&p, KYBER_DU));
+}
+
+int main() {
+	uint64_t start;
+	int k;
+
+	remove(CACHE_PATH);
+
+	bench_title("DISPATCH AUTOTUNING AT STARTUP");
+	start = bench_now_ns();
+	if (dispatch_autotune(CACHE_PATH) == EXIT_FAILURE) return EXIT_FAILURE;
+	bench_report("dispatch_autotune (no cache file)", bench_now_ns() - start, 1);
+	BENCH_RUN("dispatch_autotune (cache file)", 100,
+		dispatch_autotune(CACHE_PATH));
+	for (k = 0; k < DISPATCH_KERNELS; k++) {
+		printf("  %-14s %s\n", dispatch_kernel_name((dispatch_kernel_t)k), dispatch_selected((dispatch_kernel_t)k));
+	}
+
+	bench_title("KERNELS, DEFAULT TABLE");
+	dispatch_reset();
+	bench_kernels();
+
+	bench_title("KERNELS, TUNED TABLE");
+	dispatch_autotune(CACHE_PATH);
+	bench_kernels();
+
+	remove(CACHE_PATH);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+/**
+ * @file bench_encode.c
+ * @details Reference against BMI2 bytes encoding and decoding, for every d, and against the AVX2 coefficient-wise passes
+ * @author Gabriel Abauzit
+ */
+
+#include <stdlib.h>
+#include "encode.h"
+#include "poly.h"
+#include "poly_avx2.h"
+#include "polyvec.h"
+#include "serialize.h"
+#include "bench.h"
+
+int main() {
+	unsigned i, d;
+	int16_t F[256];
+	uint8_t bytes[32 * 12];
+	char name[64];
+
+	for (i = 0; i < 256; i++) {
+		F[i] = (int16_t)(rand() % KYBER_Q);
+	}
+
+	bench_title("BYTE ENCODE / DECODE");
+
+#ifdef ENCODE_BMI2_AVAILABLE
+	if (!encode_bmi2_supported()) {
+		printf("BMI2 is not supported by this host, only the reference is measured\n");
+	}
+#endif
+
+	for (d = 1; d <= 12; d++) {
+		snprintf(name, sizeof(name), "byte_encode_ref  d = %2u", d);
+		BENCH_RUN(name, BENCH_ITERATIONS, byte_encode_ref(bytes, F, d));
+#ifdef ENCODE_BMI2_AVAILABLE
+		if (encode_bmi2_supported()) {
+			snprintf(name, sizeof(name), "byte_encode_bmi2 d = %2u", d);
+			BENCH_RUN(name, BENCH_ITERATIONS, byte_encode_bmi2(bytes, F, d));
+		}
+#endif
+		snprintf(name, sizeof(name), "byte_decode_ref  d = %2u", d);
+		BENCH_RUN(name, BENCH_ITERATIONS, byte_decode_ref(F, bytes, d));
+#ifdef ENCODE_BMI2_AVAILABLE
+		if (encode_bmi2_supported()) {
+			snprintf(name, sizeof(name), "byte_decode_bmi2 d = %2u", d);
+			BENCH_RUN(name, BENCH_ITERATIONS, byte_decode_bmi2(F, bytes, d));
+		}
+#endif
+	}
+
+	bench_title("MESSAGE ENCODE / DECODE");
+
+	{
+		poly_t f;
+		uint8_t msg[32] = {0};
+
+		BENCH_RUN("byte_decode_ref + poly_decompress (d = 1)", BENCH_ITERATIONS,
+			byte_decode_ref(f.coeffs, msg, 1); poly_decompress(&f, 1));
+		BENCH_RUN("poly_frommsg_ref", BENCH_ITERATIONS, poly_frommsg_ref(&f, msg));
+		BENCH_RUN("poly_compress + byte_encode_ref (d = 1)", BENCH_ITERATIONS,
+			poly_compress(&f, 1); byte_encode_ref(msg, f.coeffs, 1));
+		BENCH_RUN("poly_tomsg_ref", BENCH_ITERATIONS, poly_tomsg_ref(msg, &f));
+#ifdef POLY_AVX2_AVAILABLE
+		if (poly_avx2_supported()) {
+			BENCH_RUN("poly_frommsg_avx2", BENCH_ITERATIONS, poly_frommsg_avx2(&f, msg));
+			BENCH_RUN("poly_tomsg_avx2", BENCH_ITERATIONS, poly_tomsg_avx2(msg, &f));
+		}
+#endif
+	}
+
+	bench_title("COEFFICIENT-WISE PASSES");
+
+	{
+		poly_t f, a, b;
+		volatile int invalid;
+
+		memcpy(a.coeffs, F, sizeof(F));
+		memcpy(b.coeffs, F, sizeof(F));
+		f = a;
+
+		BENCH_RUN("poly_compress_ref (d = du)", BENCH_ITERATIONS, f = a; poly_compress_ref(&f, KYBER_DU));
+		BENCH_RUN("poly_compress_ref (d = dv)", BENCH_ITERATIONS, f = a; poly_compress_ref(&f, KYBER_DV));
+		BENCH_RUN("poly_decompress_ref (d = du)", BENCH_ITERATIONS, poly_decompress_ref(&f, KYBER_DU));
+		BENCH_RUN("poly_reduce_ref", BENCH_ITERATIONS, poly_reduce_ref(&f));
+		BENCH_RUN("poly_to_montgomery_ref", BENCH_ITERATIONS, poly_to_montgomery_ref(&f));
+		BENCH_RUN("poly_from_montgomery_ref", BENCH_ITERATIONS, poly_from_montgomery_ref(&f));
+		BENCH_RUN("poly_add_ref", BENCH_ITERATIONS, poly_add_ref(&f, &a, &b));
+		BENCH_RUN("poly_sub_ref", BENCH_ITERATIONS, poly_sub_ref(&f, &a, &b));
+		BENCH_RUN("poly_is_valid_ref", BENCH_ITERATIONS, invalid = poly_is_valid_ref(&f));
+#ifdef POLY_AVX2_AVAILABLE
+		if (poly_avx2_supported()) {
+			BENCH_RUN("poly_compress_avx2 (d = du)", BENCH_ITERATIONS, f = a; poly_compress_avx2(&f, KYBER_DU));
+			BENCH_RUN("poly_compress_avx2 (d = dv)", BENCH_ITERATIONS, f = a; poly_compress_avx2(&f, KYBER_DV));
+			BENCH_RUN("poly_decompress_avx2 (d = du)", BENCH_ITERATIONS, poly_decompress_avx2(&f, KYBER_DU));
+			BENCH_RUN("poly_reduce_avx2", BENCH_ITERATIONS, poly_reduce_avx2(&f));
+			BENCH_RUN("poly_to_montgomery_avx2", BENCH_ITERATIONS, poly_to_montgomery_avx2(&f));
+			BENCH_RUN("poly_from_montgomery_avx2", BENCH_ITERATIONS, poly_from_montgomery_avx2(&f));
+			BENCH_RUN("poly_add_avx2", BENCH_ITERATIONS, poly_add_avx2(&f, &a, &b));
+			BENCH_RUN("poly_sub_avx2", BENCH_ITERATIONS, poly_sub_avx2(&f, &a, &b));
+			BENCH_RUN("poly_is_valid_avx2", BENCH_ITERATIONS, invalid = poly_is_valid_avx2(&f));
+		}
+#endif
+		(void)invalid;
+	}
+
+	bench_title("ENCAPSULATION KEY MODULUS CHECK");
+
+	{
+		polyvec_t f;
+		uint8_t ek[POLYVEC_BYTES(12)], reencoded[POLYVEC_BYTES(12)];
+		volatile int invalid;
+
+		for (i = 0; i < KYBER_K; i++) {
+			byte_encode(ek + POLY_BYTES(12) * i, F, 12);
+		}
+
+		BENCH_RUN("decode + is_valid + re-encode + compare", BENCH_ITERATIONS,
+			polyvec_byte_decode(&f, ek, 12); invalid = polyvec_is_valid(&f);
+			polyvec_byte_encode(reencoded, &f, 12); invalid |= memcmp(ek, reencoded, sizeof(ek)) != 0);
+		BENCH_RUN("polyvec_decode12_checked", BENCH_ITERATIONS, invalid = polyvec_decode12_checked(&f, ek));
+		(void)invalid;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file bench_keystore.c
+ * @details Startup cost of a key set : decoding every key from its byte encoding against mapping a keystore file
+ * @author Gabriel Abauzit
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include "polyvec.h"
+#include "keystore.h"
+#include "bench.h"
+
+#ifndef KEYSTORE_KEYS
+	#define KEYSTORE_KEYS 10000
+#endif
+
+#define VECTOR_BYTES (KYBER_K * POLY_PACKED_BYTES)
+
+int main() {
+	static uint8_t fingerprints[KEYSTORE_KEYS][KEYSTORE_FINGERPRINT_BYTES];
+	static uint8_t encoded[KEYSTORE_KEYS][VECTOR_BYTES];
+	static polyvec_t decoded[KEYSTORE_KEYS];
+	keystore_t ks;
+	char path[64];
+	volatile const polyvec_t* found;
+	int i, j;
+
+	for (i = 0; i < KEYSTORE_KEYS; i++) {
+		for (j = 0; j < KEYSTORE_FINGERPRINT_BYTES; j++) {
+			fingerprints[i][j] = (uint8_t)rand();
+		}
+		for (j = 0; j < KYBER_K * KYBER_N; j++) {
+			decoded[i].vec[j / KYBER_N].coeffs[j % KYBER_N] = (int16_t)(rand() % KYBER_Q);
+		}
+		polyvec_byte_encode(encoded[i], &decoded[i], 12);
+	}
+
+	snprintf(path, sizeof(path), "/tmp/bench_keystore_%ld.bin", (long)getpid());
+	if (keystore_write(path, (const uint8_t (*)[KEYSTORE_FINGERPRINT_BYTES])fingerprints, decoded, KEYSTORE_KEYS, 1) == EXIT_FAILURE) return EXIT_FAILURE;
+
+	bench_title("KEY SET STARTUP");
+	printf("%d keys, times are per key set\n", KEYSTORE_KEYS);
+
+	BENCH_RUN("polyvec_byte_decode of every key", 10,
+		for (i = 0; i < KEYSTORE_KEYS; i++) polyvec_byte_decode(&decoded[i], encoded[i], 12));
+	BENCH_RUN("keystore_open + close", 10,
+		keystore_open(&ks, path, 0); keystore_close(&ks));
+	BENCH_RUN("keystore_open + find every key + close", 10,
+		keystore_open(&ks, path, 0);
+		for (i = 0; i < KEYSTORE_KEYS; i++) found = keystore_find(&ks, fingerprints[i]);
+		keystore_close(&ks));
+	BENCH_RUN("keystore_open (verified) + close", 10,
+		keystore_open(&ks, path, KEYSTORE_VERIFY); keystore_close(&ks));
+	(void)found;
+
+	remove(path);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file bench_polymat.c
+ * @details Cost of the row pointers, of the transposition copy, of the packed rows and of the streamed entries in the
+ *          matrix/vector product
+ * @author Gabriel Abauzit
+ */
+
+#include <stdlib.h>
+#include "polyvec.h"
+#include "bench.h"
+
+// Number of unrelated allocations made between two rows, to scatter them in memory as a real caller would
+#ifndef SCATTER_GAP
+	#define SCATTER_GAP 8
+#endif
+
+void random_polyvec(polyvec_t* f) {
+	int i, j;
+
+	for (i = 0; i < KYBER_K; i++) {
+		for (j = 0; j < KYBER_N; j++) {
+			f->vec[i].coeffs[j] = barrett_reduce((int16_t)(rand() % KYBER_Q));
+		}
+	}
+}
+
+// Stand-in for SampleNTT(XOF(rho || j || i)) : a generator of canonical coefficients seeded by the position of the entry
+void sample_entry(poly_t* a, const int i, const int j, void* arg) {
+	uint32_t x = (uint32_t)(i * KYBER_K + j + 1) * 2654435761u;
+	int k;
+
+	(void)arg;
+	for (k = 0; k < KYBER_N; k++) {
+		x = x * 1664525 + 1013904223;
+		a->coeffs[k] = (int16_t)((x >> 16) % KYBER_Q);
+	}
+}
+
+// Expands the whole matrix then multiplies, as a caller holding a polymat_t per operation does
+void expand_then_product(polyvec_t* r, polymat_t* A, const polyvec_t* v) {
+	int i, j;
+
+	for (i = 0; i < KYBER_K; i++) {
+		for (j = 0; j < KYBER_K; j++) {
+			sample_entry(&A->row[i].vec[j], i, j, NULL);
+		}
+	}
+	polymat_ntt_product(r, A, v, 0);
+}
+
+int main() {
+	int i, j;
+	polymat_t* A = polymat_new();
+	polymat_t* expanded = polymat_new();
+	polymat_stream_t stream = {sample_entry, NULL};
+	polyvec_t* rows[KYBER_K];
+	void* gaps[KYBER_K * SCATTER_GAP];
+	polyvec_t v, r;
+	polyvec_packed_t A_packed[KYBER_K];
+
+	if (A == NULL || expanded == NULL) return EXIT_FAILURE;
+
+	for (i = 0; i < KYBER_K; i++) {
+		for (j = 0; j < SCATTER_GAP; j++) {
+			gaps[i * SCATTER_GAP + j] = malloc(sizeof(polyvec_t));
+		}
+		rows[i] = (polyvec_t*)malloc(sizeof(polyvec_t));
+		if (rows[i] == NULL) return EXIT_FAILURE;
+		random_polyvec(&A->row[i]);
+		polyvec_copy(rows[i], &A->row[i]);
+		polyvec_pack(&A_packed[i], &A->row[i]);
+	}
+	random_polyvec(&v);
+
+	bench_title("MATRIX/VECTOR PRODUCT");
+	printf("K = %d, %d iterations\n", KYBER_K, BENCH_ITERATIONS);
+
+	BENCH_RUN("polyvec_ntt_product (scattered rows)", BENCH_ITERATIONS,
+		polyvec_ntt_product(&r, (const polyvec_t**)rows, &v));
+	BENCH_RUN("polymat_ntt_product", BENCH_ITERATIONS,
+		polymat_ntt_product(&r, A, &v, 0));
+
+	BENCH_RUN("polyvec_ntt_product_packed", BENCH_ITERATIONS,
+		polyvec_ntt_product_packed(&r, A_packed, &v));
+
+	BENCH_RUN("polyvec_transpose", BENCH_ITERATIONS,
+		polyvec_transpose(rows));
+	BENCH_RUN("polyvec_transpose + polyvec_ntt_product", BENCH_ITERATIONS,
+		polyvec_transpose(rows); polyvec_ntt_product(&r, (const polyvec_t**)rows, &v));
+	BENCH_RUN("polymat_ntt_product (transposed)", BENCH_ITERATIONS,
+		polymat_ntt_product(&r, A, &v, 1));
+
+	bench_title("MATRIX GENERATED DURING THE PRODUCT");
+	printf("Matrix held per operation : %zu bytes expanded, %zu bytes streamed (one tile and one product)\n",
+		sizeof(polymat_t), 2 * sizeof(poly_t));
+
+	BENCH_RUN("expansion + polymat_ntt_product", BENCH_ITERATIONS,
+		expand_then_product(&r, expanded, &v));
+	BENCH_RUN("polyvec_ntt_product_stream", BENCH_ITERATIONS,
+		polyvec_ntt_product_stream(&r, &stream, &v, 0));
+	BENCH_RUN("polyvec_ntt_product_stream (transposed)", BENCH_ITERATIONS,
+		polyvec_ntt_product_stream(&r, &stream, &v, 1));
+
+	for (i = 0; i < KYBER_K; i++) {
+		polyvec_secure_free(&rows[i]);
+		for (j = 0; j < SCATTER_GAP; j++) {
+			free(gaps[i * SCATTER_GAP + j]);
+		}
+	}
+	polymat_secure_free(&A);
+	polymat_secure_free(&expanded);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file bench_randpool.c
+ * @details Seeds of 32 bytes : one getrandom call per seed against the randomness pool
+ * @author Gabriel Abauzit
+ */
+
+#include <stdlib.h>
+#include "randpool.h"
+#include "bench.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<sys/random.h>)
+#include <sys/random.h>
+#define BENCH_GETRANDOM 1
+#endif
+#endif
+
+int main() {
+	uint8_t seed[RANDPOOL_SEED_BYTES], det[RANDPOOL_SEED_BYTES] = {0};
+	uint64_t refills;
+
+	bench_title("32-BYTE SEEDS");
+
+#ifdef BENCH_GETRANDOM
+	BENCH_RUN("getrandom per seed", BENCH_ITERATIONS,
+		if (getrandom(seed, sizeof(seed), 0) != (ssize_t)sizeof(seed)) return EXIT_FAILURE);
+#endif
+	refills = randpool_refills();
+	BENCH_RUN("randpool_seed", BENCH_ITERATIONS,
+		if (randpool_seed(seed) == EXIT_FAILURE) return EXIT_FAILURE);
+	printf("  %llu refills for %d seeds\n", (unsigned long long)(randpool_refills() - refills), BENCH_ITERATIONS);
+
+	randpool_deterministic(det);
+	BENCH_RUN("randpool_seed (deterministic mode)", BENCH_ITERATIONS,
+		randpool_seed(seed));
+	randpool_deterministic(NULL);
+
+	return EXIT_SUCCESS;
+}
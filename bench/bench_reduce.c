@@ -0,0 +1,54 @@
+/**
+ * @file bench_reduce.c
+ * @details Multiplications by the zetas with each reduction family, and the NTT kernels built with KYBER_REDUCE
+ * @author Gabriel Abauzit
+ */
+
+#include <stdlib.h>
+#include "reduce.h"
+#include "poly.h"
+#include "ntt.h"
+#include "bench.h"
+
+#if KYBER_REDUCE == KYBER_REDUCE_SHOUP
+	#define REDUCE_NAME "SHOUP"
+#elif KYBER_REDUCE == KYBER_REDUCE_PLANTARD
+	#define REDUCE_NAME "PLANTARD"
+#else
+	#define REDUCE_NAME "MONTGOMERY"
+#endif
+
+int main() {
+	int i, j;
+	int16_t x[KYBER_N], y[KYBER_N];
+	poly_t a, b, c;
+	volatile int16_t sink;
+
+	for (i = 0; i < KYBER_N; i++) {
+		x[i] = (int16_t)(rand() % KYBER_Q - KYBER_Q / 2);
+		a.coeffs[i] = barrett_reduce((int16_t)(rand() % KYBER_Q));
+		b.coeffs[i] = barrett_reduce((int16_t)(rand() % KYBER_Q));
+	}
+
+	bench_title("MULTIPLICATIONS BY THE ZETAS, 256 PER RUN");
+
+	BENCH_RUN("fqmul (Montgomery)", BENCH_ITERATIONS,
+		for (j = 0; j < KYBER_N; j++) y[j] = fqmul(zetas[j / 2], x[j]);
+		sink = y[bench_it_ % KYBER_N]);
+	BENCH_RUN("shoup_mul", BENCH_ITERATIONS,
+		for (j = 0; j < KYBER_N; j++) y[j] = shoup_mul(x[j], zetas_shoup[j / 2], zetas_shoup_quot[j / 2]);
+		sink = y[bench_it_ % KYBER_N]);
+	BENCH_RUN("plantard_mul", BENCH_ITERATIONS,
+		for (j = 0; j < KYBER_N; j++) y[j] = plantard_mul(x[j], zetas_plantard[j / 2]);
+		sink = y[bench_it_ % KYBER_N]);
+	(void)sink;
+
+	bench_title("NTT KERNELS, KYBER_REDUCE = " REDUCE_NAME);
+
+	BENCH_RUN("NTT", BENCH_ITERATIONS, c = a; NTT(c.coeffs));
+	BENCH_RUN("NTT_inv", BENCH_ITERATIONS, c = a; NTT_inv(c.coeffs));
+	BENCH_RUN("NTT_multiply", BENCH_ITERATIONS, NTT_multiply(c.coeffs, a.coeffs, b.coeffs));
+	BENCH_RUN("NTT_multiply_cache", BENCH_ITERATIONS, NTT_multiply_cache(c.coeffs, a.coeffs));
+
+	return EXIT_SUCCESS;
+}
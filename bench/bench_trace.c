@@ -0,0 +1,30 @@
+/**
+ * @file bench_trace.c
+ * @details Cost of a TRACE_BEGIN / TRACE_END pair compiled in, with tracing disabled then enabled
+ * @author Gabriel Abauzit
+ */
+
+#define KYBER_TRACE
+
+#include <stdlib.h>
+#include "polyvec.h"
+#include "trace.h"
+#include "bench.h"
+
+int main() {
+	polyvec_t f = {0};
+
+	bench_title("TRACE EVENTS");
+
+	BENCH_RUN("polyvec_ntt", BENCH_ITERATIONS, polyvec_ntt(&f));
+	BENCH_RUN("polyvec_ntt + trace pair, disabled", BENCH_ITERATIONS,
+		TRACE_BEGIN("polyvec_ntt"); polyvec_ntt(&f); TRACE_END("polyvec_ntt"));
+
+	trace_enable(1);
+	BENCH_RUN("polyvec_ntt + trace pair, enabled", BENCH_ITERATIONS,
+		TRACE_BEGIN("polyvec_ntt"); polyvec_ntt(&f); TRACE_END("polyvec_ntt"));
+	trace_enable(0);
+	trace_reset();
+
+	return EXIT_SUCCESS;
+}
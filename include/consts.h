@@ -35,7 +35,34 @@
 #define MONTGOMERY_RINV 169 // (2^16)^{-1} = 169 mod 3329
 #define MONTGOMERY_INV 3327 // -q^-1 mod 2^16
 #define MONTGOMERY_QINV 62209 // q^-1 mod 2^16 */
+#define MONTGOMERY_R2 1353 // (2^16)^2 = 1353 mod 3329
+#define MONTGOMERY_R3 2293 // (2^16)^3 = 2293 mod 3329
+
+#define PLANTARD_QINV 1806234369 // q^-1 mod 2^32
+#define PLANTARD_ALPHA 3 // 2^alpha is the rounding offset of the Plantard reduction, with alpha = 3 for q = 3329 and l = 16
+
+// Final normalization constants of NTT_inv_scaled : fqmul(x, NTT_INV_FACTOR_e) = x * 128^{-1} * R^e (mod q)
+#define NTT_INV_FACTOR_RM1 -26 // 128^{-1} = -26 mod 3329
+#define NTT_INV_FACTOR_R0 512 // 128^{-1} * 2^16 = 512 mod 3329
+#define NTT_INV_FACTOR_R1 1441 // 128^{-1} * 2^32 = 1441 mod 3329
+#define NTT_INV_FACTOR_R2 304 // 128^{-1} * 2^48 = 304 mod 3329
 
 #define BARRETT_FACTOR 20159 // nearest integer to 2^26/q  ((1<<26) + KYBER_Q/2)/KYBER_Q;
+#define COMPRESS_FACTOR 2580335 // ceil(2^33/q), floor(t * COMPRESS_FACTOR / 2^33) = floor(t / q) for all 0 <= t < 2^23
+
+/*********************/
+/* AMALGAMATED BUILD */
+/*********************/
+
+// Helpers called in the hot loops of other modules. They get internal linkage in the amalgamated kyber.c
+// (make amalgamation) so that the compiler inlines them and drops their out-of-line copy, and stay external otherwise.
+// Only the per-coefficient helpers qualify (compress, decompress, BaseCaseMultiply). The poly_* helpers of the polyvec
+// loops are called once per polynomial : the call is noise next to their 256 coefficients, and they are part of the
+// API of kyber.c, which internal linkage would remove.
+#ifdef KYBER_AMALGAMATED
+#define KYBER_INTERNAL static
+#else
+#define KYBER_INTERNAL
+#endif
 
 #endif
\ No newline at end of file
@@ -0,0 +1,33 @@
+/**
+ * @file ct.h
+ * @brief Constant time comparison, conditional move and erasure of byte arrays, for the implicit rejection of
+ *        decapsulation and the secrets left in memory
+ * @author Gabriel Abauzit
+ */
+
+#ifndef CT_H
+#define CT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/****************************************************************************************************************/
+/* The running time and the memory accesses of these functions only depend on len, never on the bytes. They     */
+/* work on CT_BLOCK_BYTES at a time with the GCC/Clang vector extensions, and on 64-bit words elsewhere.        */
+/* ct_diff accumulates, so that a ciphertext can be compared piece by piece while it is being encoded.          */
+/* ct_zero erases secrets with volatile writes, which the compiler cannot drop as it may drop a final memset.   */
+/****************************************************************************************************************/
+
+#define CT_BLOCK_BYTES 32
+
+uint64_t ct_diff(uint64_t acc, const uint8_t* a, const uint8_t* b, const size_t len);
+
+uint8_t ct_nonzero(const uint64_t acc);
+
+uint8_t ct_differ(const uint8_t* a, const uint8_t* b, const size_t len);
+
+void ct_cmov(uint8_t* r, const uint8_t* x, const size_t len, const uint8_t b);
+
+void ct_zero(void* ptr, const size_t len);
+
+#endif
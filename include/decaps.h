@@ -0,0 +1,39 @@
+/**
+ * @file decaps.h
+ * @brief Decapsulation of batches of ciphertexts under the same prepared key
+ * @author Gabriel Abauzit
+ */
+
+#ifndef DECAPS_H
+#define DECAPS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "poly.h"
+#include "polyvec.h"
+#include "serialize.h"
+#include "keycache.h"
+
+// Number of ciphertexts that go through each stage of kem_dec_many together
+#ifndef DECAPS_BATCH
+	#define DECAPS_BATCH 4
+#endif
+
+// Size of the shared secret K
+#define DECAPS_KEY_BYTES 32
+
+// The hash functions and samplers of FIPS 203 are not part of this library, decapsulation calls the caller's ones.
+// Both functions must be constant time in their secret inputs.
+typedef struct {
+    // (K, r) = G(m || H(ek)), then r, e1, e2 sampled from r with PRF and CBD as in K-PKE.Encrypt
+    void (*derive)(uint8_t K[DECAPS_KEY_BYTES], polyvec_t* r, polyvec_t* e1, poly_t* e2, const uint8_t m[KYBER_N / 8], const uint8_t ek_hash[KEYCACHE_FINGERPRINT_BYTES], void* arg);
+    // K_bar = J(z || c), z being held by the caller in arg
+    void (*reject)(uint8_t K_bar[DECAPS_KEY_BYTES], const uint8_t ct[CIPHERTEXT_BYTES], void* arg);
+    void* arg;
+} decaps_primitives_t;
+
+void kem_dec_many(const prepared_key_t* dk, const decaps_primitives_t* prim, const size_t n, const uint8_t (*cts)[CIPHERTEXT_BYTES], uint8_t (*keys)[DECAPS_KEY_BYTES]);
+
+void kem_dec(const prepared_key_t* dk, const decaps_primitives_t* prim, const uint8_t ct[CIPHERTEXT_BYTES], uint8_t key[DECAPS_KEY_BYTES]);
+
+#endif
@@ -0,0 +1,64 @@
+/**
+ * @file dispatch.h
+ * @brief Dispatch table of the hot kernels, and the startup autotuner that fills it
+ * @author Gabriel Abauzit
+ */
+
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "poly.h"
+
+/******************************************************************************************************************/
+/* NTT, NTT_inv_scaled, NTT_multiply, byte_encode, byte_decode and poly_compress call the entry of dispatch_table. */
+/* All the variants of a kernel compute the same output, only their speed differs from one host to another.       */
+/* dispatch_autotune times them for a few milliseconds and installs the fastest ones. Call it once at startup,    */
+/* before other threads use the library : the table is read without synchronization.                              */
+/******************************************************************************************************************/
+
+// Time given to each kernel by dispatch_autotune, shared between its variants
+#ifndef DISPATCH_TUNE_NS
+	#define DISPATCH_TUNE_NS 2000000
+#endif
+
+// Version of the cache file written by dispatch_autotune
+#define DISPATCH_CACHE_VERSION 2
+
+typedef enum {
+    DISPATCH_NTT,
+    DISPATCH_NTT_INV,
+    DISPATCH_NTT_MULTIPLY,
+    DISPATCH_BYTE_ENCODE,
+    DISPATCH_BYTE_DECODE,
+    DISPATCH_COMPRESS,
+    DISPATCH_KERNELS               // number of kernels
+} dispatch_kernel_t;
+
+typedef struct {
+    void (*ntt)(int16_t f[256]);
+    void (*ntt_inv_scaled)(int16_t f[256], const int16_t factor);
+    void (*ntt_multiply)(int16_t r[256], const int16_t a[256], const int16_t b[256]);
+    void (*byte_encode)(uint8_t* bytes, const int16_t* F, const unsigned d);
+    void (*byte_decode)(int16_t* F, const uint8_t* bytes, const unsigned d);
+    void (*poly_compress)(poly_t* f, const unsigned d);
+} dispatch_table_t;
+
+extern dispatch_table_t dispatch_table;
+
+const char* dispatch_kernel_name(const dispatch_kernel_t kernel);
+
+size_t dispatch_variants(const dispatch_kernel_t kernel, const char* names[], const size_t max);
+
+const char* dispatch_selected(const dispatch_kernel_t kernel);
+
+int dispatch_select(const dispatch_kernel_t kernel, const char* variant);
+
+void dispatch_reset(void);
+
+int dispatch_check(const dispatch_kernel_t kernel, void (*fn)(void));
+
+int dispatch_autotune(const char* cache_path);
+
+#endif
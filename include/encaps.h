@@ -0,0 +1,37 @@
+/**
+ * @file encaps.h
+ * @brief Encapsulation context, everything encryption needs from a public key computed once
+ * @author Gabriel Abauzit
+ */
+
+#ifndef ENCAPS_H
+#define ENCAPS_H
+
+#include <stdint.h>
+#include "poly.h"
+#include "polyvec.h"
+#include "serialize.h"
+
+// Size of H(ek)
+#define ENCAPS_HASH_BYTES 32
+
+// Size of the t part of ek, ByteEncode_12 of t in the NTT domain
+#define ENCAPS_T_BYTES (KYBER_K * POLY_PACKED_BYTES)
+
+// encaps_ctx_t holds a public key in the form K-PKE.Encrypt consumes it. It is read-only once built, and can be
+// shared by all the encryptions to the same peer, from any number of threads.
+typedef struct {
+    polymat_t At;                             // A^T in the NTT domain, materialized so that its rows are read in order
+    polyvec_ntt_cache_t t_hat;                // t in the NTT domain, with its multiplication cache
+    uint8_t ek_hash[ENCAPS_HASH_BYTES];       // H(ek)
+} encaps_ctx_t;
+
+int encaps_ctx_init(encaps_ctx_t* ctx, const uint8_t t_bytes[ENCAPS_T_BYTES], const polymat_t* A, const uint8_t ek_hash[ENCAPS_HASH_BYTES]);
+
+encaps_ctx_t* encaps_ctx_new(const uint8_t t_bytes[ENCAPS_T_BYTES], const polymat_t* A, const uint8_t ek_hash[ENCAPS_HASH_BYTES]);
+
+void encaps_ctx_secure_free(encaps_ctx_t** ptr);
+
+void encaps_ctx_encrypt(uint8_t ct[CIPHERTEXT_BYTES], const encaps_ctx_t* ctx, const uint8_t m[KYBER_N / 8], const polyvec_t* r, const polyvec_t* e1, const poly_t* e2);
+
+#endif
@@ -8,8 +8,16 @@
 #define ENCODE_H
 
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include "reduce.h"
 
+// The BMI2 fast paths of encode_bmi2.c are built on x86-64 with GCC or Clang, and used when the host supports BMI2.
+// Define KYBER_NO_BMI2 to leave them out.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(KYBER_NO_BMI2)
+#define ENCODE_BMI2_AVAILABLE 1
+#endif
+
 /**************************/
 /* BITS-BYTES CONVERSIONS */
 /**************************/
@@ -18,6 +26,10 @@ void bits_to_bytes(uint8_t* bytes, const uint8_t* bits, unsigned l);
 
 void bytes_to_bits(uint8_t* bits, const uint8_t* bytes, unsigned l);
 
+void bits_to_bytes_ref(uint8_t* bytes, const uint8_t* bits, unsigned l);
+
+void bytes_to_bits_ref(uint8_t* bits, const uint8_t* bytes, unsigned l);
+
 /****************/
 /* BYTES ENCODE */
 /****************/
@@ -26,12 +38,51 @@ void byte_encode(uint8_t* bytes, const int16_t* F, const unsigned d);
 
 void byte_decode(int16_t* F, const uint8_t* bytes, const unsigned d);
 
+void byte_encode_ref(uint8_t* bytes, const int16_t* F, const unsigned d);
+
+void byte_decode_ref(int16_t* F, const uint8_t* bytes, const unsigned d);
+
+void byte_encode_default(uint8_t* bytes, const int16_t* F, const unsigned d);
+
+void byte_decode_default(int16_t* F, const uint8_t* bytes, const unsigned d);
+
+// A block is 8 coefficients, it is encoded to exactly d bytes
+void byte_encode_blocks(uint8_t* bytes, const int16_t* F, const unsigned d, const unsigned nblocks);
+
+void byte_decode_blocks(int16_t* F, const uint8_t* bytes, const unsigned d, const unsigned nblocks);
+
+void byte_encode_blocks_scalar(uint8_t* bytes, const int16_t* F, const unsigned d, const unsigned nblocks);
+
+void byte_decode_blocks_scalar(int16_t* F, const uint8_t* bytes, const unsigned d, const unsigned nblocks);
+
+/************************/
+/* BMI2 PEXT/PDEP PATHS */
+/************************/
+
+#ifdef ENCODE_BMI2_AVAILABLE
+
+int encode_bmi2_supported(void);
+
+void bits_to_bytes_bmi2(uint8_t* bytes, const uint8_t* bits, unsigned l);
+
+void bytes_to_bits_bmi2(uint8_t* bits, const uint8_t* bytes, unsigned l);
+
+void byte_encode_bmi2(uint8_t* bytes, const int16_t* F, const unsigned d);
+
+void byte_decode_bmi2(int16_t* F, const uint8_t* bytes, const unsigned d);
+
+void byte_encode_blocks_bmi2(uint8_t* bytes, const int16_t* F, const unsigned d, const unsigned nblocks);
+
+void byte_decode_blocks_bmi2(int16_t* F, const uint8_t* bytes, const unsigned d, const unsigned nblocks);
+
+#endif
+
 /*********************************/
 /* COMPRESSION AND DECOMPRESSION */
 /*********************************/
 
-int16_t compress(const int16_t x, const unsigned d);
+KYBER_INTERNAL int16_t compress(const int16_t x, const unsigned d);
 
-int16_t decompress(const int16_t x, const unsigned d);
+KYBER_INTERNAL int16_t decompress(const int16_t x, const unsigned d);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,64 @@
+/**
+ * @file keycache.h
+ * @brief Bounded LRU cache of prepared decapsulation keys, safe to share between threads
+ * @author Gabriel Abauzit
+ */
+
+#ifndef KEYCACHE_H
+#define KEYCACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "poly.h"
+#include "polyvec.h"
+
+// Size of the fingerprint keys are looked up with, H(ek) in FIPS 203
+#define KEYCACHE_FINGERPRINT_BYTES 32
+
+// Size of the encoded vectors a key is prepared from, ByteEncode_12 of s and of t in FIPS 203
+#define KEYCACHE_VECTOR_BYTES (KYBER_K * POLY_PACKED_BYTES)
+
+// prepared_key_t holds everything a decapsulation needs that only depends on the key, so that it is computed once :
+// s already decoded and in the form of NTT_multiply_cached, t packed, the public matrix and H(ek).
+// It is read-only once prepared.
+typedef struct {
+    polymat_t A;                                       // public matrix A in the NTT domain
+    polyvec_ntt_cache_t s_hat;                         // secret vector s in the NTT domain, with its multiplication cache
+    polyvec_packed_t t_hat;                            // public vector t in the NTT domain
+    uint8_t fingerprint[KEYCACHE_FINGERPRINT_BYTES];   // H(ek)
+} prepared_key_t;
+
+// Opaque, see keycache.c
+typedef struct keycache_s keycache_t;
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    size_t size;
+    size_t capacity;
+} keycache_stats_t;
+
+/*****************/
+/* PREPARED KEYS */
+/*****************/
+
+int prepared_key_init(prepared_key_t* key, const uint8_t fingerprint[KEYCACHE_FINGERPRINT_BYTES], const uint8_t s_bytes[KEYCACHE_VECTOR_BYTES], const uint8_t t_bytes[KEYCACHE_VECTOR_BYTES], const polymat_t* A);
+
+void prepared_key_secret_product(poly_t* r, const prepared_key_t* key, const polyvec_t* u);
+
+/*********/
+/* CACHE */
+/*********/
+
+keycache_t* keycache_new(const size_t capacity);
+
+void keycache_secure_free(keycache_t** ptr);
+
+const prepared_key_t* keycache_acquire(keycache_t* cache, const uint8_t fingerprint[KEYCACHE_FINGERPRINT_BYTES], const uint8_t s_bytes[KEYCACHE_VECTOR_BYTES], const uint8_t t_bytes[KEYCACHE_VECTOR_BYTES], const polymat_t* A);
+
+void keycache_release(keycache_t* cache, const prepared_key_t* key);
+
+void keycache_stats(keycache_t* cache, keycache_stats_t* stats);
+
+#endif
@@ -0,0 +1,81 @@
+/**
+ * @file keystore.h
+ * @brief Memory-mapped keystore file, keys are stored decoded and used in place
+ * @author Gabriel Abauzit
+ */
+
+#ifndef KEYSTORE_H
+#define KEYSTORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "poly.h"
+#include "polyvec.h"
+
+/*****************************************************************************************************************/
+/* File layout, all integers in the byte order of the host that wrote it (checked by byte_order) :               */
+/*   header   keystore_header_t, KEYSTORE_ALIGN bytes                                                            */
+/*   index    count keystore_index_t sorted by fingerprint, padded to a multiple of KEYSTORE_ALIGN bytes          */
+/*   data     count * vectors_per_key polyvec_t, in the NTT domain with canonical coefficients                   */
+/* The data section is aligned, so once the file is mapped the vectors of a key are a plain polyvec_t array.    */
+/* The checksum covers the index and the data, it is only checked on demand so that opening stays O(1).          */
+/*****************************************************************************************************************/
+
+#define KEYSTORE_MAGIC "KYBKSTR"
+#define KEYSTORE_VERSION 1
+#define KEYSTORE_BYTE_ORDER 0x01020304
+#define KEYSTORE_ALIGN 64
+#define KEYSTORE_FINGERPRINT_BYTES 32
+
+// Flags of keystore_open
+#define KEYSTORE_VERIFY 1
+
+typedef struct {
+    char magic[8];                 // KEYSTORE_MAGIC
+    uint32_t version;              // KEYSTORE_VERSION
+    uint32_t byte_order;           // KEYSTORE_BYTE_ORDER
+    uint32_t kyber_k;              // KYBER_K and KYBER_N of the writer
+    uint32_t kyber_n;
+    uint32_t vectors_per_key;
+    uint32_t reserved;
+    uint64_t count;                // number of keys
+    uint64_t index_offset;
+    uint64_t data_offset;
+    uint64_t checksum;             // FNV-1a of the bytes from index_offset to the end of the file
+} keystore_header_t;
+
+typedef struct {
+    uint8_t fingerprint[KEYSTORE_FINGERPRINT_BYTES];
+    uint64_t slot;                 // position of the key in the data section
+} keystore_index_t;
+
+// An opened keystore, every pointer points into the mapping
+typedef struct {
+    const uint8_t* base;
+    size_t length;
+    const keystore_header_t* header;
+    const keystore_index_t* index;
+    const polyvec_t* data;
+} keystore_t;
+
+/***********/
+/* READING */
+/***********/
+
+int keystore_open(keystore_t* ks, const char* path, const int flags);
+
+int keystore_verify(const keystore_t* ks);
+
+const polyvec_t* keystore_find(const keystore_t* ks, const uint8_t fingerprint[KEYSTORE_FINGERPRINT_BYTES]);
+
+const polyvec_t* keystore_get(const keystore_t* ks, const uint64_t slot);
+
+void keystore_close(keystore_t* ks);
+
+/***********/
+/* WRITING */
+/***********/
+
+int keystore_write(const char* path, const uint8_t fingerprints[][KEYSTORE_FINGERPRINT_BYTES], const polyvec_t* vectors, const uint64_t count, const uint32_t vectors_per_key);
+
+#endif
@@ -15,12 +15,40 @@
 /* for optimization reasons. In particular, the zeta tables in ntt.c are in the Montgomery domain.   */
 /*****************************************************************************************************/
 
+// zetas[i] = zeta^{BitRev_7(i)}, zetas_basemul[i] = zeta^{2*BitRev_7(i) + 1}, in the Montgomery domain
+extern const int16_t zetas[128];
+extern const int16_t zetas_basemul[128];
+
+// The same zetas for the other reduction families, see KYBER_REDUCE in reduce.h
+extern const int16_t zetas_shoup[128];
+extern const int16_t zetas_shoup_quot[128];
+extern const int16_t zetas_basemul_shoup[128];
+extern const int16_t zetas_basemul_shoup_quot[128];
+extern const int32_t zetas_plantard[128];
+extern const int32_t zetas_basemul_plantard[128];
+
 void NTT(int16_t f[256]);
 
+void NTT_ref(int16_t f[256]);
+
 void NTT_inv(int16_t f[256]);
 
-void BaseCaseMultiply(int16_t* r0, int16_t* r1, const int16_t* a0, const int16_t* a1, const int16_t* b0, const int16_t* b1, const int16_t* m);
+void NTT_inv_scaled(int16_t f[256], const int16_t factor);
+
+void NTT_inv_scaled_ref(int16_t f[256], const int16_t factor);
+
+void NTT_inv_add_compress(int16_t r[256], int16_t f[256], const int16_t e[256], const int16_t m[256], const int16_t factor, const unsigned d);
+
+KYBER_INTERNAL void BaseCaseMultiply(int16_t* r0, int16_t* r1, const int16_t* a0, const int16_t* a1, const int16_t* b0, const int16_t* b1, const int i);
 
 void NTT_multiply(int16_t r[256], const int16_t a[256], const int16_t b[256]);
 
+void NTT_multiply_ref(int16_t r[256], const int16_t a[256], const int16_t b[256]);
+
+void NTT_multiply_cache(int16_t cache[128], const int16_t a[256]);
+
+void NTT_multiply_cached(int16_t r[256], const int16_t a[256], const int16_t a_cache[128], const int16_t b[256]);
+
+void NTT_multiply_packed(int16_t r[256], const uint8_t a[384], const int16_t b[256]);
+
 #endif
\ No newline at end of file
@@ -13,6 +13,7 @@
 #include "consts.h"
 #include "reduce.h"
 #include "ntt.h"
+#include "encode.h"
 
 // poly_t f represents the polynomial f_0 + f_1*x + ... + f_255*x^255 where f_i = f.coeffs[i].
 // The canonical representants of the coefficients modulo q are in [-(q-1)/2,(q-1)/2].
@@ -20,6 +21,74 @@ typedef struct {
     int16_t coeffs[KYBER_N];
 } poly_t;
 
+// The representation a polynomial is stored in. The NTT and Montgomery representations are independent,
+// POLY_NTT_MONTGOMERY = POLY_NTT | POLY_MONTGOMERY.
+typedef enum {
+    POLY_NORMAL = 0,
+    POLY_MONTGOMERY = 1,
+    POLY_NTT = 2,
+    POLY_NTT_MONTGOMERY = 3
+} poly_domain_t;
+
+// poly_dom_t is a polynomial tagged with the domain its coefficients are in, so that conversions are only done when needed.
+typedef struct {
+    poly_t poly;
+    poly_domain_t domain;
+} poly_dom_t;
+
+// poly_ntt_cache_t holds a polynomial a in the form NTT_multiply needs it : its NTT and the precomputation of
+// NTT_multiply_cache. It is never modified after poly_ntt_cache_new, and can be shared read-only across threads.
+typedef struct {
+    poly_t hat;
+    int16_t mulcache[KYBER_N / 2];
+} poly_ntt_cache_t;
+
+// Size of a packed polynomial, 12 bits per coefficient
+#define POLY_PACKED_BYTES (KYBER_N * 12 / 8)
+
+// poly_packed_t stores a polynomial in 384 bytes instead of 512, with its coefficients in [0, q) on 12 bits as in
+// ByteEncode_12. It is meant for long-lived NTT-domain operands such as public keys, which are only read by the
+// *_packed products and never need to be unpacked as a whole.
+typedef struct {
+    uint8_t bytes[POLY_PACKED_BYTES];
+} poly_packed_t;
+
+/**********/
+/* BOUNDS */
+/**********/
+
+// Worst-case |coefficient| of what each stage outputs, and of what it accepts as input. poly_add_noreduce and
+// poly_sub_noreduce add the bounds of their operands : a chain of them needs no reduction as long as the sum of the
+// bounds stays within what its consumer accepts. The chains of the library are checked below.
+//
+//   output of                                               bound
+//   barrett_reduce, fqmul, NTT, poly_add, poly_sub          POLY_BOUND_CANONICAL   (q-1)/2
+//   NTT_multiply, the sum of two fqmul per coefficient      POLY_BOUND_BASEMUL     q-1
+//   poly_decompress                                         POLY_BOUND_DECOMPRESS  q
+//   CBD noise                                               POLY_BOUND_NOISE       eta1
+//   sum of K NTT_multiply, the polyvec NTT products         POLY_BOUND_PRODUCT     K (q-1)
+//
+//   input of                                                bound
+//   NTT_inv, NTT_inv_scaled, *_ntt_inv_add_compress         POLY_BOUND_NTT_INV     2^14 - 1, t + u must fit int16
+//   barrett_reduce, fqmul (with a canonical constant)       POLY_BOUND_INT16       2^15 - 1
+#define POLY_BOUND_CANONICAL ((KYBER_Q - 1) / 2)
+#define POLY_BOUND_BASEMUL (2 * POLY_BOUND_CANONICAL)
+#define POLY_BOUND_DECOMPRESS KYBER_Q
+#define POLY_BOUND_NOISE KYBER_ETA1
+#define POLY_BOUND_PRODUCT (KYBER_K * POLY_BOUND_BASEMUL)
+#define POLY_BOUND_NTT_INV (INT16_MAX / 2)
+#define POLY_BOUND_INT16 INT16_MAX
+
+// The NTT products of polyvec.c, encaps.c and decaps.c add their K terms without reduction before an inverse NTT
+_Static_assert(POLY_BOUND_PRODUCT <= POLY_BOUND_NTT_INV, "a sum of K products is a valid input of the inverse NTT");
+
+// With KYBER_DEBUG (make DEBUG=1), checks that every coefficient of f is within bound and aborts otherwise
+#ifdef KYBER_DEBUG
+#define POLY_ASSERT_BOUND(f, bound) poly_assert_bound((f), (bound), __FILE__, __LINE__)
+#else
+#define POLY_ASSERT_BOUND(f, bound) do { } while (0)
+#endif
+
 /***********************/
 /* UTILITARY FUNCTIONS */
 /***********************/
@@ -28,8 +97,16 @@ void poly_zero(poly_t* f);
 
 int poly_is_valid(const poly_t* f);
 
+int poly_is_valid_ref(const poly_t* f);
+
 void poly_reduce(poly_t* f);
 
+void poly_reduce_ref(poly_t* f);
+
+int poly_within_bound(const poly_t* f, const int16_t bound);
+
+void poly_assert_bound(const poly_t* f, const int16_t bound, const char* file, const int line);
+
 int poly_equal(const poly_t* f, const poly_t* g);
 
 void poly_secure_free(poly_t** f);
@@ -44,6 +121,10 @@ void poly_to_montgomery(poly_t* f);
 
 void poly_from_montgomery(poly_t* f);
 
+void poly_to_montgomery_ref(poly_t* f);
+
+void poly_from_montgomery_ref(poly_t* f);
+
 /********************************/
 /* ARITHMETIC OPERATIONS IN R_q */
 /********************************/
@@ -52,6 +133,14 @@ void poly_add(poly_t* r, const poly_t* a, const poly_t* b);
 
 void poly_sub(poly_t* r, const poly_t* a, const poly_t* b);
 
+void poly_add_ref(poly_t* r, const poly_t* a, const poly_t* b);
+
+void poly_sub_ref(poly_t* r, const poly_t* a, const poly_t* b);
+
+void poly_add_noreduce(poly_t* r, const poly_t* a, const poly_t* b);
+
+void poly_sub_noreduce(poly_t* r, const poly_t* a, const poly_t* b);
+
 void poly_mult(poly_t* r, const poly_t* a, const poly_t* b);
 
 /*********************************/
@@ -60,7 +149,65 @@ void poly_mult(poly_t* r, const poly_t* a, const poly_t* b);
 
 void poly_compress(poly_t* f, const unsigned d);
 
+void poly_compress_ref(poly_t* f, const unsigned d);
+
 void poly_decompress(poly_t* f, const unsigned d);
 
+void poly_decompress_ref(poly_t* f, const unsigned d);
+
+void poly_ntt_inv_add_compress(poly_t* r, poly_t* f, const poly_t* e, const poly_t* m, const unsigned d);
+
+/********************/
+/* MESSAGE ENCODING */
+/********************/
+
+void poly_frommsg(poly_t* r, const uint8_t msg[KYBER_N / 8]);
+
+void poly_tomsg(uint8_t msg[KYBER_N / 8], const poly_t* f);
+
+void poly_frommsg_ref(poly_t* r, const uint8_t msg[KYBER_N / 8]);
+
+void poly_tomsg_ref(uint8_t msg[KYBER_N / 8], const poly_t* f);
+
+void poly_frommsg_bits(poly_t* r, const uint8_t msg[KYBER_N / 8]);
+
+/***************************/
+/* CHECKED 12-BIT DECODING */
+/***************************/
+
+int poly_decode12_checked(poly_t* f, const uint8_t bytes[32 * 12]);
+
+int poly_decode12_checked_ref(poly_t* f, const uint8_t bytes[32 * 12]);
+
+/*****************************/
+/* DOMAIN-TAGGED POLYNOMIALS */
+/*****************************/
+
+void poly_dom_init(poly_dom_t* f, const poly_t* source, const poly_domain_t domain);
+
+void poly_dom_convert(poly_dom_t* f, const poly_domain_t domain);
+
+void poly_dom_mult(poly_dom_t* r, const poly_dom_t* a, const poly_dom_t* b, const poly_domain_t domain);
+
+/******************************/
+/* NTT-CACHED MULTIPLICATIONS */
+/******************************/
+
+void poly_ntt_cache_init(poly_ntt_cache_t* cache, const poly_t* a);
+
+poly_ntt_cache_t* poly_ntt_cache_new(const poly_t* a);
+
+void poly_ntt_cache_secure_free(poly_ntt_cache_t** ptr);
+
+void poly_mult_cached(poly_t* r, const poly_ntt_cache_t* a, const poly_t* b);
+
+/**********************/
+/* PACKED POLYNOMIALS */
+/**********************/
+
+void poly_pack(poly_packed_t* r, const poly_t* f);
+
+void poly_unpack(poly_t* r, const poly_packed_t* f);
+
 
 #endif
\ No newline at end of file
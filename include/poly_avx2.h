@@ -0,0 +1,71 @@
+/**
+ * @file poly_avx2.h
+ * @brief AVX2 kernels for coefficient-wise operations on polynomials
+ * @author Gabriel Abauzit
+ */
+
+#ifndef POLY_AVX2_H
+#define POLY_AVX2_H
+
+#include <stdint.h>
+#include "poly.h"
+
+// The AVX2 kernels of poly_avx2.c are built on x86-64 with GCC or Clang, and used when the host supports AVX2.
+// Define KYBER_NO_AVX2 to leave them out.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(KYBER_NO_AVX2)
+#define POLY_AVX2_AVAILABLE 1
+#endif
+
+#ifdef POLY_AVX2_AVAILABLE
+
+int poly_avx2_supported(void);
+
+/**********************/
+/* MODULAR REDUCTIONS */
+/**********************/
+
+void poly_reduce_avx2(poly_t* f);
+
+void poly_to_montgomery_avx2(poly_t* f);
+
+void poly_from_montgomery_avx2(poly_t* f);
+
+/**************/
+/* ARITHMETIC */
+/**************/
+
+void poly_add_avx2(poly_t* r, const poly_t* a, const poly_t* b);
+
+void poly_sub_avx2(poly_t* r, const poly_t* a, const poly_t* b);
+
+/*********************************/
+/* COMPRESSION AND DECOMPRESSION */
+/*********************************/
+
+void poly_compress_avx2(poly_t* f, const unsigned d);
+
+void poly_decompress_avx2(poly_t* f, const unsigned d);
+
+/************/
+/* VALIDITY */
+/************/
+
+int poly_is_valid_avx2(const poly_t* f);
+
+/********************/
+/* MESSAGE ENCODING */
+/********************/
+
+void poly_frommsg_avx2(poly_t* r, const uint8_t msg[KYBER_N / 8]);
+
+void poly_tomsg_avx2(uint8_t msg[KYBER_N / 8], const poly_t* f);
+
+/***************************/
+/* CHECKED 12-BIT DECODING */
+/***************************/
+
+int poly_decode12_checked_avx2(poly_t* f, const uint8_t bytes[32 * 12]);
+
+#endif
+
+#endif
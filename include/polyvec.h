@@ -17,6 +17,32 @@ typedef struct {
 	poly_t vec[KYBER_K];
 } polyvec_t;
 
+// Alignment of polymat_t, one cache line
+#define POLYMAT_ALIGN 64
+
+// K*K matrix of polynomials stored contiguously row by row, row[i].vec[j] is the entry (i,j).
+// The transpose is never materialized, products take a flag telling in which order the entries are walked.
+typedef struct {
+	_Alignas(POLYMAT_ALIGN) polyvec_t row[KYBER_K];
+} polymat_t;
+
+// Cached NTT form of a vector, see poly_ntt_cache_t
+typedef struct {
+	poly_ntt_cache_t vec[KYBER_K];
+} polyvec_ntt_cache_t;
+
+// Source of the entries of a matrix that is never stored, see polyvec_ntt_product_stream. In ML-KEM, entry writes
+// SampleNTT(XOF(rho || j || i)) to a : the XOF is not part of this library, the caller provides it.
+typedef struct {
+    void (*entry)(poly_t* a, const int i, const int j, void* arg);
+    void* arg;
+} polymat_stream_t;
+
+// Packed vector, see poly_packed_t. K*384 bytes instead of K*512.
+typedef struct {
+	poly_packed_t vec[KYBER_K];
+} polyvec_packed_t;
+
 /***********************/
 /* UTILITARY FUNCTIONS */
 /***********************/
@@ -58,6 +84,18 @@ void polyvec_sub(polyvec_t *r, const polyvec_t *a, const polyvec_t *b);
 
 void polyvec_transpose(polyvec_t** A);
 
+/************/
+/* MATRICES */
+/************/
+
+polymat_t* polymat_new(void);
+
+void polymat_secure_free(polymat_t** ptr);
+
+void polymat_ntt_product(polyvec_t* r, const polymat_t* A, const polyvec_t* v, const int transposed);
+
+void polyvec_ntt_product_stream(polyvec_t* r, const polymat_stream_t* A, const polyvec_t* v, const int transposed);
+
 /****************/
 /* BYTES ENCODE */
 /****************/
@@ -66,6 +104,8 @@ void polyvec_byte_encode(uint8_t* bytes, const polyvec_t* f, const unsigned d);
 
 void polyvec_byte_decode(polyvec_t* f, const uint8_t* bytes, const unsigned d);
 
+int polyvec_decode12_checked(polyvec_t* f, const uint8_t* bytes);
+
 /*********************************/
 /* COMPRESSION AND DECOMPRESSION */
 /******************************* */
@@ -74,4 +114,30 @@ void polyvec_compress(polyvec_t* f, const unsigned d);
 
 void polyvec_decompress(polyvec_t* f, const unsigned d);
 
+void polyvec_ntt_inv_add_compress(polyvec_t* r, polyvec_t* f, const polyvec_t* e, const unsigned d);
+
+/******************************/
+/* NTT-CACHED MULTIPLICATIONS */
+/******************************/
+
+void polyvec_ntt_cache_init(polyvec_ntt_cache_t* cache, const polyvec_t* a);
+
+polyvec_ntt_cache_t* polyvec_ntt_cache_new(const polyvec_t* a);
+
+void polyvec_ntt_cache_secure_free(polyvec_ntt_cache_t** ptr);
+
+void polyvec_scalar_product_cached(poly_t* r, const polyvec_ntt_cache_t* a, const polyvec_t* b);
+
+/******************/
+/* PACKED VECTORS */
+/******************/
+
+void polyvec_pack(polyvec_packed_t* r, const polyvec_t* f);
+
+void polyvec_unpack(polyvec_t* r, const polyvec_packed_t* f);
+
+void polyvec_ntt_scalar_product_packed(poly_t* r, const polyvec_packed_t* a, const polyvec_t* b);
+
+void polyvec_ntt_product_packed(polyvec_t* r, const polyvec_packed_t A[KYBER_K], const polyvec_t* v);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+/**
+ * @file randpool.h
+ * @brief Per-thread pool of OS randomness handing out the seeds d, z and m without a system call per operation
+ * @author Gabriel Abauzit
+ */
+
+#ifndef RANDPOOL_H
+#define RANDPOOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*****************************************************************************************************************/
+/* Each thread owns a buffer of RANDPOOL_BYTES filled by one getrandom call (/dev/urandom where it is missing).  */
+/* The bytes are erased from the buffer as they are handed out, so that a later memory disclosure does not give */
+/* back the seeds already used. A forked child and every thread after randpool_reseed refill before their next  */
+/* draw, the bytes buffered before are never handed out twice.                                                  */
+/*****************************************************************************************************************/
+
+// Size of the buffer of each thread, a refill every RANDPOOL_BYTES / RANDPOOL_SEED_BYTES seeds
+#ifndef RANDPOOL_BYTES
+	#define RANDPOOL_BYTES 4096
+#endif
+
+// Size of the seeds d, z and m of FIPS 203
+#define RANDPOOL_SEED_BYTES 32
+
+int randpool_bytes(uint8_t* out, const size_t len);
+
+int randpool_seed(uint8_t seed[RANDPOOL_SEED_BYTES]);
+
+void randpool_reseed(void);
+
+void randpool_deterministic(const uint8_t seed[RANDPOOL_SEED_BYTES]);
+
+uint64_t randpool_refills(void);
+
+#endif
@@ -50,4 +50,52 @@ static inline int16_t fqmul(int16_t a, int16_t b) {
     return montgomery_reduce((int32_t)a * b);
 }
 
-#endif
\ No newline at end of file
+/**********************/
+/* REDUCTION FAMILIES */
+/**********************/
+
+// The multiplications by the fixed zetas in the NTT and base case multiplication kernels of ntt.c use the family
+// selected by KYBER_REDUCE (make REDUCE=shoup or make REDUCE=plantard), with its own zeta tables. Every family returns
+// the same representative in [-(q-1)/2,(q-1)/2] as fqmul does, so the choice changes the speed and nothing else.
+#define KYBER_REDUCE_MONTGOMERY 0
+#define KYBER_REDUCE_SHOUP 1
+#define KYBER_REDUCE_PLANTARD 2
+
+#ifndef KYBER_REDUCE
+	#define KYBER_REDUCE KYBER_REDUCE_MONTGOMERY
+#endif
+
+/**
+ * @brief Shoup multiplication by a constant
+ * @details The quotient of a * w by q is estimated from the precomputed w_quot = round(w * 2^16 / q) with one high
+ *          product, a * w minus this quotient times q is in (-3q/4, 3q/4) and is brought back in range by barrett_reduce.
+ *
+ * @param int16_t a any 16-bit integer
+ * @param int16_t w constant in [-(q-1)/2,(q-1)/2], outside the Montgomery domain
+ * @param int16_t w_quot round(w * 2^16 / q)
+ * @return A 16-bit integer congruent to a * w (mod q) in [-(q-1)/2,(q-1)/2]
+ */
+static inline int16_t shoup_mul(int16_t a, int16_t w, int16_t w_quot) {
+    int16_t t;
+
+    t = ((int32_t)a * w_quot + (1 << 15)) >> 16;
+    return barrett_reduce(a * w - t * KYBER_Q);
+}
+
+/**
+ * @brief Plantard multiplication by a constant
+ * @details One 32-bit product by the precomputed w_plantard, and one 16-bit product by q on its high half. For the
+ *          constants of the zeta tables, the result is already in [-(q-1)/2,(q-1)/2] for every 16-bit a.
+ *
+ * @param int16_t a any 16-bit integer
+ * @param int32_t w_plantard (-2^32 * w mod q) * q^{-1} mod 2^32, for a constant w
+ * @return A 16-bit integer congruent to a * w (mod q)
+ */
+static inline int16_t plantard_mul(int16_t a, int32_t w_plantard) {
+    int32_t t;
+
+    t = (int32_t)((uint32_t)a * (uint32_t)w_plantard);
+    return (int16_t)((((t >> 16) + (1 << PLANTARD_ALPHA)) * KYBER_Q) >> 16);
+}
+
+#endif
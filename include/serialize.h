@@ -0,0 +1,61 @@
+/**
+ * @file serialize.h
+ * @brief Scatter-gather serialization of polynomials, vectors and ciphertexts
+ * @author Gabriel Abauzit
+ */
+
+#ifndef SERIALIZE_H
+#define SERIALIZE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/uio.h>
+#include "poly.h"
+#include "polyvec.h"
+#include "encode.h"
+
+// Size in bytes of the encodings
+#define POLY_BYTES(d) (32 * (d))
+#define POLYVEC_BYTES(d) (32 * (d) * KYBER_K)
+#define CIPHERTEXT_BYTES (POLYVEC_BYTES(KYBER_DU) + POLY_BYTES(KYBER_DV))
+
+// iov_cursor_t walks a list of non-contiguous segments as if they were a single byte array.
+// Encodings are written into (or read from) the segments in place, and may be split across any segment boundary.
+typedef struct {
+    const struct iovec* iov;
+    size_t iovcnt;
+    size_t index;  // current segment
+    size_t offset; // position inside the current segment
+} iov_cursor_t;
+
+/***********/
+/* CURSORS */
+/***********/
+
+void iov_cursor_init(iov_cursor_t* c, const struct iovec* iov, const size_t iovcnt);
+
+size_t iov_ring_window(struct iovec iov[2], uint8_t* base, const size_t capacity, const size_t start, const size_t length);
+
+size_t iov_cursor_remaining(const iov_cursor_t* c);
+
+int iov_cursor_write(iov_cursor_t* c, const uint8_t* src, size_t len);
+
+int iov_cursor_read(iov_cursor_t* c, uint8_t* dst, size_t len);
+
+/*************************/
+/* ENCODING AND DECODING */
+/*************************/
+
+int poly_byte_encode_iov(iov_cursor_t* c, const poly_t* f, const unsigned d);
+
+int poly_byte_decode_iov(poly_t* f, iov_cursor_t* c, const unsigned d);
+
+int polyvec_byte_encode_iov(iov_cursor_t* c, const polyvec_t* f, const unsigned d);
+
+int polyvec_byte_decode_iov(polyvec_t* f, iov_cursor_t* c, const unsigned d);
+
+int ciphertext_encode_iov(iov_cursor_t* c, const polyvec_t* u, const poly_t* v);
+
+int ciphertext_decode_iov(polyvec_t* u, poly_t* v, iov_cursor_t* c);
+
+#endif
@@ -0,0 +1,45 @@
+/**
+ * @file trace.h
+ * @brief Timeline tracing of the computation stages, written as a Chrome/Perfetto trace-event JSON file
+ * @author Gabriel Abauzit
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+/***************************************************************************************************************/
+/* The stages are delimited by TRACE_BEGIN / TRACE_END. Without KYBER_TRACE (make TRACE=1) they expand to      */
+/* nothing. With it, they cost one relaxed load while tracing is disabled, and one clock read and one store in */
+/* a buffer owned by the calling thread when it is enabled : no lock and no shared cache line on this path.    */
+/* trace_flush writes the events of all the threads, open the file in ui.perfetto.dev or chrome://tracing.     */
+/***************************************************************************************************************/
+
+// Number of events a thread can record until the next trace_reset, the next ones are dropped and counted
+#ifndef TRACE_BUFFER_EVENTS
+	#define TRACE_BUFFER_EVENTS 65536
+#endif
+
+extern atomic_int trace_enabled;
+
+#ifdef KYBER_TRACE
+#define TRACE_BEGIN(name) do { if (atomic_load_explicit(&trace_enabled, memory_order_relaxed)) trace_event((name), 'B'); } while (0)
+#define TRACE_END(name) do { if (atomic_load_explicit(&trace_enabled, memory_order_relaxed)) trace_event((name), 'E'); } while (0)
+#else
+#define TRACE_BEGIN(name) do { } while (0)
+#define TRACE_END(name) do { } while (0)
+#endif
+
+void trace_enable(const int enabled);
+
+void trace_event(const char* name, const char phase);
+
+int trace_flush(const char* path);
+
+uint64_t trace_dropped(void);
+
+void trace_reset(void);
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * @file vecext.h
+ * @brief Portable SIMD backend written with the GCC/Clang vector extensions
+ * @author Gabriel Abauzit
+ */
+
+#ifndef VECEXT_H
+#define VECEXT_H
+
+#include <stdint.h>
+#include "consts.h"
+#include "poly.h"
+
+/********************************************************************************************************/
+/* The kernels below work on vectors of 8 int16_t lanes and are written once, the compiler lowers them  */
+/* to SSE2/AVX2/NEON/... depending on the target. They compute exactly the same values as the scalar    */
+/* reference of reduce.h, ntt.c, poly.c and encode.c.                                                    */
+/********************************************************************************************************/
+
+#if defined(__GNUC__) || defined(__clang__)
+#define VECEXT_AVAILABLE 1
+#endif
+
+#ifdef VECEXT_AVAILABLE
+
+// 16-byte vectors : wider ones are split in two without -mavx anyway, and passing them to the helpers below would
+// depend on the target ABI (-Wpsabi)
+#define VECEXT_LANES 8
+
+typedef int16_t vec16_t __attribute__((vector_size(2 * VECEXT_LANES)));
+typedef uint16_t vecu16_t __attribute__((vector_size(2 * VECEXT_LANES)));
+typedef int32_t vec32_t __attribute__((vector_size(4 * VECEXT_LANES)));
+typedef uint32_t vecu32_t __attribute__((vector_size(4 * VECEXT_LANES)));
+typedef uint64_t vecu64_t __attribute__((vector_size(8 * VECEXT_LANES)));
+
+/**
+ * @brief Lane-wise barrett_reduce
+ */
+static inline vec16_t barrett_reduce_vec(vec16_t a) {
+    vec32_t a32 = __builtin_convertvector(a, vec32_t);
+    vec32_t t;
+
+    t = (a32 * BARRETT_FACTOR + (1 << 25)) >> 26;
+    t *= KYBER_Q;
+    return __builtin_convertvector(a32 - t, vec16_t);
+}
+
+/**
+ * @brief Lane-wise montgomery_reduce of the 32-bit values hi * 2^16 + lo
+ * @details t * q has the same low half as the input, so the high half of their difference is hi minus the one of t * q.
+ */
+static inline vec16_t montgomery_reduce_vec(vec16_t lo, vec16_t hi) {
+    vec32_t t;
+
+    t = __builtin_convertvector((vec16_t)((vecu16_t)lo * MONTGOMERY_QINV), vec32_t);
+    t = __builtin_convertvector(hi, vec32_t) - ((t * KYBER_Q) >> 16);
+    return barrett_reduce_vec(__builtin_convertvector(t, vec16_t));
+}
+
+/**
+ * @brief Lane-wise fqmul
+ */
+static inline vec16_t fqmul_vec(vec16_t a, vec16_t b) {
+    vec32_t p = __builtin_convertvector(a, vec32_t) * __builtin_convertvector(b, vec32_t);
+
+    return montgomery_reduce_vec(__builtin_convertvector(p, vec16_t), __builtin_convertvector(p >> 16, vec16_t));
+}
+
+/*******/
+/* NTT */
+/*******/
+
+void NTT_vecext(int16_t tab[256]);
+
+void NTT_inv_vecext(int16_t tab[256]);
+
+void NTT_inv_scaled_vecext(int16_t tab[256], const int16_t factor);
+
+void NTT_multiply_vecext(int16_t r[256], const int16_t a[256], const int16_t b[256]);
+
+/********************************/
+/* ARITHMETIC OPERATIONS IN R_q */
+/********************************/
+
+void poly_add_vecext(poly_t* r, const poly_t* a, const poly_t* b);
+
+void poly_sub_vecext(poly_t* r, const poly_t* a, const poly_t* b);
+
+/***************/
+/* COMPRESSION */
+/***************/
+
+void poly_compress_vecext(poly_t* f, const unsigned d);
+
+#endif
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * @file ct.c
+ * @brief Constant time comparison, conditional move and erasure of byte arrays, for the implicit rejection of
+ *        decapsulation and the secrets left in memory
+ * @author Gabriel Abauzit
+ */
+
+#include <string.h>
+#include "ct.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CT_VECEXT 1
+// A block is two vectors of 16 bytes : wider GCC vectors are split and spilled to the stack without -mavx
+typedef uint64_t ct_vec_t __attribute__((vector_size(CT_BLOCK_BYTES / 2)));
+#endif
+
+/**
+ * @brief Hides x from the optimizer, so that a mask derived from a secret bit is not turned back into a branch
+ */
+static inline uint64_t ct_barrier(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    __asm__ volatile("" : "+r"(x));
+#endif
+    return x;
+}
+
+/**
+ * @brief Accumulates the differences between a and b
+ * @details Start with acc = 0 and feed it back for each piece, a and b are equal on all the pieces iff the final value
+ *          is 0. The pieces may have any length, the loads are unaligned.
+ *
+ * @param[in] acc value returned for the previous pieces, or 0
+ * @param[in] a
+ * @param[in] b
+ * @param[in] len
+ * @return acc, with a bit set for each bit position where a and b differ in this piece
+ */
+uint64_t ct_diff(uint64_t acc, const uint8_t* a, const uint8_t* b, const size_t len) {
+    size_t i = 0;
+    uint64_t x, y;
+#ifdef CT_VECEXT
+    ct_vec_t va0, vb0, va1, vb1, d0 = {0}, d1 = {0};
+
+    for (; i + CT_BLOCK_BYTES <= len; i += CT_BLOCK_BYTES) {
+        memcpy(&va0, a + i, sizeof(ct_vec_t));
+        memcpy(&vb0, b + i, sizeof(ct_vec_t));
+        memcpy(&va1, a + i + sizeof(ct_vec_t), sizeof(ct_vec_t));
+        memcpy(&vb1, b + i + sizeof(ct_vec_t), sizeof(ct_vec_t));
+        d0 |= va0 ^ vb0;
+        d1 |= va1 ^ vb1;
+    }
+    d0 |= d1;
+    acc |= d0[0] | d0[1];
+#endif
+
+    for (; i + 8 <= len; i += 8) {
+        memcpy(&x, a + i, 8);
+        memcpy(&y, b + i, 8);
+        acc |= x ^ y;
+    }
+    for (; i < len; i++) {
+        acc |= (uint64_t)(a[i] ^ b[i]);
+    }
+    return acc;
+}
+
+/**
+ * @brief Turns the result of ct_diff into a bit
+ * @return 0 if acc is 0, 1 otherwise
+ */
+uint8_t ct_nonzero(const uint64_t acc) {
+    return (uint8_t)((acc | (0 - acc)) >> 63);
+}
+
+/**
+ * @brief Constant time comparison
+ * @return 0 if a and b are equal, 1 otherwise
+ */
+uint8_t ct_differ(const uint8_t* a, const uint8_t* b, const size_t len) {
+    return ct_nonzero(ct_diff(0, a, b, len));
+}
+
+/**
+ * @brief Constant time copy of x to r if b is 1, r is left unchanged if b is 0
+ * @param[in] b 0 or 1, e.g. the result of ct_differ
+ */
+void ct_cmov(uint8_t* r, const uint8_t* x, const size_t len, const uint8_t b) {
+    const uint64_t mask = ct_barrier(0 - (uint64_t)(b & 1));
+    size_t i = 0;
+    uint64_t u, v;
+#ifdef CT_VECEXT
+    const ct_vec_t vmask = (ct_vec_t){0} + mask;
+    ct_vec_t vr, vx;
+
+    for (; i + sizeof(ct_vec_t) <= len; i += sizeof(ct_vec_t)) {
+        memcpy(&vr, r + i, sizeof(ct_vec_t));
+        memcpy(&vx, x + i, sizeof(ct_vec_t));
+        vr ^= vmask & (vr ^ vx);
+        memcpy(r + i, &vr, sizeof(ct_vec_t));
+    }
+#endif
+
+    for (; i + 8 <= len; i += 8) {
+        memcpy(&u, r + i, 8);
+        memcpy(&v, x + i, 8);
+        u ^= mask & (u ^ v);
+        memcpy(r + i, &u, 8);
+    }
+    for (; i < len; i++) {
+        r[i] ^= (uint8_t)mask & (r[i] ^ x[i]);
+    }
+}
+
+/**
+ * @brief Erases a memory area, the writes are not optimized out
+ */
+void ct_zero(void* ptr, const size_t len) {
+    volatile uint8_t* p = (volatile uint8_t*)ptr;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        p[i] = 0;
+    }
+}
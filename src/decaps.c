@@ -0,0 +1,153 @@
+/**
+ * @file decaps.c
+ * @brief Decapsulation of batches of ciphertexts under the same prepared key
+ * @author Gabriel Abauzit
+ */
+
+#include "decaps.h"
+#include "ct.h"
+#include "trace.h"
+
+// Everything a ciphertext of the batch goes through. Once consumed, u and v are reused for the re-encryption.
+typedef struct {
+    polyvec_t u;                          // u in the NTT domain, then u' of the re-encryption
+    poly_t v;                             // Decompress(v), then v' of the re-encryption
+    poly_t w;                             // s^T u, then Decompress_1(m')
+    polyvec_t r_hat;
+    polyvec_t e1;
+    poly_t e2;
+    uint8_t m[KYBER_N / 8];
+    uint8_t K[DECAPS_KEY_BYTES];
+    uint8_t K_bar[DECAPS_KEY_BYTES];
+    uint64_t diff;                        // differences between the re-encryption of m' and the ciphertext
+} decaps_lane_t;
+
+/**
+ * @brief Decapsulates the ciphertexts of lanes[0..count-1], see kem_dec_many
+ * @details Each stage runs on every lane before the next one starts. The loops over the key are outside the loops
+ *          over the lanes, so that each entry of s, A and t is loaded once for the whole batch.
+ */
+static void decaps_batch(decaps_lane_t* lanes, const size_t count, const prepared_key_t* dk, const decaps_primitives_t* prim, const uint8_t (*cts)[CIPHERTEXT_BYTES], uint8_t (*keys)[DECAPS_KEY_BYTES]) {
+    size_t b;
+    int i, j;
+    poly_t temp, entry;
+    uint8_t chunk[32 * KYBER_DU];
+
+    // K-PKE.Decrypt
+
+    TRACE_BEGIN("decaps_decode");
+    for (b = 0; b < count; b++) {
+        polyvec_byte_decode(&lanes[b].u, cts[b], KYBER_DU);
+        polyvec_decompress(&lanes[b].u, KYBER_DU);
+        polyvec_ntt(&lanes[b].u);
+        byte_decode(lanes[b].v.coeffs, cts[b] + POLYVEC_BYTES(KYBER_DU), KYBER_DV);
+        poly_decompress(&lanes[b].v, KYBER_DV);
+        poly_zero(&lanes[b].w);
+    }
+    TRACE_END("decaps_decode");
+
+    TRACE_BEGIN("decaps_secret_product");
+    for (i = 0; i < KYBER_K; i++) {
+        for (b = 0; b < count; b++) {
+            NTT_multiply_cached(temp.coeffs, dk->s_hat.vec[i].hat.coeffs, dk->s_hat.vec[i].mulcache, lanes[b].u.vec[i].coeffs);
+            poly_add_noreduce(&lanes[b].w, &lanes[b].w, &temp);
+        }
+    }
+    for (b = 0; b < count; b++) {
+        POLY_ASSERT_BOUND(&lanes[b].w, POLY_BOUND_NTT_INV);
+        NTT_inv_scaled(lanes[b].w.coeffs, NTT_INV_FACTOR_R1);
+        poly_sub(&lanes[b].w, &lanes[b].v, &lanes[b].w);
+        poly_tomsg(lanes[b].m, &lanes[b].w);
+    }
+    TRACE_END("decaps_secret_product");
+
+    // K-PKE.Encrypt of m' with the randomness derived from it
+
+    for (b = 0; b < count; b++) {
+        prim->derive(lanes[b].K, &lanes[b].r_hat, &lanes[b].e1, &lanes[b].e2, lanes[b].m, dk->fingerprint, prim->arg);
+        polyvec_ntt(&lanes[b].r_hat);
+        polyvec_zero(&lanes[b].u);
+        poly_zero(&lanes[b].v);
+    }
+
+    TRACE_BEGIN("decaps_reencrypt");
+    for (i = 0; i < KYBER_K; i++) {
+        for (j = 0; j < KYBER_K; j++) {
+            // Entry (i,j) of A^T
+            for (b = 0; b < count; b++) {
+                NTT_multiply(temp.coeffs, dk->A.row[j].vec[i].coeffs, lanes[b].r_hat.vec[j].coeffs);
+                poly_add_noreduce(&lanes[b].u.vec[i], &lanes[b].u.vec[i], &temp);
+            }
+        }
+        poly_unpack(&entry, &dk->t_hat.vec[i]);
+        for (b = 0; b < count; b++) {
+            NTT_multiply(temp.coeffs, entry.coeffs, lanes[b].r_hat.vec[i].coeffs);
+            poly_add_noreduce(&lanes[b].v, &lanes[b].v, &temp);
+        }
+    }
+    for (b = 0; b < count; b++) {
+        for (i = 0; i < KYBER_K; i++) {
+            POLY_ASSERT_BOUND(&lanes[b].u.vec[i], POLY_BOUND_NTT_INV);
+        }
+        POLY_ASSERT_BOUND(&lanes[b].v, POLY_BOUND_NTT_INV);
+        polyvec_ntt_inv_add_compress(&lanes[b].u, &lanes[b].u, &lanes[b].e1, KYBER_DU);
+        poly_frommsg_bits(&lanes[b].w, lanes[b].m);
+        poly_ntt_inv_add_compress(&lanes[b].v, &lanes[b].v, &lanes[b].e2, &lanes[b].w, KYBER_DV);
+        // Each encoded entry is compared with the ciphertext while it is still in the cache
+        lanes[b].diff = 0;
+        for (i = 0; i < KYBER_K; i++) {
+            byte_encode(chunk, lanes[b].u.vec[i].coeffs, KYBER_DU);
+            lanes[b].diff = ct_diff(lanes[b].diff, chunk, cts[b] + 32*KYBER_DU*i, 32*KYBER_DU);
+        }
+        byte_encode(chunk, lanes[b].v.coeffs, KYBER_DV);
+        lanes[b].diff = ct_diff(lanes[b].diff, chunk, cts[b] + POLYVEC_BYTES(KYBER_DU), 32*KYBER_DV);
+    }
+    TRACE_END("decaps_reencrypt");
+
+    // Implicit rejection, every lane computes K_bar and selects without branching
+
+    for (b = 0; b < count; b++) {
+        prim->reject(lanes[b].K_bar, cts[b], prim->arg);
+        ct_cmov(lanes[b].K, lanes[b].K_bar, DECAPS_KEY_BYTES, ct_nonzero(lanes[b].diff));
+        memcpy(keys[b], lanes[b].K, DECAPS_KEY_BYTES);
+    }
+
+    ct_zero(&temp, sizeof(temp));
+    ct_zero(chunk, sizeof(chunk));
+}
+
+/**
+ * @brief ML-KEM.Decaps (FIPS 203 Algorithm 18) of n ciphertexts under the same key
+ * @details The ciphertexts go through decryption and re-encryption by groups of DECAPS_BATCH, which shares the loads
+ *          of the key between them. Each ciphertext gets its own implicit rejection : keys[i] is K if cts[i] is a valid
+ *          encapsulation, J(z || cts[i]) otherwise, and nothing else depends on its validity.
+ *
+ * @param[in] dk prepared key, H(ek) being its fingerprint
+ * @param[in] prim hash functions and samplers
+ * @param[in] n number of ciphertexts
+ * @param[in] cts n ciphertexts
+ * @param[out] keys n shared secrets, keys[i] is the one of cts[i]
+ */
+void kem_dec_many(const prepared_key_t* dk, const decaps_primitives_t* prim, const size_t n, const uint8_t (*cts)[CIPHERTEXT_BYTES], uint8_t (*keys)[DECAPS_KEY_BYTES]) {
+    decaps_lane_t lanes[DECAPS_BATCH];
+    size_t i, count;
+
+    TRACE_BEGIN("kem_dec_many");
+
+    for (i = 0; i < n; i += count) {
+        count = n - i < DECAPS_BATCH ? n - i : DECAPS_BATCH;
+        decaps_batch(lanes, count, dk, prim, cts + i, keys + i);
+    }
+
+    // m', K, r and the noise are secret
+    ct_zero(lanes, sizeof(lanes));
+
+    TRACE_END("kem_dec_many");
+}
+
+/**
+ * @brief ML-KEM.Decaps of a single ciphertext, see kem_dec_many
+ */
+void kem_dec(const prepared_key_t* dk, const decaps_primitives_t* prim, const uint8_t ct[CIPHERTEXT_BYTES], uint8_t key[DECAPS_KEY_BYTES]) {
+    kem_dec_many(dk, prim, 1, (const uint8_t (*)[CIPHERTEXT_BYTES])ct, (uint8_t (*)[DECAPS_KEY_BYTES])key);
+}
@@ -0,0 +1,509 @@
+/**
+ * @file dispatch.c
+ * @brief Dispatch table of the hot kernels, and the startup autotuner that fills it
+ * @author Gabriel Abauzit
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "dispatch.h"
+#include "ntt.h"
+#include "encode.h"
+#include "vecext.h"
+#include "poly_avx2.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#define DISPATCH_CPUID 1
+#endif
+
+// Number of calls timed together by dispatch_autotune, the best of the batches is kept
+#define DISPATCH_BATCH 4
+
+typedef struct {
+    const char* name;
+    void (*fn)(void);                     // cast back to the type of its entry in dispatch_table before being called
+    int (*supported)(void);               // NULL if the variant runs on any host
+} dispatch_variant_t;
+
+typedef struct {
+    const char* name;
+    const char* default_variant;          // entry of dispatch_table before any tuning, see dispatch_reset
+    void (*default_fn)(void);
+    const dispatch_variant_t* variants;   // the first one is the reference the others are checked against
+    size_t count;
+} dispatch_kernel_info_t;
+
+/**
+ * @brief byte_encode of a whole polynomial by blocks of 8 coefficients
+ */
+static void byte_encode_by_blocks(uint8_t* bytes, const int16_t* F, const unsigned d) {
+    byte_encode_blocks_scalar(bytes, F, d, KYBER_N / 8);
+}
+
+/**
+ * @brief byte_decode of a whole polynomial by blocks of 8 coefficients
+ */
+static void byte_decode_by_blocks(int16_t* F, const uint8_t* bytes, const unsigned d) {
+    byte_decode_blocks_scalar(F, bytes, d, KYBER_N / 8);
+}
+
+#define DISPATCH_FN(f) ((void (*)(void))(f))
+
+static const dispatch_variant_t dispatch_ntt_variants[] = {
+    {"ref", DISPATCH_FN(NTT_ref), NULL},
+#ifdef VECEXT_AVAILABLE
+    {"vecext", DISPATCH_FN(NTT_vecext), NULL},
+#endif
+};
+
+static const dispatch_variant_t dispatch_ntt_inv_variants[] = {
+    {"ref", DISPATCH_FN(NTT_inv_scaled_ref), NULL},
+#ifdef VECEXT_AVAILABLE
+    {"vecext", DISPATCH_FN(NTT_inv_scaled_vecext), NULL},
+#endif
+};
+
+static const dispatch_variant_t dispatch_ntt_multiply_variants[] = {
+    {"ref", DISPATCH_FN(NTT_multiply_ref), NULL},
+#ifdef VECEXT_AVAILABLE
+    {"vecext", DISPATCH_FN(NTT_multiply_vecext), NULL},
+#endif
+};
+
+static const dispatch_variant_t dispatch_byte_encode_variants[] = {
+    {"ref", DISPATCH_FN(byte_encode_ref), NULL},
+    {"blocks", DISPATCH_FN(byte_encode_by_blocks), NULL},
+#ifdef ENCODE_BMI2_AVAILABLE
+    {"bmi2", DISPATCH_FN(byte_encode_bmi2), encode_bmi2_supported},
+#endif
+};
+
+static const dispatch_variant_t dispatch_byte_decode_variants[] = {
+    {"ref", DISPATCH_FN(byte_decode_ref), NULL},
+    {"blocks", DISPATCH_FN(byte_decode_by_blocks), NULL},
+#ifdef ENCODE_BMI2_AVAILABLE
+    {"bmi2", DISPATCH_FN(byte_decode_bmi2), encode_bmi2_supported},
+#endif
+};
+
+static const dispatch_variant_t dispatch_compress_variants[] = {
+    {"ref", DISPATCH_FN(poly_compress_ref), NULL},
+#ifdef VECEXT_AVAILABLE
+    {"vecext", DISPATCH_FN(poly_compress_vecext), NULL},
+#endif
+#ifdef POLY_AVX2_AVAILABLE
+    {"avx2", DISPATCH_FN(poly_compress_avx2), poly_avx2_supported},
+#endif
+};
+
+#define DISPATCH_COUNT(v) (sizeof(v) / sizeof(v[0]))
+
+static const dispatch_kernel_info_t dispatch_kernels[DISPATCH_KERNELS] = {
+    {"ntt", "ref", DISPATCH_FN(NTT_ref), dispatch_ntt_variants, DISPATCH_COUNT(dispatch_ntt_variants)},
+    {"ntt_inv", "ref", DISPATCH_FN(NTT_inv_scaled_ref), dispatch_ntt_inv_variants, DISPATCH_COUNT(dispatch_ntt_inv_variants)},
+    {"ntt_multiply", "ref", DISPATCH_FN(NTT_multiply_ref), dispatch_ntt_multiply_variants, DISPATCH_COUNT(dispatch_ntt_multiply_variants)},
+    {"byte_encode", "default", DISPATCH_FN(byte_encode_default), dispatch_byte_encode_variants, DISPATCH_COUNT(dispatch_byte_encode_variants)},
+    {"byte_decode", "default", DISPATCH_FN(byte_decode_default), dispatch_byte_decode_variants, DISPATCH_COUNT(dispatch_byte_decode_variants)},
+    {"compress", "ref", DISPATCH_FN(poly_compress_ref), dispatch_compress_variants, DISPATCH_COUNT(dispatch_compress_variants)},
+};
+
+dispatch_table_t dispatch_table = {NTT_ref, NTT_inv_scaled_ref, NTT_multiply_ref, byte_encode_default, byte_decode_default, poly_compress_ref};
+
+static const char* dispatch_current[DISPATCH_KERNELS] = {"ref", "ref", "ref", "default", "default", "ref"};
+
+/**
+ * @brief Writes fn in the entry of kernel in dispatch_table
+ */
+static void dispatch_install(const dispatch_kernel_t kernel, void (*fn)(void), const char* name) {
+    switch (kernel) {
+        case DISPATCH_NTT: dispatch_table.ntt = (void (*)(int16_t*))fn; break;
+        case DISPATCH_NTT_INV: dispatch_table.ntt_inv_scaled = (void (*)(int16_t*, const int16_t))fn; break;
+        case DISPATCH_NTT_MULTIPLY: dispatch_table.ntt_multiply = (void (*)(int16_t*, const int16_t*, const int16_t*))fn; break;
+        case DISPATCH_BYTE_ENCODE: dispatch_table.byte_encode = (void (*)(uint8_t*, const int16_t*, const unsigned))fn; break;
+        case DISPATCH_BYTE_DECODE: dispatch_table.byte_decode = (void (*)(int16_t*, const uint8_t*, const unsigned))fn; break;
+        case DISPATCH_COMPRESS: dispatch_table.poly_compress = (void (*)(poly_t*, const unsigned))fn; break;
+        default: return;
+    }
+    dispatch_current[kernel] = name;
+}
+
+/**
+ * @brief Variant of kernel called name, if it runs on this host
+ * @return NULL if there is no such variant
+ */
+static const dispatch_variant_t* dispatch_find(const dispatch_kernel_t kernel, const char* name) {
+    const dispatch_kernel_info_t* info = &dispatch_kernels[kernel];
+    size_t i;
+
+    for (i = 0; i < info->count; i++) {
+        if (strcmp(info->variants[i].name, name) == 0) {
+            if (info->variants[i].supported != NULL && !info->variants[i].supported()) return NULL;
+            return &info->variants[i];
+        }
+    }
+    return NULL;
+}
+
+/*********/
+/* TABLE */
+/*********/
+
+/**
+ * @brief Name of a kernel, as written in the cache file
+ */
+const char* dispatch_kernel_name(const dispatch_kernel_t kernel) {
+    return kernel < DISPATCH_KERNELS ? dispatch_kernels[kernel].name : NULL;
+}
+
+/**
+ * @brief Lists the variants of a kernel that run on this host
+ *
+ * @param[in] kernel
+ * @param[out] names the names of the first max variants, the first one being the reference
+ * @param[in] max
+ * @return the number of variants that run on this host, possibly more than max
+ */
+size_t dispatch_variants(const dispatch_kernel_t kernel, const char* names[], const size_t max) {
+    const dispatch_kernel_info_t* info;
+    size_t i, n = 0;
+
+    if (kernel >= DISPATCH_KERNELS) return 0;
+    info = &dispatch_kernels[kernel];
+
+    for (i = 0; i < info->count; i++) {
+        if (info->variants[i].supported != NULL && !info->variants[i].supported()) continue;
+        if (n < max) names[n] = info->variants[i].name;
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief Name of the variant of a kernel that is currently installed
+ */
+const char* dispatch_selected(const dispatch_kernel_t kernel) {
+    return kernel < DISPATCH_KERNELS ? dispatch_current[kernel] : NULL;
+}
+
+/**
+ * @brief Installs a given variant of a kernel
+ * @return 0 on success, 1 if the variant does not exist or does not run on this host, the table is then unchanged
+ */
+int dispatch_select(const dispatch_kernel_t kernel, const char* variant) {
+    const dispatch_variant_t* v;
+
+    if (kernel >= DISPATCH_KERNELS || variant == NULL) return EXIT_FAILURE;
+    v = dispatch_find(kernel, variant);
+    if (v == NULL) return EXIT_FAILURE;
+
+    dispatch_install(kernel, v->fn, v->name);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Puts back the entries the table has before any tuning
+ */
+void dispatch_reset(void) {
+    int k;
+
+    for (k = 0; k < DISPATCH_KERNELS; k++) {
+        dispatch_install((dispatch_kernel_t)k, dispatch_kernels[k].default_fn, dispatch_kernels[k].default_variant);
+    }
+}
+
+/**************/
+/* AUTOTUNING */
+/**************/
+
+static const unsigned dispatch_encode_d[] = {1, KYBER_DV, KYBER_DU, 12};
+static const unsigned dispatch_compress_d[] = {KYBER_DU, KYBER_DV};
+
+#define DISPATCH_ENCODE_D (sizeof(dispatch_encode_d) / sizeof(dispatch_encode_d[0]))
+#define DISPATCH_COMPRESS_D (sizeof(dispatch_compress_d) / sizeof(dispatch_compress_d[0]))
+
+// Inputs and outputs of the timed calls, the encodings and the compression write one output per parameter d
+typedef struct {
+    int16_t a[KYBER_N];
+    int16_t b[KYBER_N];
+    int16_t r[KYBER_N];
+    uint8_t bytes[KYBER_N * 12 / 8];
+    poly_t f;
+    uint8_t encoded[DISPATCH_ENCODE_D][KYBER_N * 12 / 8];
+    int16_t decoded[DISPATCH_ENCODE_D][KYBER_N];
+    int16_t compressed[DISPATCH_COMPRESS_D][KYBER_N];
+} dispatch_scratch_t;
+
+static uint64_t dispatch_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Fills the inputs with canonical coefficients, and bytes that decode to such coefficients
+ */
+static void dispatch_scratch_init(dispatch_scratch_t* s) {
+    uint32_t x = 0x12345678;
+    int i;
+
+    for (i = 0; i < KYBER_N; i++) {
+        x = x * 1664525 + 1013904223;
+        s->a[i] = (int16_t)((x >> 8) % KYBER_Q);
+        s->b[i] = (int16_t)((x >> 20) % KYBER_Q);
+        s->f.coeffs[i] = s->a[i];
+    }
+    byte_encode_ref(s->bytes, s->a, 12);
+}
+
+/**
+ * @brief One call of a variant of kernel, on every compression parameter for the encodings and the compression
+ */
+static void dispatch_call(const dispatch_kernel_t kernel, void (*fn)(void), dispatch_scratch_t* s) {
+    size_t i;
+    int j;
+
+    switch (kernel) {
+        case DISPATCH_NTT:
+            ((void (*)(int16_t*))fn)(s->r);
+            break;
+        case DISPATCH_NTT_INV:
+            ((void (*)(int16_t*, const int16_t))fn)(s->r, NTT_INV_FACTOR_R1);
+            break;
+        case DISPATCH_NTT_MULTIPLY:
+            ((void (*)(int16_t*, const int16_t*, const int16_t*))fn)(s->r, s->a, s->b);
+            break;
+        case DISPATCH_BYTE_ENCODE:
+            // Masking to d bits keeps the coefficients in range for every d
+            for (i = 0; i < DISPATCH_ENCODE_D; i++) {
+                for (j = 0; j < KYBER_N; j++) {
+                    s->b[j] = (int16_t)(s->r[j] & ((1 << dispatch_encode_d[i]) - 1));
+                }
+                ((void (*)(uint8_t*, const int16_t*, const unsigned))fn)(s->encoded[i], s->b, dispatch_encode_d[i]);
+            }
+            break;
+        case DISPATCH_BYTE_DECODE:
+            for (i = 0; i < DISPATCH_ENCODE_D; i++) {
+                ((void (*)(int16_t*, const uint8_t*, const unsigned))fn)(s->decoded[i], s->bytes, dispatch_encode_d[i]);
+            }
+            break;
+        case DISPATCH_COMPRESS:
+            for (i = 0; i < DISPATCH_COMPRESS_D; i++) {
+                memcpy(s->f.coeffs, s->a, sizeof(s->a));
+                ((void (*)(poly_t*, const unsigned))fn)(&s->f, dispatch_compress_d[i]);
+                memcpy(s->compressed[i], s->f.coeffs, sizeof(s->f.coeffs));
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Runs a variant from fixed inputs, r starting as a copy of a and the encoded bytes being those of a
+ * @details The outputs are cleared first, so that the bytes a variant does not write compare equal.
+ */
+static void dispatch_output(const dispatch_kernel_t kernel, void (*fn)(void), dispatch_scratch_t* s) {
+    memset(s, 0, sizeof(dispatch_scratch_t));
+    dispatch_scratch_init(s);
+    memcpy(s->r, s->a, sizeof(s->a));
+    dispatch_call(kernel, fn, s);
+}
+
+/**
+ * @brief Checks that a function gives the same output as the reference of a kernel
+ * @details Every output is compared : r for the NTTs and the multiplication, and the output of each parameter d for
+ *          the encodings and the compression.
+ *
+ * @param[in] kernel
+ * @param[in] fn function of the type of the entry of kernel in dispatch_table, cast to void (*)(void)
+ * @return 0 if it does, 1 otherwise
+ */
+int dispatch_check(const dispatch_kernel_t kernel, void (*fn)(void)) {
+    dispatch_scratch_t expected, got;
+
+    if (kernel >= DISPATCH_KERNELS || fn == NULL) return EXIT_FAILURE;
+    dispatch_output(kernel, dispatch_kernels[kernel].variants[0].fn, &expected);
+    dispatch_output(kernel, fn, &got);
+
+    return memcmp(&expected, &got, sizeof(dispatch_scratch_t)) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Best time of DISPATCH_BATCH calls of a variant, measured for about budget_ns
+ */
+static uint64_t dispatch_time(const dispatch_kernel_t kernel, const dispatch_variant_t* v, const uint64_t budget_ns, dispatch_scratch_t* s) {
+    uint64_t start = dispatch_now_ns(), t0, t1, best = UINT64_MAX;
+    int i;
+
+    dispatch_scratch_init(s);
+    memcpy(s->r, s->a, sizeof(s->a));
+    dispatch_call(kernel, v->fn, s); // warm-up
+
+    do {
+        t0 = dispatch_now_ns();
+        for (i = 0; i < DISPATCH_BATCH; i++) {
+            dispatch_call(kernel, v->fn, s);
+        }
+        t1 = dispatch_now_ns();
+        if (t1 - t0 < best) best = t1 - t0;
+    } while (t1 - start < budget_ns);
+
+    return best;
+}
+
+/**
+ * @brief Times the variants of every kernel that run on this host and give the reference output, installs the fastest
+ */
+static void dispatch_tune(void) {
+    dispatch_scratch_t s;
+    const dispatch_kernel_info_t* info;
+    const dispatch_variant_t* v;
+    const dispatch_variant_t* best;
+    uint64_t t, best_t, budget;
+    const char* names[8];
+    size_t i;
+    int k;
+
+    for (k = 0; k < DISPATCH_KERNELS; k++) {
+        info = &dispatch_kernels[k];
+        budget = DISPATCH_TUNE_NS / dispatch_variants((dispatch_kernel_t)k, names, 0);
+        best = &info->variants[0];
+        best_t = UINT64_MAX;
+
+        for (i = 0; i < info->count; i++) {
+            v = &info->variants[i];
+            if (dispatch_find((dispatch_kernel_t)k, v->name) == NULL) continue;
+            if (i > 0 && dispatch_check((dispatch_kernel_t)k, v->fn) == EXIT_FAILURE) continue;
+
+            t = dispatch_time((dispatch_kernel_t)k, v, budget, &s);
+            if (t < best_t) {
+                best_t = t;
+                best = v;
+            }
+        }
+
+        dispatch_install((dispatch_kernel_t)k, best->fn, best->name);
+    }
+}
+
+/**************/
+/* CACHE FILE */
+/**************/
+
+/**
+ * @brief First line of the cache file : the choice is only reused on the same CPU model and library build
+ */
+static void dispatch_cache_header(char* buf, const size_t len) {
+#ifdef DISPATCH_CPUID
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    unsigned sig = 0, features = 0, ext = 0;
+    char vendor[13] = {0};
+
+    if (__get_cpuid(0, &eax, &ebx, &ecx, &edx)) {
+        memcpy(vendor, &ebx, 4);
+        memcpy(vendor + 4, &edx, 4);
+        memcpy(vendor + 8, &ecx, 4);
+    }
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        sig = eax;
+        features = ecx;
+    }
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        ext = ebx;
+    }
+    snprintf(buf, len, "kyber-dispatch %d %s-%08x-%08x-%08x reduce-%d\n", DISPATCH_CACHE_VERSION, vendor[0] ? vendor : "unknown", sig, features, ext, KYBER_REDUCE);
+#else
+    snprintf(buf, len, "kyber-dispatch %d generic reduce-%d\n", DISPATCH_CACHE_VERSION, KYBER_REDUCE);
+#endif
+}
+
+/**
+ * @brief Installs the variants saved in a cache file, if it was written on this host for every kernel
+ * @return 0 if they were installed, 1 otherwise and the table is unchanged
+ */
+static int dispatch_cache_load(const char* path) {
+    FILE* f = fopen(path, "r");
+    char header[128], line[128], kernel[32], variant[32];
+    const dispatch_variant_t* chosen[DISPATCH_KERNELS] = {NULL};
+    int k;
+
+    if (f == NULL) return EXIT_FAILURE;
+
+    dispatch_cache_header(header, sizeof(header));
+    if (fgets(line, sizeof(line), f) == NULL || strcmp(line, header) != 0) {
+        fclose(f);
+        return EXIT_FAILURE;
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (sscanf(line, "%31s %31s", kernel, variant) != 2) break;
+        for (k = 0; k < DISPATCH_KERNELS && strcmp(dispatch_kernels[k].name, kernel) != 0; k++);
+        if (k == DISPATCH_KERNELS) break;
+        chosen[k] = dispatch_find((dispatch_kernel_t)k, variant);
+    }
+    fclose(f);
+
+    for (k = 0; k < DISPATCH_KERNELS; k++) {
+        if (chosen[k] == NULL) return EXIT_FAILURE;
+    }
+    for (k = 0; k < DISPATCH_KERNELS; k++) {
+        dispatch_install((dispatch_kernel_t)k, chosen[k]->fn, chosen[k]->name);
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Saves the variants currently installed
+ * @details The file is written next to path under a unique name then renamed, so that a concurrent startup never reads
+ *          it half written and two processes saving at once never write the same file.
+ * @return 0 on success, 1 if the file could not be written
+ */
+static int dispatch_cache_save(const char* path) {
+    char header[128], tmp_path[4096];
+    FILE* f;
+    int fd, k, status = EXIT_SUCCESS;
+
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.XXXXXX", path) >= (int)sizeof(tmp_path)) return EXIT_FAILURE;
+    fd = mkstemp(tmp_path);
+    if (fd < 0) return EXIT_FAILURE;
+    // mkstemp creates the file for its owner only, the cache is readable by every user as before
+    f = fchmod(fd, 0644) == 0 ? fdopen(fd, "w") : NULL;
+    if (f == NULL) {
+        close(fd);
+        remove(tmp_path);
+        return EXIT_FAILURE;
+    }
+
+    dispatch_cache_header(header, sizeof(header));
+    if (fputs(header, f) < 0) status = EXIT_FAILURE;
+    for (k = 0; k < DISPATCH_KERNELS; k++) {
+        if (fprintf(f, "%s %s\n", dispatch_kernels[k].name, dispatch_current[k]) < 0) status = EXIT_FAILURE;
+    }
+
+    if (fclose(f) != 0) status = EXIT_FAILURE;
+    if (status == EXIT_SUCCESS && rename(tmp_path, path) != 0) status = EXIT_FAILURE;
+    if (status == EXIT_FAILURE) remove(tmp_path);
+    return status;
+}
+
+/**
+ * @brief Installs the fastest variant of every kernel on this host
+ * @details If cache_path names a file written by a previous call on the same CPU model and library build, its choice
+ *          is installed without timing anything. Otherwise every variant is checked against the reference and timed
+ *          for DISPATCH_TUNE_NS per kernel, and the choice is saved to cache_path.
+ *
+ * @param[in] cache_path cache file, or NULL to always tune and save nothing
+ * @return 0 on success, 1 if the cache file could not be written, the tuned variants are installed in both cases
+ */
+int dispatch_autotune(const char* cache_path) {
+    if (cache_path != NULL && dispatch_cache_load(cache_path) == EXIT_SUCCESS) return EXIT_SUCCESS;
+
+    dispatch_tune();
+
+    return cache_path == NULL ? EXIT_SUCCESS : dispatch_cache_save(cache_path);
+}
@@ -0,0 +1,108 @@
+/**
+ * @file encaps.c
+ * @brief Encapsulation context, everything encryption needs from a public key computed once
+ * @author Gabriel Abauzit
+ */
+
+#include "encaps.h"
+#include "trace.h"
+
+/**
+ * @brief Builds the context of a public key
+ * @details t is decoded with the FIPS 203 modulus check, A^T is written once in the layout polymat_ntt_product reads
+ *          fastest, and t gets the precomputation of NTT_multiply_cached.
+ *
+ * @param[out] ctx
+ * @param[in] t_bytes the t part of ek
+ * @param[in] A public matrix in the NTT domain, expanded from rho by the caller
+ * @param[in] ek_hash H(ek), copied as is
+ * @return 0 if the key is valid, 1 if a coefficient of t is not in [0, q)
+ */
+int encaps_ctx_init(encaps_ctx_t* ctx, const uint8_t t_bytes[ENCAPS_T_BYTES], const polymat_t* A, const uint8_t ek_hash[ENCAPS_HASH_BYTES]) {
+    int i, j;
+    int invalid = 0;
+
+    for (i = 0; i < KYBER_K; i++) {
+        invalid |= poly_decode12_checked(&ctx->t_hat.vec[i].hat, t_bytes + POLY_PACKED_BYTES * i);
+        NTT_multiply_cache(ctx->t_hat.vec[i].mulcache, ctx->t_hat.vec[i].hat.coeffs);
+        for (j = 0; j < KYBER_K; j++) {
+            poly_copy(&ctx->At.row[i].vec[j], &A->row[j].vec[i]);
+        }
+    }
+
+    memcpy(ctx->ek_hash, ek_hash, ENCAPS_HASH_BYTES);
+
+    return invalid;
+}
+
+/**
+ * @brief Allocates and builds the context of a public key, see encaps_ctx_init
+ * @return the context, NULL if the key is invalid or if the allocation failed. It should be released with encaps_ctx_secure_free
+ */
+encaps_ctx_t* encaps_ctx_new(const uint8_t t_bytes[ENCAPS_T_BYTES], const polymat_t* A, const uint8_t ek_hash[ENCAPS_HASH_BYTES]) {
+    encaps_ctx_t* ctx = (encaps_ctx_t*)aligned_alloc(POLYMAT_ALIGN, sizeof(encaps_ctx_t));
+
+    if (ctx == NULL) return NULL;
+
+    if (encaps_ctx_init(ctx, t_bytes, A, ek_hash) == EXIT_FAILURE) {
+        free(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+/**
+ * @brief Frees up a context created by encaps_ctx_new
+ * @param ptr points to the pointer to the memory space to free
+ */
+void encaps_ctx_secure_free(encaps_ctx_t** ptr) {
+    if (ptr == NULL || *ptr == NULL) return;
+
+    // Nothing to erase, the context only holds public data
+    free(*ptr);
+    *ptr = NULL;
+}
+
+/**
+ * @brief K-PKE.Encrypt (FIPS 203 Algorithm 14) to the key of ctx, with the noise given by the caller
+ * @details One NTT of r, one matrix/vector product and one scalar product, the inverse NTTs are fused with the noise
+ *          addition and the compression.
+ *
+ * @param[out] ct c_1 || c_2
+ * @param[in] ctx
+ * @param[in] m message
+ * @param[in] r, e1 noise vectors, sampled from CBD_eta1 and CBD_eta2
+ * @param[in] e2 noise polynomial, sampled from CBD_eta2
+ */
+void encaps_ctx_encrypt(uint8_t ct[CIPHERTEXT_BYTES], const encaps_ctx_t* ctx, const uint8_t m[KYBER_N / 8], const polyvec_t* r, const polyvec_t* e1, const poly_t* e2) {
+    int i;
+    polyvec_t r_hat, u;
+    poly_t v, temp, mu;
+
+    TRACE_BEGIN("encaps_ctx_encrypt");
+
+    polyvec_copy(&r_hat, r);
+    polyvec_ntt(&r_hat);
+
+    polymat_ntt_product(&u, &ctx->At, &r_hat, 0);
+    polyvec_ntt_inv_add_compress(&u, &u, e1, KYBER_DU);
+
+    poly_zero(&v);
+    for (i = 0; i < KYBER_K; i++) {
+        NTT_multiply_cached(temp.coeffs, ctx->t_hat.vec[i].hat.coeffs, ctx->t_hat.vec[i].mulcache, r_hat.vec[i].coeffs);
+        poly_add_noreduce(&v, &v, &temp);
+    }
+    POLY_ASSERT_BOUND(&v, POLY_BOUND_NTT_INV);
+    poly_frommsg_bits(&mu, m);
+    poly_ntt_inv_add_compress(&v, &v, e2, &mu, KYBER_DV);
+
+    polyvec_byte_encode(ct, &u, KYBER_DU);
+    byte_encode(ct + POLYVEC_BYTES(KYBER_DU), v.coeffs, KYBER_DV);
+
+    // r and m are secret, and so is everything derived from them before compression
+    polyvec_zero(&r_hat);
+    poly_zero(&temp);
+    poly_zero(&mu);
+
+    TRACE_END("encaps_ctx_encrypt");
+}
@@ -5,6 +5,7 @@
  */
 
 #include "encode.h"
+#include "dispatch.h"
 
 /**************************/
 /* BITS-BYTES CONVERSIONS */
@@ -18,8 +19,8 @@
  * @param[in] bits bits array of size 8 * l
  * @param l
  */
-void bits_to_bytes(uint8_t* bytes, const uint8_t* bits, unsigned l) {
-    int i, j;
+void bits_to_bytes_ref(uint8_t* bytes, const uint8_t* bits, unsigned l) {
+    unsigned i, j;
 
     for (i = 0; i < l; i++) {
         bytes[i] = 0;
@@ -40,8 +41,8 @@ void bits_to_bytes(uint8_t* bytes, const uint8_t* bits, unsigned l) {
  * @param[in] bytes bytes array of size l
  * @param l
  */
-void bytes_to_bits(uint8_t* bits, const uint8_t* bytes, unsigned l) {
-    int i, j;
+void bytes_to_bits_ref(uint8_t* bits, const uint8_t* bytes, unsigned l) {
+    unsigned i, j;
     
     for (i = 0; i < l; i++) {
         for (j = 0; j < 8; j++) {
@@ -62,8 +63,8 @@ void bytes_to_bits(uint8_t* bits, const uint8_t* bytes, unsigned l) {
  * @param[in] F int16_t array of size 256
  * @param[in] d should be between 1 and 12
  */
-void byte_encode(uint8_t* bytes, const int16_t* F, const unsigned d) {
-    int i, j;
+void byte_encode_ref(uint8_t* bytes, const int16_t* F, const unsigned d) {
+    unsigned i, j;
     int16_t a;
     int8_t b[256 * d];
     int16_t lower_bits; // To reduce mod 2^m where m = 2^d if d < 12, m = 3329 otherwise
@@ -79,7 +80,7 @@ void byte_encode(uint8_t* bytes, const int16_t* F, const unsigned d) {
         }
     }
 
-    bits_to_bytes(bytes, b, 32*d);
+    bits_to_bytes_ref(bytes, (const uint8_t*)b, 32*d);
 }
 
 /**
@@ -90,8 +91,8 @@ void byte_encode(uint8_t* bytes, const int16_t* F, const unsigned d) {
  * @param[in] bytes byte array of size 32 * d
  * @param d should be between 1 and 12
  */
-void byte_decode(int16_t* F, const uint8_t* bytes, const unsigned d) {
-    int i, j;
+void byte_decode_ref(int16_t* F, const uint8_t* bytes, const unsigned d) {
+    unsigned i, j;
     uint8_t* b;
     int16_t temp;
     int16_t lower_bits; // To reduce mod 2^m where m = 2^d if d < 12, m = 3329 otherwise
@@ -100,7 +101,7 @@ void byte_decode(int16_t* F, const uint8_t* bytes, const unsigned d) {
     lower_bits = (1U << d) - 1;
 
     b = (uint8_t*)malloc(256 * d * sizeof(uint8_t));
-    bytes_to_bits(b, bytes, 32*d);
+    bytes_to_bits_ref(b, bytes, 32*d);
 
     for (i = 0; i < 256; i++) {
         temp = 0;
@@ -114,6 +115,149 @@ void byte_decode(int16_t* F, const uint8_t* bytes, const unsigned d) {
     free(b);
 }
 
+/**
+ * @brief Encodes nblocks blocks of 8 integers into nblocks * d bytes, without the intermediate bit array
+ * @details Same output as byte_encode_ref on each block. The d-bit fields are accumulated in a 64-bit word and
+ *          flushed byte by byte.
+ */
+void byte_encode_blocks_scalar(uint8_t* bytes, const int16_t* F, const unsigned d, const unsigned nblocks) {
+    unsigned i, nbits;
+    uint64_t acc = 0;
+    const uint16_t lower_bits = (1U << d) - 1;
+
+    nbits = 0;
+    for (i = 0; i < 8*nblocks; i++) {
+        acc |= (uint64_t)(F[i] & lower_bits) << nbits;
+        nbits += d;
+        while (nbits >= 8) {
+            *bytes++ = (uint8_t)acc;
+            acc >>= 8;
+            nbits -= 8;
+        }
+    }
+}
+
+/**
+ * @brief Decodes nblocks * d bytes into nblocks blocks of 8 integers, without the intermediate bit array
+ * @details Same output as byte_decode_ref on each block
+ */
+void byte_decode_blocks_scalar(int16_t* F, const uint8_t* bytes, const unsigned d, const unsigned nblocks) {
+    unsigned i, nbits;
+    uint64_t acc = 0;
+    const uint16_t lower_bits = (1U << d) - 1;
+
+    nbits = 0;
+    for (i = 0; i < 8*nblocks; i++) {
+        while (nbits < d) {
+            acc |= (uint64_t)(*bytes++) << nbits;
+            nbits += 8;
+        }
+        F[i] = (int16_t)(acc & lower_bits);
+        acc >>= d;
+        nbits -= d;
+    }
+}
+
+/************/
+/* DISPATCH */
+/************/
+
+/**
+ * @brief Converts a bit array into an array of bytes, see bits_to_bytes_ref
+ */
+void bits_to_bytes(uint8_t* bytes, const uint8_t* bits, unsigned l) {
+#ifdef ENCODE_BMI2_AVAILABLE
+    if (encode_bmi2_supported()) {
+        bits_to_bytes_bmi2(bytes, bits, l);
+        return;
+    }
+#endif
+    bits_to_bytes_ref(bytes, bits, l);
+}
+
+/**
+ * @brief Converts a bytes array into an array of bits, see bytes_to_bits_ref
+ */
+void bytes_to_bits(uint8_t* bits, const uint8_t* bytes, unsigned l) {
+#ifdef ENCODE_BMI2_AVAILABLE
+    if (encode_bmi2_supported()) {
+        bytes_to_bits_bmi2(bits, bytes, l);
+        return;
+    }
+#endif
+    bytes_to_bits_ref(bits, bytes, l);
+}
+
+/**
+ * @brief Encodes an array of integers into a byte array, with the variant installed in dispatch_table
+ */
+void byte_encode(uint8_t* bytes, const int16_t* F, const unsigned d) {
+    dispatch_table.byte_encode(bytes, F, d);
+}
+
+/**
+ * @brief Decodes a byte array into an array of integers, with the variant installed in dispatch_table
+ */
+void byte_decode(int16_t* F, const uint8_t* bytes, const unsigned d) {
+    dispatch_table.byte_decode(F, bytes, d);
+}
+
+/**
+ * @brief Encodes an array of integers into a byte array, see byte_encode_ref
+ * @details Uses BMI2 when the host supports it, this is the entry of dispatch_table until it is tuned
+ */
+void byte_encode_default(uint8_t* bytes, const int16_t* F, const unsigned d) {
+#ifdef ENCODE_BMI2_AVAILABLE
+    if (encode_bmi2_supported()) {
+        byte_encode_bmi2(bytes, F, d);
+        return;
+    }
+#endif
+    byte_encode_ref(bytes, F, d);
+}
+
+/**
+ * @brief Encodes byte array into an array of integers, see byte_decode_ref
+ * @details Uses BMI2 when the host supports it, this is the entry of dispatch_table until it is tuned
+ */
+void byte_decode_default(int16_t* F, const uint8_t* bytes, const unsigned d) {
+#ifdef ENCODE_BMI2_AVAILABLE
+    if (encode_bmi2_supported()) {
+        byte_decode_bmi2(F, bytes, d);
+        return;
+    }
+#endif
+    byte_decode_ref(F, bytes, d);
+}
+
+/**
+ * @brief Encodes nblocks blocks of 8 integers into nblocks * d bytes
+ * @details Encoding the 32 blocks of a polynomial gives the same output as byte_encode
+ */
+void byte_encode_blocks(uint8_t* bytes, const int16_t* F, const unsigned d, const unsigned nblocks) {
+#ifdef ENCODE_BMI2_AVAILABLE
+    if (encode_bmi2_supported()) {
+        byte_encode_blocks_bmi2(bytes, F, d, nblocks);
+        return;
+    }
+#endif
+    byte_encode_blocks_scalar(bytes, F, d, nblocks);
+}
+
+/**
+ * @brief Decodes nblocks * d bytes into nblocks blocks of 8 integers
+ * @details Decoding the 32 blocks of a polynomial gives the same output as byte_decode
+ */
+void byte_decode_blocks(int16_t* F, const uint8_t* bytes, const unsigned d, const unsigned nblocks) {
+#ifdef ENCODE_BMI2_AVAILABLE
+    if (encode_bmi2_supported()) {
+        byte_decode_blocks_bmi2(F, bytes, d, nblocks);
+        return;
+    }
+#endif
+    byte_decode_blocks_scalar(F, bytes, d, nblocks);
+}
+
 /*********************************/
 /* COMPRESSION AND DECOMPRESSION */
 /*********************************/
@@ -123,11 +267,15 @@ void byte_decode(int16_t* F, const uint8_t* bytes, const unsigned d) {
  * @param x
  * @param d
  */
-int16_t compress(const int16_t x, const unsigned d) {
+KYBER_INTERNAL int16_t compress(const int16_t x, const unsigned d) {
     uint32_t t;
+    int32_t x_pos;
+
+    // The division trick below needs a non-negative input, the canonical representants in [-(q-1)/2,(q-1)/2] are sent to [0,q-1]
+    x_pos = (int32_t)x + ((x >> 15) & KYBER_Q);
 
-    t = ((int32_t)x << d) + (KYBER_Q / 2);
-    t = (int32_t)(((int64_t)t * BARRETT_FACTOR) >> 26);
+    t = (x_pos << d) + (KYBER_Q / 2);
+    t = (uint32_t)(((uint64_t)t * COMPRESS_FACTOR) >> 33); // exact division by q for t < 2^23, 2^26/q is not precise enough when d >= 7
     t &= (1U << d) - 1;
     return (int16_t)t;
 }
@@ -137,7 +285,7 @@ int16_t compress(const int16_t x, const unsigned d) {
  * @param x
  * @param d 
  */
-int16_t decompress(const int16_t x, const unsigned d) {
+KYBER_INTERNAL int16_t decompress(const int16_t x, const unsigned d) {
     uint32_t t;
 
     t = ((int32_t)x * KYBER_Q) + (1U << (d-1));
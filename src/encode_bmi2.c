@@ -0,0 +1,115 @@
+/**
+ * @file encode_bmi2.c
+ * @brief BMI2 fast paths for the bits-bytes conversions and the bytes encoding
+ * @author Gabriel Abauzit
+ */
+
+#include "encode.h"
+
+#ifdef ENCODE_BMI2_AVAILABLE
+
+#include <immintrin.h>
+
+#define BMI2 __attribute__((target("bmi2")))
+
+// One bit in the lowest bit of each of 8 bytes
+#define BITS_MASK 0x0101010101010101ULL
+
+/**
+ * @brief Checks at runtime whether the host supports BMI2
+ * @return 1 if it does, 0 otherwise
+ */
+int encode_bmi2_supported(void) {
+    return __builtin_cpu_supports("bmi2") ? 1 : 0;
+}
+
+/**************************/
+/* BITS-BYTES CONVERSIONS */
+/**************************/
+
+/**
+ * @brief Converts a bit array into an array of bytes, same output as bits_to_bytes_ref
+ * @details The 8 bits of a byte are gathered with a single PEXT
+ */
+BMI2 void bits_to_bytes_bmi2(uint8_t* bytes, const uint8_t* bits, unsigned l) {
+    unsigned i;
+    uint64_t w;
+
+    for (i = 0; i < l; i++) {
+        memcpy(&w, bits + 8*i, 8);
+        bytes[i] = (uint8_t)_pext_u64(w, BITS_MASK);
+    }
+}
+
+/**
+ * @brief Converts a bytes array into an array of bits, same output as bytes_to_bits_ref
+ * @details The 8 bits of a byte are scattered with a single PDEP
+ */
+BMI2 void bytes_to_bits_bmi2(uint8_t* bits, const uint8_t* bytes, unsigned l) {
+    unsigned i;
+    uint64_t w;
+
+    for (i = 0; i < l; i++) {
+        w = _pdep_u64(bytes[i], BITS_MASK);
+        memcpy(bits + 8*i, &w, 8);
+    }
+}
+
+/****************/
+/* BYTES ENCODE */
+/****************/
+
+/**
+ * @brief Encodes nblocks blocks of 8 integers into nblocks * d bytes, same output as byte_encode_blocks
+ * @details 8 coefficients fill exactly d bytes. Each group of 4 coefficients is loaded as a 64-bit word and the
+ *          lower d bits of its 4 lanes are gathered with a single PEXT.
+ */
+BMI2 void byte_encode_blocks_bmi2(uint8_t* bytes, const int16_t* F, const unsigned d, const unsigned nblocks) {
+    unsigned i;
+    uint64_t w0, w1;
+    unsigned __int128 v;
+    const uint64_t mask = ((1ULL << d) - 1) * 0x0001000100010001ULL;
+
+    for (i = 0; i < nblocks; i++) {
+        memcpy(&w0, F + 8*i, 8);
+        memcpy(&w1, F + 8*i + 4, 8);
+        v = ((unsigned __int128)_pext_u64(w1, mask) << (4*d)) | _pext_u64(w0, mask);
+        memcpy(bytes + i*d, &v, d);
+    }
+}
+
+/**
+ * @brief Decodes nblocks * d bytes into nblocks blocks of 8 integers, same output as byte_decode_blocks
+ * @details d bytes hold 8 coefficients, each half is scattered into four 16-bit lanes with a single PDEP
+ */
+BMI2 void byte_decode_blocks_bmi2(int16_t* F, const uint8_t* bytes, const unsigned d, const unsigned nblocks) {
+    unsigned i;
+    uint64_t w0, w1;
+    unsigned __int128 v;
+    const uint64_t mask = ((1ULL << d) - 1) * 0x0001000100010001ULL;
+
+    for (i = 0; i < nblocks; i++) {
+        v = 0;
+        memcpy(&v, bytes + i*d, d);
+        w0 = _pdep_u64((uint64_t)v, mask);
+        w1 = _pdep_u64((uint64_t)(v >> (4*d)), mask);
+        memcpy(F + 8*i, &w0, 8);
+        memcpy(F + 8*i + 4, &w1, 8);
+    }
+}
+
+/**
+ * @brief Encodes an array of integers into a byte array, same output as byte_encode_ref
+ */
+void byte_encode_bmi2(uint8_t* bytes, const int16_t* F, const unsigned d) {
+    byte_encode_blocks_bmi2(bytes, F, d, 32);
+}
+
+/**
+ * @brief Encodes byte array into an array of integers, same output as byte_decode_ref
+ */
+void byte_decode_bmi2(int16_t* F, const uint8_t* bytes, const unsigned d) {
+    byte_decode_blocks_bmi2(F, bytes, d, 32);
+}
+
+#endif
@@ -0,0 +1,291 @@
+/**
+ * @file keycache.c
+ * @brief Bounded LRU cache of prepared decapsulation keys, safe to share between threads
+ * @author Gabriel Abauzit
+ */
+
+#include <pthread.h>
+#include "keycache.h"
+#include "ct.h"
+
+// An entry is both in the LRU list and in the chain of its bucket. The prepared key is its first member, so that the
+// pointer handed out by keycache_acquire can be turned back into the entry.
+typedef struct keycache_entry_s {
+    prepared_key_t key;
+    struct keycache_entry_s* prev;        // more recently used
+    struct keycache_entry_s* next;        // less recently used
+    struct keycache_entry_s* chain;       // next entry of the same bucket
+    unsigned refs;                        // number of keycache_acquire not yet released
+    int evicted;                          // already out of the cache, freed by the last keycache_release
+} keycache_entry_t;
+
+struct keycache_s {
+    pthread_mutex_t lock;
+    keycache_entry_t** buckets;
+    size_t bucket_mask;                   // the number of buckets is a power of 2
+    keycache_entry_t* head;               // most recently used
+    keycache_entry_t* tail;               // least recently used
+    size_t size;
+    size_t capacity;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+};
+
+/*****************/
+/* PREPARED KEYS */
+/*****************/
+
+/**
+ * @brief Prepares a key for decapsulation
+ * @details Both vectors are checked while decoded (modulus check of FIPS 203), nothing else is left for decapsulation
+ *          to compute on the key.
+ *
+ * @param[out] key
+ * @param[in] fingerprint H(ek), copied as is
+ * @param[in] s_bytes ByteEncode_12 of the secret vector s in the NTT domain
+ * @param[in] t_bytes ByteEncode_12 of the public vector t in the NTT domain
+ * @param[in] A public matrix in the NTT domain, expanded by the caller
+ * @return 0 if the key is valid, 1 if one of its coefficients is not in [0, q), key is then erased
+ */
+int prepared_key_init(prepared_key_t* key, const uint8_t fingerprint[KEYCACHE_FINGERPRINT_BYTES], const uint8_t s_bytes[KEYCACHE_VECTOR_BYTES], const uint8_t t_bytes[KEYCACHE_VECTOR_BYTES], const polymat_t* A) {
+    int i;
+    int invalid = 0;
+    polyvec_t t;
+
+    for (i = 0; i < KYBER_K; i++) {
+        invalid |= poly_decode12_checked(&key->s_hat.vec[i].hat, s_bytes + POLY_PACKED_BYTES * i);
+        NTT_multiply_cache(key->s_hat.vec[i].mulcache, key->s_hat.vec[i].hat.coeffs);
+    }
+
+    // The 12-bit encoding of t is already the packed form, it only has to be checked
+    invalid |= polyvec_decode12_checked(&t, t_bytes);
+    memcpy(key->t_hat.vec, t_bytes, KEYCACHE_VECTOR_BYTES);
+
+    key->A = *A;
+    memcpy(key->fingerprint, fingerprint, KEYCACHE_FINGERPRINT_BYTES);
+
+    if (invalid) {
+        ct_zero(key, sizeof(prepared_key_t));
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Computes NTT^{-1}(s^T o NTT(u)), the part of decryption that involves the secret key
+ * @param[out] r
+ * @param[in] key
+ * @param[in] u in the normal domain
+ */
+void prepared_key_secret_product(poly_t* r, const prepared_key_t* key, const polyvec_t* u) {
+    polyvec_scalar_product_cached(r, &key->s_hat, u);
+}
+
+/*********/
+/* CACHE */
+/*********/
+
+/**
+ * @brief Bucket of a fingerprint, the fingerprint being a hash its first bytes are used as is
+ */
+static size_t keycache_bucket(const keycache_t* cache, const uint8_t fingerprint[KEYCACHE_FINGERPRINT_BYTES]) {
+    uint64_t h;
+
+    memcpy(&h, fingerprint, sizeof(h));
+    return (size_t)h & cache->bucket_mask;
+}
+
+static keycache_entry_t* keycache_lookup(const keycache_t* cache, const uint8_t fingerprint[KEYCACHE_FINGERPRINT_BYTES]) {
+    keycache_entry_t* e = cache->buckets[keycache_bucket(cache, fingerprint)];
+
+    while (e != NULL && memcmp(e->key.fingerprint, fingerprint, KEYCACHE_FINGERPRINT_BYTES) != 0) {
+        e = e->chain;
+    }
+    return e;
+}
+
+static void keycache_entry_free(keycache_entry_t* e) {
+    ct_zero(e, sizeof(keycache_entry_t));
+    free(e);
+}
+
+static void keycache_unlink(keycache_t* cache, keycache_entry_t* e) {
+    if (e->prev != NULL) e->prev->next = e->next;
+    else cache->head = e->next;
+    if (e->next != NULL) e->next->prev = e->prev;
+    else cache->tail = e->prev;
+    e->prev = NULL;
+    e->next = NULL;
+}
+
+static void keycache_push_front(keycache_t* cache, keycache_entry_t* e) {
+    e->next = cache->head;
+    if (cache->head != NULL) cache->head->prev = e;
+    cache->head = e;
+    if (cache->tail == NULL) cache->tail = e;
+}
+
+/**
+ * @brief Removes the least recently used entry, it is freed now if no one uses it, by its last release otherwise
+ */
+static void keycache_evict(keycache_t* cache) {
+    keycache_entry_t* victim = cache->tail;
+    keycache_entry_t** link = &cache->buckets[keycache_bucket(cache, victim->key.fingerprint)];
+
+    while (*link != victim) {
+        link = &(*link)->chain;
+    }
+    *link = victim->chain;
+    keycache_unlink(cache, victim);
+
+    cache->size--;
+    cache->evictions++;
+
+    if (victim->refs == 0) keycache_entry_free(victim);
+    else victim->evicted = 1;
+}
+
+/**
+ * @brief Creates an empty cache
+ * @param[in] capacity maximal number of prepared keys held, at least 1
+ * @return the cache, NULL if capacity is 0 or if the allocation failed. It should be released with keycache_secure_free
+ */
+keycache_t* keycache_new(const size_t capacity) {
+    keycache_t* cache;
+    size_t nbuckets = 1;
+
+    if (capacity == 0) return NULL;
+
+    while (nbuckets < capacity) {
+        nbuckets <<= 1;
+    }
+
+    cache = (keycache_t*)calloc(1, sizeof(keycache_t));
+    if (cache == NULL) return NULL;
+
+    cache->buckets = (keycache_entry_t**)calloc(nbuckets, sizeof(keycache_entry_t*));
+    if (cache->buckets == NULL || pthread_mutex_init(&cache->lock, NULL) != 0) {
+        free(cache->buckets);
+        free(cache);
+        return NULL;
+    }
+
+    cache->bucket_mask = nbuckets - 1;
+    cache->capacity = capacity;
+    return cache;
+}
+
+/**
+ * @brief Erases all the prepared keys and frees up the cache
+ * @details Every key acquired should have been released before
+ * @param ptr points to the pointer to the memory space to free
+ */
+void keycache_secure_free(keycache_t** ptr) {
+    keycache_entry_t* e;
+    keycache_entry_t* next;
+
+    if (ptr == NULL || *ptr == NULL) return;
+
+    for (e = (*ptr)->head; e != NULL; e = next) {
+        next = e->next;
+        keycache_entry_free(e);
+    }
+
+    pthread_mutex_destroy(&(*ptr)->lock);
+    free((*ptr)->buckets);
+    free(*ptr);
+    *ptr = NULL;
+}
+
+/**
+ * @brief Gives the prepared key of fingerprint, preparing it from its encoding if it is not in the cache
+ * @details On a miss, the key is prepared outside of the lock then inserted, evicting the least recently used key if
+ *          the cache is full. A key stays valid until released, even if it is evicted in the meantime.
+ *
+ * @param[in] cache
+ * @param[in] fingerprint H(ek)
+ * @param[in] s_bytes, t_bytes, A see prepared_key_init, only read on a miss
+ * @return the prepared key, to be released with keycache_release. NULL if the key is invalid or if the allocation failed.
+ */
+const prepared_key_t* keycache_acquire(keycache_t* cache, const uint8_t fingerprint[KEYCACHE_FINGERPRINT_BYTES], const uint8_t s_bytes[KEYCACHE_VECTOR_BYTES], const uint8_t t_bytes[KEYCACHE_VECTOR_BYTES], const polymat_t* A) {
+    keycache_entry_t* e;
+    keycache_entry_t* fresh;
+
+    pthread_mutex_lock(&cache->lock);
+    e = keycache_lookup(cache, fingerprint);
+    if (e != NULL) {
+        e->refs++;
+        keycache_unlink(cache, e);
+        keycache_push_front(cache, e);
+        cache->hits++;
+        pthread_mutex_unlock(&cache->lock);
+        return &e->key;
+    }
+    cache->misses++;
+    pthread_mutex_unlock(&cache->lock);
+
+    fresh = (keycache_entry_t*)aligned_alloc(POLYMAT_ALIGN, sizeof(keycache_entry_t));
+    if (fresh == NULL) return NULL;
+    if (prepared_key_init(&fresh->key, fingerprint, s_bytes, t_bytes, A) == EXIT_FAILURE) {
+        free(fresh);
+        return NULL;
+    }
+    fresh->prev = NULL;
+    fresh->next = NULL;
+    fresh->refs = 1;
+    fresh->evicted = 0;
+
+    pthread_mutex_lock(&cache->lock);
+    e = keycache_lookup(cache, fingerprint);
+    if (e != NULL) {
+        // Prepared by another thread in the meantime
+        e->refs++;
+        keycache_unlink(cache, e);
+        keycache_push_front(cache, e);
+        pthread_mutex_unlock(&cache->lock);
+        keycache_entry_free(fresh);
+        return &e->key;
+    }
+
+    fresh->chain = cache->buckets[keycache_bucket(cache, fingerprint)];
+    cache->buckets[keycache_bucket(cache, fingerprint)] = fresh;
+    keycache_push_front(cache, fresh);
+    cache->size++;
+    while (cache->size > cache->capacity) {
+        keycache_evict(cache);
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    return &fresh->key;
+}
+
+/**
+ * @brief Gives back a key obtained from keycache_acquire, it must not be used afterwards
+ */
+void keycache_release(keycache_t* cache, const prepared_key_t* key) {
+    keycache_entry_t* e = (keycache_entry_t*)key;
+    int last;
+
+    if (key == NULL) return;
+
+    pthread_mutex_lock(&cache->lock);
+    e->refs--;
+    last = e->evicted && e->refs == 0;
+    pthread_mutex_unlock(&cache->lock);
+
+    if (last) keycache_entry_free(e);
+}
+
+/**
+ * @brief Copies the statistics of the cache
+ */
+void keycache_stats(keycache_t* cache, keycache_stats_t* stats) {
+    pthread_mutex_lock(&cache->lock);
+    stats->hits = cache->hits;
+    stats->misses = cache->misses;
+    stats->evictions = cache->evictions;
+    stats->size = cache->size;
+    stats->capacity = cache->capacity;
+    pthread_mutex_unlock(&cache->lock);
+}
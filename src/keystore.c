@@ -0,0 +1,279 @@
+/**
+ * @file keystore.c
+ * @brief Memory-mapped keystore file, keys are stored decoded and used in place
+ * @author Gabriel Abauzit
+ */
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "keystore.h"
+
+_Static_assert(sizeof(keystore_header_t) == KEYSTORE_ALIGN, "the header fills exactly one aligned block");
+_Static_assert(sizeof(polyvec_t) % KEYSTORE_ALIGN == 0, "every vector of the data section stays aligned");
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static uint64_t fnv1a(uint64_t h, const uint8_t* bytes, size_t len) {
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        h = (h ^ bytes[i]) * FNV_PRIME;
+    }
+    return h;
+}
+
+static uint64_t align_up(const uint64_t x) {
+    return (x + KEYSTORE_ALIGN - 1) & ~(uint64_t)(KEYSTORE_ALIGN - 1);
+}
+
+/***********/
+/* READING */
+/***********/
+
+/**
+ * @brief Checks everything that can be checked without reading the index and the data
+ */
+static int keystore_check_header(const keystore_t* ks) {
+    const keystore_header_t* h = ks->header;
+    uint64_t index_end, data_size;
+
+    if (ks->length < sizeof(keystore_header_t)) return EXIT_FAILURE;
+    if (memcmp(h->magic, KEYSTORE_MAGIC, sizeof(KEYSTORE_MAGIC)) != 0) return EXIT_FAILURE;
+    if (h->version != KEYSTORE_VERSION || h->byte_order != KEYSTORE_BYTE_ORDER) return EXIT_FAILURE;
+    if (h->kyber_k != KYBER_K || h->kyber_n != KYBER_N || h->vectors_per_key == 0) return EXIT_FAILURE;
+
+    // The number of vectors, not only each factor, is bounded by the file length before the sizes are computed, so that
+    // none of them overflows
+    if (h->count > ks->length / sizeof(polyvec_t)) return EXIT_FAILURE;
+    if (h->count > 0 && h->vectors_per_key > ks->length / sizeof(polyvec_t) / h->count) return EXIT_FAILURE;
+    index_end = h->index_offset + h->count * sizeof(keystore_index_t);
+    data_size = h->count * h->vectors_per_key * sizeof(polyvec_t);
+    if (h->index_offset != sizeof(keystore_header_t) || h->data_offset != align_up(index_end)) return EXIT_FAILURE;
+    if (h->data_offset + data_size != ks->length) return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Maps a keystore file in memory
+ * @details Only the header is read, opening does not depend on the number of keys. With KEYSTORE_VERIFY the checksum
+ *          and the index are also checked, otherwise this can be deferred to keystore_verify.
+ *
+ * @param[out] ks
+ * @param[in] path
+ * @param[in] flags 0 or KEYSTORE_VERIFY
+ * @return 0 if the file is a valid keystore for this build, 1 otherwise (ks is then left closed)
+ */
+int keystore_open(keystore_t* ks, const char* path, const int flags) {
+    int fd;
+    struct stat st;
+    void* base;
+
+    memset(ks, 0, sizeof(keystore_t));
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) return EXIT_FAILURE;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(keystore_header_t)) {
+        close(fd);
+        return EXIT_FAILURE;
+    }
+
+    base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return EXIT_FAILURE;
+
+    ks->base = (const uint8_t*)base;
+    ks->length = (size_t)st.st_size;
+    ks->header = (const keystore_header_t*)ks->base;
+
+    if (keystore_check_header(ks) == EXIT_FAILURE || ((flags & KEYSTORE_VERIFY) && keystore_verify(ks) == EXIT_FAILURE)) {
+        keystore_close(ks);
+        return EXIT_FAILURE;
+    }
+
+    ks->index = (const keystore_index_t*)(ks->base + ks->header->index_offset);
+    ks->data = (const polyvec_t*)(ks->base + ks->header->data_offset);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Checks the checksum, that the index is strictly sorted and that its slots are in range
+ * @details Reads the whole file, meant to be called once in the background after a fast keystore_open
+ * @return 0 if the keystore is intact, 1 otherwise
+ */
+int keystore_verify(const keystore_t* ks) {
+    const keystore_header_t* h = ks->header;
+    const keystore_index_t* index = (const keystore_index_t*)(ks->base + h->index_offset);
+    uint64_t i;
+
+    if (fnv1a(FNV_OFFSET, ks->base + h->index_offset, ks->length - h->index_offset) != h->checksum) return EXIT_FAILURE;
+
+    for (i = 0; i < h->count; i++) {
+        if (index[i].slot >= h->count) return EXIT_FAILURE;
+        if (i > 0 && memcmp(index[i - 1].fingerprint, index[i].fingerprint, KEYSTORE_FINGERPRINT_BYTES) >= 0) return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Vectors of the key in position slot of the data section
+ * @return vectors_per_key consecutive polyvec_t, NULL if slot is out of range
+ */
+const polyvec_t* keystore_get(const keystore_t* ks, const uint64_t slot) {
+    if (slot >= ks->header->count) return NULL;
+
+    return ks->data + slot * ks->header->vectors_per_key;
+}
+
+/**
+ * @brief Looks up a key by binary search in the index
+ * @return vectors_per_key consecutive polyvec_t, NULL if there is no such key
+ */
+const polyvec_t* keystore_find(const keystore_t* ks, const uint8_t fingerprint[KEYSTORE_FINGERPRINT_BYTES]) {
+    uint64_t low = 0;
+    uint64_t high = ks->header->count;
+    uint64_t mid;
+    int cmp;
+
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        cmp = memcmp(ks->index[mid].fingerprint, fingerprint, KEYSTORE_FINGERPRINT_BYTES);
+        if (cmp == 0) return keystore_get(ks, ks->index[mid].slot);
+        if (cmp < 0) low = mid + 1;
+        else high = mid;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Unmaps the keystore, the pointers it gave are no longer valid
+ */
+void keystore_close(keystore_t* ks) {
+    if (ks->base != NULL) munmap((void*)ks->base, ks->length);
+    memset(ks, 0, sizeof(keystore_t));
+}
+
+/***********/
+/* WRITING */
+/***********/
+
+static int keystore_index_cmp(const void* a, const void* b) {
+    return memcmp(((const keystore_index_t*)a)->fingerprint, ((const keystore_index_t*)b)->fingerprint, KEYSTORE_FINGERPRINT_BYTES);
+}
+
+/**
+ * @brief fwrite that also updates the checksum
+ */
+static int keystore_put(FILE* f, uint64_t* checksum, const void* bytes, const size_t len) {
+    *checksum = fnv1a(*checksum, (const uint8_t*)bytes, len);
+    return fwrite(bytes, 1, len, f) == len ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Flushes the directory entry of path to disk, after path was renamed into it
+ */
+static int keystore_sync_dir(const char* path) {
+    char dir[4096];
+    char* slash;
+    int fd, status;
+
+    if (snprintf(dir, sizeof(dir), "%s", path) >= (int)sizeof(dir)) return EXIT_FAILURE;
+    slash = strrchr(dir, '/');
+    if (slash == NULL) strcpy(dir, ".");
+    else if (slash == dir) dir[1] = '\0';
+    else *slash = '\0';
+
+    fd = open(dir, O_RDONLY);
+    if (fd < 0) return EXIT_FAILURE;
+    status = fsync(fd) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    close(fd);
+    return status;
+}
+
+/**
+ * @brief Writes a keystore file
+ * @details The file is written next to path, synced, then renamed, and the directory is synced : a keystore being read
+ *          is never seen half written, and after a crash path holds either the previous keystore or the new one.
+ *          The coefficients are reduced to their canonical form on the way.
+ *
+ * @param[in] path
+ * @param[in] fingerprints count fingerprints, all distinct
+ * @param[in] vectors count * vectors_per_key vectors in the NTT domain, the ones of key i start at i * vectors_per_key
+ * @param[in] count
+ * @param[in] vectors_per_key e.g. 1 for public keys t, 2 for (t, s)
+ * @return 0 on success, 1 if a fingerprint is repeated or if writing failed
+ */
+int keystore_write(const char* path, const uint8_t fingerprints[][KEYSTORE_FINGERPRINT_BYTES], const polyvec_t* vectors, const uint64_t count, const uint32_t vectors_per_key) {
+    keystore_header_t header;
+    keystore_index_t* index;
+    polyvec_t v;
+    uint8_t padding[KEYSTORE_ALIGN] = {0};
+    uint64_t i, index_end;
+    char tmp_path[4096];
+    FILE* f;
+    int status = EXIT_SUCCESS;
+
+    if (vectors_per_key == 0 || snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int)sizeof(tmp_path)) return EXIT_FAILURE;
+
+    index = (keystore_index_t*)calloc(count > 0 ? count : 1, sizeof(keystore_index_t));
+    if (index == NULL) return EXIT_FAILURE;
+
+    for (i = 0; i < count; i++) {
+        memcpy(index[i].fingerprint, fingerprints[i], KEYSTORE_FINGERPRINT_BYTES);
+        index[i].slot = i;
+    }
+    qsort(index, count, sizeof(keystore_index_t), keystore_index_cmp);
+    for (i = 1; i < count; i++) {
+        if (keystore_index_cmp(&index[i - 1], &index[i]) == 0) {
+            free(index);
+            return EXIT_FAILURE;
+        }
+    }
+
+    index_end = sizeof(keystore_header_t) + count * sizeof(keystore_index_t);
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, KEYSTORE_MAGIC, sizeof(KEYSTORE_MAGIC));
+    header.version = KEYSTORE_VERSION;
+    header.byte_order = KEYSTORE_BYTE_ORDER;
+    header.kyber_k = KYBER_K;
+    header.kyber_n = KYBER_N;
+    header.vectors_per_key = vectors_per_key;
+    header.count = count;
+    header.index_offset = sizeof(keystore_header_t);
+    header.data_offset = align_up(index_end);
+    header.checksum = FNV_OFFSET;
+
+    f = fopen(tmp_path, "wb");
+    if (f == NULL) {
+        free(index);
+        return EXIT_FAILURE;
+    }
+
+    // The header is written again at the end, once the checksum is known
+    if (fwrite(&header, 1, sizeof(header), f) != sizeof(header)) status = EXIT_FAILURE;
+    if (status == EXIT_SUCCESS) status = keystore_put(f, &header.checksum, index, count * sizeof(keystore_index_t));
+    if (status == EXIT_SUCCESS) status = keystore_put(f, &header.checksum, padding, header.data_offset - index_end);
+    for (i = 0; i < count * vectors_per_key && status == EXIT_SUCCESS; i++) {
+        polyvec_copy(&v, &vectors[i]);
+        polyvec_reduce(&v);
+        status = keystore_put(f, &header.checksum, &v, sizeof(polyvec_t));
+    }
+    if (status == EXIT_SUCCESS && (fseek(f, 0, SEEK_SET) != 0 || fwrite(&header, 1, sizeof(header), f) != sizeof(header))) status = EXIT_FAILURE;
+    // Without the sync, the rename can reach the disk before the data and leave an empty or truncated keystore
+    if (status == EXIT_SUCCESS && (fflush(f) != 0 || fsync(fileno(f)) != 0)) status = EXIT_FAILURE;
+    if (fclose(f) != 0) status = EXIT_FAILURE;
+
+    if (status == EXIT_SUCCESS && rename(tmp_path, path) != 0) status = EXIT_FAILURE;
+    if (status == EXIT_FAILURE) remove(tmp_path);
+    else status = keystore_sync_dir(path);
+
+    free(index);
+    return status;
+}
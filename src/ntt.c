@@ -5,6 +5,8 @@
  */
 
 #include "ntt.h"
+#include "encode.h"
+#include "dispatch.h"
 
 /***************************************************************************************************/
 /* The zeta tables are taken from FIPS 203 Appendix A, and then converted to the Montgomery domain */
@@ -16,21 +18,61 @@ const int16_t zetas[128] = {-1044, -758, -359, -1517, 1493, 1422, 287, 202, -171
 // zetas_basemul[i] = zeta{2*BitRev_7(i) + 1} with zeta = 17 (mod 3329)
 const int16_t zetas_basemul[128] = {-1103, 1103, 430, -430, 555, -555, 843, -843, -1251, 1251, 871, -871, 1550, -1550, 105, -105, 422, -422, 587, -587, 177, -177, -235, 235, -291, 291, -460, 460, 1574, -1574, 1653, -1653, -246, 246, 778, -778, 1159, -1159, -147, 147, -777, 777, 1483, -1483, -602, 602, 1119, -1119, -1590, 1590, 644, -644, -872, 872, 349, -349, 418, -418, 329, -329, -156, 156, -75, 75, 817, -817, 1097, -1097, 603, -603, 610, -610, 1322, -1322, -1285, 1285, -1465, 1465, 384, -384, -1215, 1215, -136, 136, 1218, -1218, -1335, 1335, -874, 874, 220, -220, -1187, 1187, -1659, 1659, -1185, 1185, -1530, 1530, -1278, 1278, 794, -794, -1510, 1510, -854, 854, -870, 870, 478, -478, -108, 108, -308, 308, 996, -996, 991, -991, 958, -958, -1460, 1460, 1522, -1522, 1628, -1628};
 
+/********************************************************************************************************/
+/* Tables of the other reduction families, see KYBER_REDUCE in reduce.h. They hold the same zetas, out */
+/* of the Montgomery domain, along with what each family precomputes from its constant multiplicand.   */
+/********************************************************************************************************/
+
+// zetas_shoup[i] = zetas[i] * R^-1, zetas_shoup_quot[i] = round(zetas_shoup[i] * 2^16 / q)
+const int16_t zetas_shoup[128] = {1, -1600, -749, -40, -687, 630, -1432, 848, 1062, -1410, 193, 797, -543, -69, 569, -1583, 296, -882, 1339, 1476, -283, 56, -1089, 1333, 1426, -1235, 535, -447, -936, -450, -1355, 821, 289, 331, -76, -1573, 1197, -1025, -1052, -1274, 650, -1352, -816, 632, -464, 33, 1320, -1414, -1010, 1435, 807, 452, 1438, -461, 1534, -927, -682, -712, 1481, 648, -855, -219, 1227, 910, 17, -568, 583, -680, 1637, 723, -1041, 1100, 1409, -667, -48, 233, 756, -1173, -314, -279, -1626, 1651, -540, -1540, -1482, 952, 1461, -642, 939, -1021, -892, -941, 733, -992, 268, 641, 1584, -1031, -1292, -109, 375, -780, -1239, 1645, 1063, 319, -556, 757, -1230, 561, -863, -735, -525, 1092, 403, 1026, 1143, -1179, -554, 886, -1607, 1212, -1455, 1029, -1219, -394, 885, -1175};
+
+const int16_t zetas_shoup_quot[128] = {20, -31498, -14745, -787, -13525, 12402, -28191, 16694, 20907, -27758, 3799, 15690, -10690, -1358, 11202, -31164, 5827, -17363, 26360, 29057, -5571, 1102, -21438, 26242, 28073, -24313, 10532, -8800, -18426, -8859, -26675, 16163, 5689, 6516, -1496, -30967, 23565, -20179, -20710, -25080, 12796, -26616, -16064, 12442, -9134, 650, 25986, -27837, -19883, 28250, 15887, 8898, 28309, -9075, 30199, -18249, -13426, -14017, 29156, 12757, -16832, -4311, 24155, 17915, 335, -11182, 11477, -13387, 32227, 14233, -20494, 21655, 27738, -13131, -945, 4587, 14883, -23092, -6182, -5493, -32010, 32502, -10631, -30317, -29175, 18741, 28762, -12639, 18486, -20100, -17560, -18525, 14430, -19529, 5276, 12619, 31183, -20297, -25435, -2146, 7382, -15355, -24391, 32384, 20927, 6280, -10946, 14903, -24214, 11044, -16989, -14469, -10335, 21498, 7934, 20198, 22502, -23210, -10906, 17442, -31636, 23860, -28644, 20257, -23998, -7756, 17422, -23132};
+
+// Same for zetas_basemul
+const int16_t zetas_basemul_shoup[128] = {17, -17, -568, 568, 583, -583, -680, 680, 1637, -1637, 723, -723, -1041, 1041, 1100, -1100, 1409, -1409, -667, 667, -48, 48, 233, -233, 756, -756, -1173, 1173, -314, 314, -279, 279, -1626, 1626, 1651, -1651, -540, 540, -1540, 1540, -1482, 1482, 952, -952, 1461, -1461, -642, 642, 939, -939, -1021, 1021, -892, 892, -941, 941, 733, -733, -992, 992, 268, -268, 641, -641, 1584, -1584, -1031, 1031, -1292, 1292, -109, 109, 375, -375, -780, 780, -1239, 1239, 1645, -1645, 1063, -1063, 319, -319, -556, 556, 757, -757, -1230, 1230, 561, -561, -863, 863, -735, 735, -525, 525, 1092, -1092, 403, -403, 1026, -1026, 1143, -1143, -1179, 1179, -554, 554, 886, -886, -1607, 1607, 1212, -1212, -1455, 1455, 1029, -1029, -1219, 1219, -394, 394, 885, -885, -1175, 1175};
+
+const int16_t zetas_basemul_shoup_quot[128] = {335, -335, -11182, 11182, 11477, -11477, -13387, 13387, 32227, -32227, 14233, -14233, -20494, 20494, 21655, -21655, 27738, -27738, -13131, 13131, -945, 945, 4587, -4587, 14883, -14883, -23092, 23092, -6182, 6182, -5493, 5493, -32010, 32010, 32502, -32502, -10631, 10631, -30317, 30317, -29175, 29175, 18741, -18741, 28762, -28762, -12639, 12639, 18486, -18486, -20100, 20100, -17560, 17560, -18525, 18525, 14430, -14430, -19529, 19529, 5276, -5276, 12619, -12619, 31183, -31183, -20297, 20297, -25435, 25435, -2146, 2146, 7382, -7382, -15355, 15355, -24391, 24391, 32384, -32384, 20927, -20927, 6280, -6280, -10946, 10946, 14903, -14903, -24214, 24214, 11044, -11044, -16989, 16989, -14469, 14469, -10335, 10335, 21498, -21498, 7934, -7934, 20198, -20198, 22502, -22502, -23210, 23210, -10906, 10906, 17442, -17442, -31636, 31636, 23860, -23860, -28644, 28644, 20257, -20257, -23998, 23998, -7756, 7756, 17422, -17422, -23132, 23132};
+
+// zetas_plantard[i] = (-2^32 * zetas_shoup[i] mod q) * q^-1 mod 2^32, as a signed 32-bit integer
+const int32_t zetas_plantard[128] = {1290167, -2064267850, -966335387, -51606696, -886345008, 812805466, -1847519726, 1094061961, 1370157786, -1819136043, 249002309, 1028263423, -700560902, -89021551, 734105254, -2042335004, 381889552, -1137927652, 1727534157, 1904287092, -365117376, 72249375, -1404992306, 1719793153, 1839778722, -1593356747, 690239562, -576704831, -1207596692, -580575333, -1748176836, 1059227441, 372858380, 427045412, -98052723, -2029433330, 1544330385, -1322421592, -1357256112, -1643673276, 838608814, -1744306333, -1052776604, 815385801, -598637677, 42575524, 1703020976, -1824296713, -1303069080, 1851390228, 1041165097, 583155668, 1855260730, -594767174, 1979116801, -1195985186, -879894171, -918599193, 1910737929, 836028479, -1103093132, -282546662, 1583035408, 1174052340, 21932846, -732815087, 752167598, -877313836, 2112004044, 932791035, -1343064270, 1419184147, 1817845876, -860541660, -61928036, 300609006, 975366559, -1513366368, -405112566, -359956706, -2097812203, 2130066388, -696690399, -1986857806, -1912028096, 1228239371, 1884934581, -828287475, 1211467195, -1317260922, -1150829327, -1214047529, 945692709, -1279846067, 345764865, 826997308, 2043625172, -1330162596, -1666896289, -140628247, 483812777, -1006330577, -1598517417, 2122325384, 1371447953, 411563403, -717333078, 976656727, -1586905910, 723783915, -1113414472, -948273044, -677337888, 1408862808, 519937465, 1323711759, 1474661346, -1521107372, -714752743, 1143088322, -2073299022, 1563682897, -1877193576, 1327582261, -1572714068, -508325958, 1141798155, -1515946703};
+
+// Same for zetas_basemul
+const int32_t zetas_basemul_plantard[128] = {21932846, -21932846, -732815087, 732815087, 752167598, -752167598, -877313836, 877313836, 2112004044, -2112004044, 932791035, -932791035, -1343064270, 1343064270, 1419184147, -1419184147, 1817845876, -1817845876, -860541660, 860541660, -61928036, 61928036, 300609006, -300609006, 975366559, -975366559, -1513366368, 1513366368, -405112566, 405112566, -359956706, 359956706, -2097812203, 2097812203, 2130066388, -2130066388, -696690399, 696690399, -1986857806, 1986857806, -1912028096, 1912028096, 1228239371, -1228239371, 1884934581, -1884934581, -828287475, 828287475, 1211467195, -1211467195, -1317260922, 1317260922, -1150829327, 1150829327, -1214047529, 1214047529, 945692709, -945692709, -1279846067, 1279846067, 345764865, -345764865, 826997308, -826997308, 2043625172, -2043625172, -1330162596, 1330162596, -1666896289, 1666896289, -140628247, 140628247, 483812777, -483812777, -1006330577, 1006330577, -1598517417, 1598517417, 2122325384, -2122325384, 1371447953, -1371447953, 411563403, -411563403, -717333078, 717333078, 976656727, -976656727, -1586905910, 1586905910, 723783915, -723783915, -1113414472, 1113414472, -948273044, 948273044, -677337888, 677337888, 1408862808, -1408862808, 519937465, -519937465, 1323711759, -1323711759, 1474661346, -1474661346, -1521107372, 1521107372, -714752743, 714752743, 1143088322, -1143088322, -2073299022, 2073299022, 1563682897, -1563682897, -1877193576, 1877193576, 1327582261, -1327582261, -1572714068, 1572714068, -508325958, 508325958, 1141798155, -1141798155, -1515946703, 1515946703};
+
+// Multiplications by zetas[i] and by zetas_basemul[i], with the reduction family selected by KYBER_REDUCE
+#if KYBER_REDUCE == KYBER_REDUCE_SHOUP
+#define ZETA_MUL(a, i) shoup_mul((a), zetas_shoup[i], zetas_shoup_quot[i])
+#define ZETA_BASEMUL_MUL(a, i) shoup_mul((a), zetas_basemul_shoup[i], zetas_basemul_shoup_quot[i])
+#elif KYBER_REDUCE == KYBER_REDUCE_PLANTARD
+#define ZETA_MUL(a, i) plantard_mul((a), zetas_plantard[i])
+#define ZETA_BASEMUL_MUL(a, i) plantard_mul((a), zetas_basemul_plantard[i])
+#else
+#define ZETA_MUL(a, i) fqmul(zetas[i], (a))
+#define ZETA_BASEMUL_MUL(a, i) fqmul((a), zetas_basemul[i])
+#endif
+
+/**
+ * @brief Sends an array to its NTT transform, with the variant installed in dispatch_table
+ */
+void NTT(int16_t tab[256]) {
+    dispatch_table.ntt(tab);
+}
+
 /**
  * @brief Sens an array to its NTT transform
  * @details FIPS 203 Algorithm 9
  */
-void NTT(int16_t tab[256]) {
-    int len, start, i, j;
-    int16_t zeta, t;
+void NTT_ref(int16_t tab[256]) {
+    int len, start, i, j, k;
+    int16_t t;
 
     i = 1;
 
     for (len = 128; len >= 2; len >>= 1) {
         for (start = 0; start < 256; start += 2*len) {
-            zeta = zetas[i++];
+            k = i++;
             for (j = start; j < start + len; j++) {
-                t = fqmul(zeta, tab[j + len]); 
+                t = ZETA_MUL(tab[j + len], k);
                 tab[j + len] = barrett_reduce(tab[j] - t);
                 tab[j] = barrett_reduce(tab[j] + t);
             }
@@ -39,33 +81,96 @@ void NTT(int16_t tab[256]) {
 }
 
 /**
- * @brief Sends an array to its inverse NTT transform
- * @details FIPS 203 Algorithm 10
+ * @brief Runs the layers of the inverse NTT from len = 2 up to len = last_len, without the final normalization
  */
-void NTT_inv(int16_t tab[256]) {
-    int len, start, i, j;
-    int16_t zeta, t;
+static void ntt_inv_layers(int16_t tab[256], const int last_len) {
+    int len, start, i, j, k;
+    int16_t t;
 
     i = 127;
 
-    for (len = 2; len <= 128; len <<= 1) {
+    for (len = 2; len <= last_len; len <<= 1) {
         for (start = 0; start < 256; start += 2*len) {
-            zeta = zetas[i--];
+            k = i--;
             for (j = start; j < start + len; j++) {
                 t = tab[j];
                 tab[j] = barrett_reduce(t + tab[j + len]);
-                tab[j + len] = fqmul(zeta, tab[j + len] - t);
+                tab[j + len] = ZETA_MUL(tab[j + len] - t, k);
             }
         }
     }
+}
+
+/**
+ * @brief Sends an array to its inverse NTT transform
+ * @details FIPS 203 Algorithm 10
+ */
+void NTT_inv(int16_t tab[256]) {
+    /*
+     * The inverse NTT need a final normalization which consists of multiplying by 128^{-1} = 3303 (mod q).
+     * Since we chose to do all the NTT computations inside the Montgomery domain, we shall also convert
+     * the above constant into the Montgomery domain. This means replacing it by 128^{-1} * 2^16 = 512 (mod q).
+     */
+    NTT_inv_scaled(tab, NTT_INV_FACTOR_R0);
+}
+
+/**
+ * @brief Inverse NTT transform followed by a multiplication of every coefficient by factor * R^{-1}
+ * @details The final normalization of NTT_inv is a Montgomery multiplication by a constant, so any change of
+ *          Montgomery domain can be folded into it for free. With factor = 128^{-1} * R^{e+1} (mod q), the output
+ *          is multiplied by R^e, see NTT_INV_FACTOR_* in consts.h.
+ * @param tab
+ * @param factor
+ */
+void NTT_inv_scaled(int16_t tab[256], const int16_t factor) {
+    dispatch_table.ntt_inv_scaled(tab, factor);
+}
+
+/**
+ * @brief Scalar variant of NTT_inv_scaled
+ */
+void NTT_inv_scaled_ref(int16_t tab[256], const int16_t factor) {
+    int j;
+
+    ntt_inv_layers(tab, 128);
 
     for (j = 0; j < 256; j++) {
-        /*
-         * The inverse NTT need a final normalization which consists of multiplying by 128^{-1} = 3303 (mod q).
-         * Since we chose to do all the NTT computations inside the Montgomery domain, we shall also convert
-         * the above constant into the Montgomery domain. This means replacing it by 128^{-1} * 2^16 = 512 (mod q).
-         */
-        tab[j] = fqmul(tab[j], 512);
+        tab[j] = fqmul(tab[j], factor);
+    }
+}
+
+/**
+ * @brief Last step of the encryption : r = Compress_d(NTT_inv_scaled(tab, factor) + e + Decompress_1(m))
+ * @details The last layer of the inverse NTT, the normalization (folded into the zeta of this layer), the noise and message
+ *          additions and the compression are all done coefficient-wise while the data is loaded once.
+ *          Gives the same result as NTT_inv_scaled, poly_add, poly_decompress, poly_add and poly_compress in a row.
+ *
+ * @param[out] r compressed coefficients, may alias tab
+ * @param[in] tab input in NTT domain, used as a scratch buffer
+ * @param[in] e noise added after the inverse NTT, coefficients should be small (|e_i| <= eta)
+ * @param[in] m message bits in {0,1} to decompress with d = 1 and add, or NULL if there is no message
+ * @param[in] factor normalization of the inverse NTT, see NTT_inv_scaled
+ * @param[in] d compression parameter
+ */
+void NTT_inv_add_compress(int16_t r[256], int16_t tab[256], const int16_t e[256], const int16_t m[256], const int16_t factor, const unsigned d) {
+    int j;
+    int16_t t, u, lo, hi;
+    const int16_t zeta = fqmul(zetas[1], factor); // zeta of the last layer times the normalization factor
+
+    ntt_inv_layers(tab, 64);
+
+    for (j = 0; j < 128; j++) {
+        t = tab[j];
+        u = tab[j + 128];
+        lo = fqmul(t + u, factor) + e[j];
+        hi = fqmul(u - t, zeta) + e[j + 128];
+        if (m != NULL) {
+            // Decompress_1(b) = (q+1)/2 * b, computed with a mask to be constant time in the message bits
+            lo += -m[j] & ((KYBER_Q + 1) / 2);
+            hi += -m[j + 128] & ((KYBER_Q + 1) / 2);
+        }
+        r[j] = compress(barrett_reduce(lo), d);
+        r[j + 128] = compress(barrett_reduce(hi), d);
     }
 }
 
@@ -79,28 +184,96 @@ void NTT_inv(int16_t tab[256]) {
  * @param a_1[in] degree 1 coefficient of the first polynomial
  * @param b_0[in] degree 0 coefficient of the second polynomial
  * @param b_1[in] degree 1 coefficient of the second polynomial
- * @param m[in] the product is computed modulo x^2 - m (should come from the table zetas_basemul)
+ * @param i[in] the product is computed modulo x^2 - zetas_basemul[i]
  */
-void BaseCaseMultiply(int16_t* r0, int16_t* r1, const int16_t* a0, const int16_t* a1, const int16_t* b0, const int16_t* b1, const int16_t* m) {
+KYBER_INTERNAL void BaseCaseMultiply(int16_t* r0, int16_t* r1, const int16_t* a0, const int16_t* a1, const int16_t* b0, const int16_t* b1, const int i) {
 
     *r0 = fqmul(*a1, *b1);
-    *r0 = fqmul(*r0, *m);
+    *r0 = ZETA_BASEMUL_MUL(*r0, i);
     *r0 += fqmul(*a0, *b0);
     *r1 = fqmul(*a0, *b1) + fqmul(*a1, *b0);
 }
 
+/**
+ * @brief Multiplies two NTT together, with the variant installed in dispatch_table
+ */
+void NTT_multiply(int16_t r[256], const int16_t a[256], const int16_t b[256]) {
+    dispatch_table.ntt_multiply(r, a, b);
+}
+
 /**
  * @brief Multiplies two NTT together
  * @details Algorithm 11 FIPS 203
  */
-void NTT_multiply(int16_t r[256], const int16_t a[256], const int16_t b[256]) {
+void NTT_multiply_ref(int16_t r[256], const int16_t a[256], const int16_t b[256]) {
     int i = 0;
     int16_t r0;
     int16_t r1;
 
     for (i = 0; i < 128; i++) {
-        BaseCaseMultiply(&r0, &r1, &a[2*i], &a[2*i + 1], &b[2*i], &b[2*i + 1], &zetas_basemul[i]);
+        BaseCaseMultiply(&r0, &r1, &a[2*i], &a[2*i + 1], &b[2*i], &b[2*i + 1], i);
         r[2*i] = r0;
         r[2*i + 1] = r1;
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Precomputes the part of NTT_multiply that only depends on its first operand
+ * @details cache[i] = a[2i+1] * zetas_basemul[i], so that multiplying by a takes 4 Montgomery multiplications per
+ *          coefficient pair instead of 5.
+ *
+ * @param[out] cache
+ * @param[in] a NTT of the operand
+ */
+void NTT_multiply_cache(int16_t cache[128], const int16_t a[256]) {
+    int i;
+
+    for (i = 0; i < 128; i++) {
+        cache[i] = ZETA_BASEMUL_MUL(a[2*i + 1], i);
+    }
+}
+
+/**
+ * @brief Multiplies two NTT together using the precomputation of NTT_multiply_cache on the first one
+ * @details Gives the same result as NTT_multiply(r, a, b) : fqmul and the multiplication by a zeta return canonical
+ *          values, so multiplying a[2i+1] by the zeta before b[2i+1] instead of after gives the same coefficients
+ *
+ * @param[out] r may alias b
+ * @param[in] a NTT of the first operand
+ * @param[in] a_cache output of NTT_multiply_cache(a_cache, a)
+ * @param[in] b NTT of the second operand
+ */
+void NTT_multiply_cached(int16_t r[256], const int16_t a[256], const int16_t a_cache[128], const int16_t b[256]) {
+    int i;
+    int16_t b0, b1;
+
+    for (i = 0; i < 128; i++) {
+        b0 = b[2*i];
+        b1 = b[2*i + 1];
+        r[2*i] = fqmul(a[2*i], b0) + fqmul(a_cache[i], b1);
+        r[2*i + 1] = fqmul(a[2*i], b1) + fqmul(a[2*i + 1], b0);
+    }
+}
+
+/**
+ * @brief Multiplies two NTT together, the first one being stored packed on 12 bits per coefficient
+ * @details Gives the same result as NTT_multiply. The 3 bytes a[3i], a[3i+1], a[3i+2] hold exactly the coefficient
+ *          pair (a_{2i}, a_{2i+1}) of the i-th base case multiplication, so each pair is unpacked in registers right
+ *          before being used and the unpacked polynomial never goes through memory.
+ *
+ * @param[out] r may alias b
+ * @param[in] a NTT of the first operand, packed by poly_pack
+ * @param[in] b NTT of the second operand
+ */
+void NTT_multiply_packed(int16_t r[256], const uint8_t a[384], const int16_t b[256]) {
+    int i;
+    int16_t a0, a1, b0, b1;
+
+    for (i = 0; i < 128; i++) {
+        a0 = (int16_t)(a[3*i] | ((a[3*i + 1] & 0x0F) << 8));
+        a1 = (int16_t)((a[3*i + 1] >> 4) | (a[3*i + 2] << 4));
+        b0 = b[2*i];
+        b1 = b[2*i + 1];
+        BaseCaseMultiply(&r[2*i], &r[2*i + 1], &a0, &a1, &b0, &b1, i);
+    }
+}
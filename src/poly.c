@@ -4,7 +4,10 @@
  * @author Gabriel Abauzit
  */
 
+#include <stdio.h>
 #include "poly.h"
+#include "poly_avx2.h"
+#include "dispatch.h"
 
 /***********************/
 /* UTILITARY FUNCTIONS */
@@ -28,7 +31,7 @@ void poly_zero(poly_t* f) {
  * @param f
  * @return 0 if valid, 1 otherwise
  */
-int poly_is_valid(const poly_t* f) {
+int poly_is_valid_ref(const poly_t* f) {
     int i;
     int is_valid = 1;
     int16_t temp;
@@ -41,10 +44,23 @@ int poly_is_valid(const poly_t* f) {
     return 1 - is_valid;
 }
 
+/**
+ * @brief Checks if the coefficients are in their canonical form in constant time, see poly_is_valid_ref
+ * @return 0 if valid, 1 otherwise
+ */
+int poly_is_valid(const poly_t* f) {
+#ifdef POLY_AVX2_AVAILABLE
+    if (poly_avx2_supported()) {
+        return poly_is_valid_avx2(f);
+    }
+#endif
+    return poly_is_valid_ref(f);
+}
+
 /**
  * @brief Reduces all the coefficients into their canonical form i.e in [-(q-1)/2,(q-1)/2]
  */
-void poly_reduce(poly_t* f) {
+void poly_reduce_ref(poly_t* f) {
     int i;
 
     for (i = 0; i < KYBER_N; i++) {
@@ -52,6 +68,43 @@ void poly_reduce(poly_t* f) {
     }
 }
 
+/**
+ * @brief Reduces all the coefficients into their canonical form, see poly_reduce_ref
+ */
+void poly_reduce(poly_t* f) {
+#ifdef POLY_AVX2_AVAILABLE
+    if (poly_avx2_supported()) {
+        poly_reduce_avx2(f);
+        return;
+    }
+#endif
+    poly_reduce_ref(f);
+}
+
+/**
+ * @brief Checks that every coefficient of f is in [-bound, bound]
+ * @return 0 if it is, 1 otherwise
+ */
+int poly_within_bound(const poly_t* f, const int16_t bound) {
+    int i;
+
+    for (i = 0; i < KYBER_N; i++) {
+        if (f->coeffs[i] < -bound || f->coeffs[i] > bound) return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Aborts with the position of the check if a coefficient of f is out of [-bound, bound], see POLY_ASSERT_BOUND
+ * @details Not constant time, only meant for debug builds.
+ */
+void poly_assert_bound(const poly_t* f, const int16_t bound, const char* file, const int line) {
+    if (poly_within_bound(f, bound) == EXIT_FAILURE) {
+        fprintf(stderr, "%s:%d: coefficient out of [-%d, %d]\n", file, line, bound, bound);
+        abort();
+    }
+}
+
 /**
  * @brief Checks equality between two polynomials in constant time
  * @details The polynomial entries should be in their canonical form
@@ -98,7 +151,7 @@ void poly_copy(poly_t* target, const poly_t* source) {
 /**
  * @brief Sends all the coefficients into Montgomery domain
  */
-void poly_to_montgomery(poly_t* f) {
+void poly_to_montgomery_ref(poly_t* f) {
     int i;
 
     for (i = 0; i < KYBER_N; i++) {
@@ -106,10 +159,23 @@ void poly_to_montgomery(poly_t* f) {
     }
 }
 
+/**
+ * @brief Sends all the coefficients into Montgomery domain, see poly_to_montgomery_ref
+ */
+void poly_to_montgomery(poly_t* f) {
+#ifdef POLY_AVX2_AVAILABLE
+    if (poly_avx2_supported()) {
+        poly_to_montgomery_avx2(f);
+        return;
+    }
+#endif
+    poly_to_montgomery_ref(f);
+}
+
 /**
  * @brief Applies Montgomery reduction to all the coefficients
  */
-void poly_from_montgomery(poly_t* f) {
+void poly_from_montgomery_ref(poly_t* f) {
     int i;
 
     for (i = 0; i < KYBER_N; i++) {
@@ -117,6 +183,19 @@ void poly_from_montgomery(poly_t* f) {
     }
 }
 
+/**
+ * @brief Applies Montgomery reduction to all the coefficients, see poly_from_montgomery_ref
+ */
+void poly_from_montgomery(poly_t* f) {
+#ifdef POLY_AVX2_AVAILABLE
+    if (poly_avx2_supported()) {
+        poly_from_montgomery_avx2(f);
+        return;
+    }
+#endif
+    poly_from_montgomery_ref(f);
+}
+
 /********************************/
 /* ARITHMETIC OPERATIONS IN R_q */
 /********************************/
@@ -124,7 +203,7 @@ void poly_from_montgomery(poly_t* f) {
 /**
  * @brief Addition in R_q
  */
-void poly_add(poly_t* r, const poly_t* a, const poly_t* b) {
+void poly_add_ref(poly_t* r, const poly_t* a, const poly_t* b) {
     int i;
 
     for (i = 0; i < KYBER_N; i++) {
@@ -132,10 +211,23 @@ void poly_add(poly_t* r, const poly_t* a, const poly_t* b) {
     }
 }
 
+/**
+ * @brief Addition in R_q, see poly_add_ref
+ */
+void poly_add(poly_t* r, const poly_t* a, const poly_t* b) {
+#ifdef POLY_AVX2_AVAILABLE
+    if (poly_avx2_supported()) {
+        poly_add_avx2(r, a, b);
+        return;
+    }
+#endif
+    poly_add_ref(r, a, b);
+}
+
 /**
  * @brief Subtraction in R_q
  */
-void poly_sub(poly_t* r, const poly_t* a, const poly_t* b) {
+void poly_sub_ref(poly_t* r, const poly_t* a, const poly_t* b) {
     int i;
 
     for (i = 0; i < KYBER_N; i++) {
@@ -143,40 +235,79 @@ void poly_sub(poly_t* r, const poly_t* a, const poly_t* b) {
     }
 }
 
+/**
+ * @brief Subtraction in R_q, see poly_sub_ref
+ */
+void poly_sub(poly_t* r, const poly_t* a, const poly_t* b) {
+#ifdef POLY_AVX2_AVAILABLE
+    if (poly_avx2_supported()) {
+        poly_sub_avx2(r, a, b);
+        return;
+    }
+#endif
+    poly_sub_ref(r, a, b);
+}
+
+/**
+ * @brief Addition in R_q without reduction
+ * @details The bound of r is the sum of the bounds of a and b, which must be at most INT16_MAX, see POLY_BOUND_*
+ */
+void poly_add_noreduce(poly_t* r, const poly_t* a, const poly_t* b) {
+    int i;
+
+    for (i = 0; i < KYBER_N; i++) {
+        r->coeffs[i] = (int16_t)(a->coeffs[i] + b->coeffs[i]);
+    }
+}
+
+/**
+ * @brief Subtraction in R_q without reduction, see poly_add_noreduce
+ */
+void poly_sub_noreduce(poly_t* r, const poly_t* a, const poly_t* b) {
+    int i;
+
+    for (i = 0; i < KYBER_N; i++) {
+        r->coeffs[i] = (int16_t)(a->coeffs[i] - b->coeffs[i]);
+    }
+}
+
 /**
  * @brief Fast multiplication in R_q using NTT
+ * @details NTT_multiply returns a * b * R^{-1}, the correction by R is folded into the final normalization of the inverse NTT
+ *          so that no conversion to or from the Montgomery domain is needed.
  */
 void poly_mult(poly_t* r, const poly_t* a, const poly_t* b) {
-    poly_t* a_copy = (poly_t*)malloc(sizeof(poly_t));
-    poly_t* b_copy = (poly_t*)malloc(sizeof(poly_t));
+    poly_t a_hat, b_hat;
 
-    poly_copy(a_copy, a);
-    poly_copy(b_copy, b);
+    poly_copy(&a_hat, a);
+    poly_copy(&b_hat, b);
 
-    poly_to_montgomery(a_copy);
-    poly_to_montgomery(b_copy);
+    NTT(a_hat.coeffs);
+    NTT(b_hat.coeffs);
+    NTT_multiply(r->coeffs, a_hat.coeffs, b_hat.coeffs);
 
-    NTT(a_copy->coeffs);
-    NTT(b_copy->coeffs);
-    NTT_multiply(r->coeffs, a_copy->coeffs, b_copy->coeffs);
+    poly_zero(&a_hat);
+    poly_zero(&b_hat);
 
-    poly_secure_free(&a_copy);
-    poly_secure_free(&b_copy);
-
-    NTT_inv(r->coeffs);
-    poly_from_montgomery(r);
-    poly_reduce(r);
+    NTT_inv_scaled(r->coeffs, NTT_INV_FACTOR_R1);
 }
 
 /*********************************/
 /* COMPRESSION AND DECOMPRESSION */
 /*********************************/
 
+/**
+ * @brief Compresses all the coefficients of f, with the variant installed in dispatch_table
+ */
+void poly_compress(poly_t* f, const unsigned d) {
+    dispatch_table.poly_compress(f, d);
+}
+
 /**
  * @brief Compresses all the coefficients of f
  * @param f 
  */
-void poly_compress(poly_t* f, const unsigned d) {
+void poly_compress_ref(poly_t* f, const unsigned d) {
     int i;
 
     for (i = 0; i < KYBER_N; i++) {
@@ -188,10 +319,372 @@ void poly_compress(poly_t* f, const unsigned d) {
  * @brief Decompresses all the coefficients of f
  * @param f 
  */
-void poly_decompress(poly_t* f, const unsigned d) {
+void poly_decompress_ref(poly_t* f, const unsigned d) {
     int i;
 
     for (i = 0; i < KYBER_N; i++) {
         f->coeffs[i] = decompress(f->coeffs[i], d);
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Decompresses all the coefficients of f, see poly_decompress_ref
+ */
+void poly_decompress(poly_t* f, const unsigned d) {
+#ifdef POLY_AVX2_AVAILABLE
+    if (poly_avx2_supported()) {
+        poly_decompress_avx2(f, d);
+        return;
+    }
+#endif
+    poly_decompress_ref(f, d);
+}
+
+/**
+ * @brief Computes Compress_d(NTT_inv(f) + e + Decompress_1(m)), the tail of v in K-PKE.Encrypt, in a single pass for the last layer
+ * @details f is expected to be an output of NTT_multiply or polyvec_ntt_scalar_product on operands in the NTT domain,
+ *          which carries a factor R^{-1} that is removed by the inverse NTT normalization.
+ * @param[out] r compressed polynomial, may alias f
+ * @param[in] f polynomial in the NTT domain, overwritten
+ * @param[in] e noise polynomial
+ * @param[in] m message bits in {0,1}, NULL if there is no message to add
+ * @param[in] d
+ */
+void poly_ntt_inv_add_compress(poly_t* r, poly_t* f, const poly_t* e, const poly_t* m, const unsigned d) {
+    NTT_inv_add_compress(r->coeffs, f->coeffs, e->coeffs, m == NULL ? NULL : m->coeffs, NTT_INV_FACTOR_R1, d);
+}
+
+/********************/
+/* MESSAGE ENCODING */
+/********************/
+
+/**
+ * @brief Turns a 32-byte message into a polynomial, same as byte_decode with d = 1 followed by poly_decompress with d = 1
+ * @details Constant time in the message : every bit becomes a mask selecting (q+1)/2 or 0
+ * @param[out] r
+ * @param[in] msg
+ */
+void poly_frommsg_ref(poly_t* r, const uint8_t msg[KYBER_N / 8]) {
+    int i, j;
+    int16_t mask;
+
+    for (i = 0; i < KYBER_N / 8; i++) {
+        for (j = 0; j < 8; j++) {
+            mask = -(int16_t)((msg[i] >> j) & 1);
+            r->coeffs[8*i + j] = mask & ((KYBER_Q + 1) / 2);
+        }
+    }
+}
+
+/**
+ * @brief Turns a polynomial into a 32-byte message, same as poly_compress with d = 1 followed by byte_encode with d = 1
+ * @details Constant time in the coefficients : Compress_1(x) = 1 exactly when |x| > (q-1)/4, which is the sign bit
+ *          of (q-1)/4 - |x|, |x| being computed with a mask.
+ * @param[out] msg
+ * @param[in] f coefficients should be in their canonical form
+ */
+void poly_tomsg_ref(uint8_t msg[KYBER_N / 8], const poly_t* f) {
+    int i, j;
+    int16_t x, sign;
+
+    for (i = 0; i < KYBER_N / 8; i++) {
+        msg[i] = 0;
+        for (j = 0; j < 8; j++) {
+            x = f->coeffs[8*i + j];
+            sign = x >> 15;
+            x = (x ^ sign) - sign;
+            msg[i] |= (uint8_t)((((KYBER_Q - 1) / 4 - x) >> 15) & 1) << j;
+        }
+    }
+}
+
+/**
+ * @brief Turns a 32-byte message into a polynomial, see poly_frommsg_ref
+ */
+void poly_frommsg(poly_t* r, const uint8_t msg[KYBER_N / 8]) {
+#ifdef POLY_AVX2_AVAILABLE
+    if (poly_avx2_supported()) {
+        poly_frommsg_avx2(r, msg);
+        return;
+    }
+#endif
+    poly_frommsg_ref(r, msg);
+}
+
+/**
+ * @brief Turns a polynomial into a 32-byte message, see poly_tomsg_ref
+ */
+void poly_tomsg(uint8_t msg[KYBER_N / 8], const poly_t* f) {
+#ifdef POLY_AVX2_AVAILABLE
+    if (poly_avx2_supported()) {
+        poly_tomsg_avx2(msg, f);
+        return;
+    }
+#endif
+    poly_tomsg_ref(msg, f);
+}
+
+/**
+ * @brief Expands a 32-byte message to its bits in {0,1}, the message input of poly_ntt_inv_add_compress
+ * @details Same output as byte_decode with d = 1, without its allocation and in constant time : every bit is only
+ *          shifted and masked, as in poly_frommsg_ref
+ * @param[out] r
+ * @param[in] msg
+ */
+void poly_frommsg_bits(poly_t* r, const uint8_t msg[KYBER_N / 8]) {
+    int i, j;
+
+    for (i = 0; i < KYBER_N / 8; i++) {
+        for (j = 0; j < 8; j++) {
+            r->coeffs[8*i + j] = (int16_t)((msg[i] >> j) & 1);
+        }
+    }
+}
+
+/***************************/
+/* CHECKED 12-BIT DECODING */
+/***************************/
+
+/**
+ * @brief ByteDecode_12 fused with the FIPS 203 modulus check of the encapsulation key, in constant time
+ * @details Same coefficients as byte_decode with d = 12. Every coefficient x is checked against q while it is decoded,
+ *          the sign bits of (q-1) - x are accumulated without branching, there is no early exit.
+ * @param[out] f
+ * @param[in] bytes
+ * @return 0 if all the coefficients are smaller than q (ie bytes re-encodes to itself), 1 otherwise
+ */
+int poly_decode12_checked_ref(poly_t* f, const uint8_t bytes[32 * 12]) {
+    int i;
+    int16_t x0, x1;
+    int16_t invalid = 0;
+
+    for (i = 0; i < KYBER_N / 2; i++) {
+        x0 = (int16_t)(bytes[3*i] | ((bytes[3*i + 1] & 0x0F) << 8));
+        x1 = (int16_t)((bytes[3*i + 1] >> 4) | (bytes[3*i + 2] << 4));
+        invalid |= (KYBER_Q - 1) - x0;
+        invalid |= (KYBER_Q - 1) - x1;
+        f->coeffs[2*i] = x0;
+        f->coeffs[2*i + 1] = x1;
+    }
+
+    return (invalid >> 15) & 1;
+}
+
+/**
+ * @brief ByteDecode_12 fused with the modulus check, see poly_decode12_checked_ref
+ */
+int poly_decode12_checked(poly_t* f, const uint8_t bytes[32 * 12]) {
+#ifdef POLY_AVX2_AVAILABLE
+    if (poly_avx2_supported()) {
+        return poly_decode12_checked_avx2(f, bytes);
+    }
+#endif
+    return poly_decode12_checked_ref(f, bytes);
+}
+
+/*****************************/
+/* DOMAIN-TAGGED POLYNOMIALS */
+/*****************************/
+
+// mont_factors[1 + e] = R^{e+1} (mod q), fqmul(x, mont_factors[1 + e]) = x * R^e (mod q)
+static const int16_t mont_factors[4] = {1, MONTGOMERY_R, MONTGOMERY_R2, MONTGOMERY_R3};
+
+// ntt_inv_factors[1 + e] is the final normalization of NTT_inv_scaled which multiplies the output by R^e
+static const int16_t ntt_inv_factors[4] = {NTT_INV_FACTOR_RM1, NTT_INV_FACTOR_R0, NTT_INV_FACTOR_R1, NTT_INV_FACTOR_R2};
+
+/**
+ * @brief Power of R carried by the coefficients of a polynomial in the given domain
+ */
+static int montgomery_exponent(const poly_domain_t domain) {
+    return (domain & POLY_MONTGOMERY) ? 1 : 0;
+}
+
+/**
+ * @brief Multiplies all the coefficients by R^e, e in {-1, 1, 2}
+ */
+static void poly_scale_montgomery(poly_t* f, const int e) {
+    int i;
+    const int16_t factor = mont_factors[1 + e];
+
+    for (i = 0; i < KYBER_N; i++) {
+        f->coeffs[i] = fqmul(f->coeffs[i], factor);
+    }
+}
+
+/**
+ * @brief Initializes a domain-tagged polynomial
+ * @param[out] f
+ * @param[in] source coefficients of f, already in the given domain
+ * @param[in] domain
+ */
+void poly_dom_init(poly_dom_t* f, const poly_t* source, const poly_domain_t domain) {
+    poly_copy(&f->poly, source);
+    f->domain = domain;
+}
+
+/**
+ * @brief Sends f to the given domain, skipping the conversions that are not needed
+ * @details When leaving the NTT domain, the change of Montgomery domain is folded into the inverse NTT normalization.
+ */
+void poly_dom_convert(poly_dom_t* f, const poly_domain_t domain) {
+    const int e = montgomery_exponent(domain) - montgomery_exponent(f->domain);
+
+    if (f->domain == domain) return;
+
+    if ((f->domain & POLY_NTT) && !(domain & POLY_NTT)) {
+        NTT_inv_scaled(f->poly.coeffs, ntt_inv_factors[1 + e]);
+    }
+    else {
+        if (e != 0) {
+            poly_scale_montgomery(&f->poly, e);
+        }
+        if (!(f->domain & POLY_NTT) && (domain & POLY_NTT)) {
+            NTT(f->poly.coeffs);
+        }
+    }
+
+    f->domain = domain;
+}
+
+/**
+ * @brief Multiplication in R_q of domain-tagged polynomials
+ * @details The operands are sent to the NTT domain if they are not already, whatever their Montgomery domain is.
+ *          NTT_multiply removes one power of R, this is corrected at the same time as the product is sent to the
+ *          requested domain, that is inside the inverse NTT normalization or in a single scaling pass.
+ *          If the product stays in the NTT domain, its coefficients lie in ]-q,q[.
+ * @param[out] r may alias a or b
+ * @param[in] a
+ * @param[in] b
+ * @param[in] domain domain of the product
+ */
+void poly_dom_mult(poly_dom_t* r, const poly_dom_t* a, const poly_dom_t* b, const poly_domain_t domain) {
+    poly_t a_hat, b_hat;
+    const int16_t* pa = a->poly.coeffs;
+    const int16_t* pb = b->poly.coeffs;
+    const int e = montgomery_exponent(domain) - (montgomery_exponent(a->domain) + montgomery_exponent(b->domain) - 1);
+
+    if (!(a->domain & POLY_NTT)) {
+        poly_copy(&a_hat, &a->poly);
+        NTT(a_hat.coeffs);
+        pa = a_hat.coeffs;
+    }
+    if (!(b->domain & POLY_NTT)) {
+        poly_copy(&b_hat, &b->poly);
+        NTT(b_hat.coeffs);
+        pb = b_hat.coeffs;
+    }
+
+    NTT_multiply(r->poly.coeffs, pa, pb);
+
+    poly_zero(&a_hat);
+    poly_zero(&b_hat);
+
+    if (domain & POLY_NTT) {
+        if (e != 0) {
+            poly_scale_montgomery(&r->poly, e);
+        }
+    }
+    else {
+        NTT_inv_scaled(r->poly.coeffs, ntt_inv_factors[1 + e]);
+    }
+
+    r->domain = domain;
+}
+
+/******************************/
+/* NTT-CACHED MULTIPLICATIONS */
+/******************************/
+
+/**
+ * @brief Computes once the NTT of a and its basemul precomputation
+ * @param[out] cache
+ * @param[in] a polynomial in the normal domain
+ */
+void poly_ntt_cache_init(poly_ntt_cache_t* cache, const poly_t* a) {
+    poly_copy(&cache->hat, a);
+    NTT(cache->hat.coeffs);
+    NTT_multiply_cache(cache->mulcache, cache->hat.coeffs);
+}
+
+/**
+ * @brief Allocates and initializes a handle on the NTT form of a
+ * @return the handle, NULL if the allocation failed. It should be released with poly_ntt_cache_secure_free
+ */
+poly_ntt_cache_t* poly_ntt_cache_new(const poly_t* a) {
+    poly_ntt_cache_t* cache = (poly_ntt_cache_t*)malloc(sizeof(poly_ntt_cache_t));
+
+    if (cache == NULL) return NULL;
+
+    poly_ntt_cache_init(cache, a);
+    return cache;
+}
+
+/**
+ * @brief Safely frees up a handle created by poly_ntt_cache_new
+ * @param ptr points to the pointer to the memory space to free
+ */
+void poly_ntt_cache_secure_free(poly_ntt_cache_t** ptr) {
+    int i;
+    volatile int16_t* mulcache;
+
+    if (ptr == NULL || *ptr == NULL) return;
+
+    poly_zero(&(*ptr)->hat);
+    mulcache = (*ptr)->mulcache;
+    for (i = 0; i < KYBER_N / 2; i++) {
+        mulcache[i] = 0;
+    }
+
+    free(*ptr);
+    *ptr = NULL;
+}
+
+/**
+ * @brief Multiplication in R_q by a cached operand, costs one NTT and one inverse NTT
+ * @param[out] r may alias b
+ * @param[in] a handle on the first operand
+ * @param[in] b polynomial in the normal domain
+ */
+void poly_mult_cached(poly_t* r, const poly_ntt_cache_t* a, const poly_t* b) {
+    poly_copy(r, b);
+    NTT(r->coeffs);
+    NTT_multiply_cached(r->coeffs, a->hat.coeffs, a->mulcache, r->coeffs);
+    NTT_inv_scaled(r->coeffs, NTT_INV_FACTOR_R1);
+}
+
+/**********************/
+/* PACKED POLYNOMIALS */
+/**********************/
+
+/**
+ * @brief Packs f on 12 bits per coefficient
+ * @details The coefficients are reduced and sent to [0, q) first, so any representative of f can be packed.
+ *          Branch-free, f may be secret.
+ */
+void poly_pack(poly_packed_t* r, const poly_t* f) {
+    int i;
+    uint16_t x0, x1;
+
+    for (i = 0; i < KYBER_N / 2; i++) {
+        x0 = (uint16_t)barrett_reduce(f->coeffs[2*i]);
+        x1 = (uint16_t)barrett_reduce(f->coeffs[2*i + 1]);
+        x0 += (uint16_t)(((int16_t)x0 >> 15) & KYBER_Q);
+        x1 += (uint16_t)(((int16_t)x1 >> 15) & KYBER_Q);
+        r->bytes[3*i] = (uint8_t)x0;
+        r->bytes[3*i + 1] = (uint8_t)((x0 >> 8) | (x1 << 4));
+        r->bytes[3*i + 2] = (uint8_t)(x1 >> 4);
+    }
+}
+
+/**
+ * @brief Unpacks a polynomial packed by poly_pack, the coefficients are given back in their canonical form
+ */
+void poly_unpack(poly_t* r, const poly_packed_t* f) {
+    int i;
+    const uint8_t* b = f->bytes;
+
+    for (i = 0; i < KYBER_N / 2; i++) {
+        r->coeffs[2*i] = barrett_reduce((int16_t)(b[3*i] | ((b[3*i + 1] & 0x0F) << 8)));
+        r->coeffs[2*i + 1] = barrett_reduce((int16_t)((b[3*i + 1] >> 4) | (b[3*i + 2] << 4)));
+    }
+}
@@ -0,0 +1,307 @@
+/**
+ * @file poly_avx2.c
+ * @brief AVX2 kernels for coefficient-wise operations on polynomials
+ * @author Gabriel Abauzit
+ */
+
+#include "poly_avx2.h"
+
+#ifdef POLY_AVX2_AVAILABLE
+
+#include <immintrin.h>
+
+#define AVX2 __attribute__((target("avx2")))
+
+/**
+ * @brief Checks at runtime whether the host supports AVX2
+ * @return 1 if it does, 0 otherwise
+ */
+int poly_avx2_supported(void) {
+    return __builtin_cpu_supports("avx2") ? 1 : 0;
+}
+
+/**********************/
+/* MODULAR REDUCTIONS */
+/**********************/
+
+/**
+ * @brief barrett_reduce on 16 lanes, same output for every 16-bit input
+ * @details mulhi gives floor(v * a / 2^16), and mulhrs by 2^5 the rounding (x + 2^9) >> 10 of it : together the
+ *          (v * a + 2^25) >> 26 of the scalar version.
+ */
+AVX2 static inline __m256i barrett_reduce_avx2(const __m256i a) {
+    __m256i t;
+
+    t = _mm256_mulhi_epi16(a, _mm256_set1_epi16(BARRETT_FACTOR));
+    t = _mm256_mulhrs_epi16(t, _mm256_set1_epi16(1 << 5));
+    return _mm256_sub_epi16(a, _mm256_mullo_epi16(t, _mm256_set1_epi16(KYBER_Q)));
+}
+
+/**
+ * @brief montgomery_reduce of the 32-bit products hi * 2^16 + lo on 16 lanes
+ * @details t * q has the same low half as the product, so the high half of their difference is hi - mulhi(t, q).
+ */
+AVX2 static inline __m256i montgomery_reduce_avx2(const __m256i lo, const __m256i hi) {
+    __m256i t;
+
+    t = _mm256_mullo_epi16(lo, _mm256_set1_epi16((int16_t)MONTGOMERY_QINV));
+    t = _mm256_sub_epi16(hi, _mm256_mulhi_epi16(t, _mm256_set1_epi16(KYBER_Q)));
+    return barrett_reduce_avx2(t);
+}
+
+/**
+ * @brief Same output as poly_reduce_ref
+ */
+AVX2 void poly_reduce_avx2(poly_t* f) {
+    int i;
+    __m256i x;
+
+    for (i = 0; i < KYBER_N / 16; i++) {
+        x = _mm256_loadu_si256((const __m256i*)&f->coeffs[16*i]);
+        _mm256_storeu_si256((__m256i*)&f->coeffs[16*i], barrett_reduce_avx2(x));
+    }
+}
+
+/**
+ * @brief Same output as poly_to_montgomery_ref, fqmul by R^2 on 16 lanes
+ */
+AVX2 void poly_to_montgomery_avx2(poly_t* f) {
+    int i;
+    __m256i x;
+    const __m256i r2 = _mm256_set1_epi16(MONTGOMERY_R2);
+
+    for (i = 0; i < KYBER_N / 16; i++) {
+        x = _mm256_loadu_si256((const __m256i*)&f->coeffs[16*i]);
+        x = montgomery_reduce_avx2(_mm256_mullo_epi16(x, r2), _mm256_mulhi_epi16(x, r2));
+        _mm256_storeu_si256((__m256i*)&f->coeffs[16*i], x);
+    }
+}
+
+/**
+ * @brief Same output as poly_from_montgomery_ref, the high half of a sign-extended coefficient is its sign
+ */
+AVX2 void poly_from_montgomery_avx2(poly_t* f) {
+    int i;
+    __m256i x;
+
+    for (i = 0; i < KYBER_N / 16; i++) {
+        x = _mm256_loadu_si256((const __m256i*)&f->coeffs[16*i]);
+        x = montgomery_reduce_avx2(x, _mm256_srai_epi16(x, 15));
+        _mm256_storeu_si256((__m256i*)&f->coeffs[16*i], x);
+    }
+}
+
+/**************/
+/* ARITHMETIC */
+/**************/
+
+/**
+ * @brief Same output as poly_add_ref, the sums wrap to 16 bits before the reduction as in the scalar version
+ */
+AVX2 void poly_add_avx2(poly_t* r, const poly_t* a, const poly_t* b) {
+    int i;
+    __m256i x, y;
+
+    for (i = 0; i < KYBER_N / 16; i++) {
+        x = _mm256_loadu_si256((const __m256i*)&a->coeffs[16*i]);
+        y = _mm256_loadu_si256((const __m256i*)&b->coeffs[16*i]);
+        _mm256_storeu_si256((__m256i*)&r->coeffs[16*i], barrett_reduce_avx2(_mm256_add_epi16(x, y)));
+    }
+}
+
+/**
+ * @brief Same output as poly_sub_ref
+ */
+AVX2 void poly_sub_avx2(poly_t* r, const poly_t* a, const poly_t* b) {
+    int i;
+    __m256i x, y;
+
+    for (i = 0; i < KYBER_N / 16; i++) {
+        x = _mm256_loadu_si256((const __m256i*)&a->coeffs[16*i]);
+        y = _mm256_loadu_si256((const __m256i*)&b->coeffs[16*i]);
+        _mm256_storeu_si256((__m256i*)&r->coeffs[16*i], barrett_reduce_avx2(_mm256_sub_epi16(x, y)));
+    }
+}
+
+/*********************************/
+/* COMPRESSION AND DECOMPRESSION */
+/*********************************/
+
+/**
+ * @brief Same output as poly_compress_ref for coefficients in [-q, q)
+ * @details The coefficients are first sent to [0, q). For d <= 7, mulhi by round(2^26 / q) estimates x * 2^10 / q and
+ *          mulhrs rounds it to d bits. For d = 10 and 11, this estimate is one too large on some inputs, the sign of
+ *          the low half of x * 8v minus a small offset tells which ones and they are corrected before the rounding.
+ *          Both were checked against compress on all of [0, q). Other values of d take the scalar path.
+ */
+AVX2 void poly_compress_avx2(poly_t* f, const unsigned d) {
+    int i;
+    __m256i x, lo, t;
+    const __m256i v = _mm256_set1_epi16(BARRETT_FACTOR);
+    const __m256i v8 = _mm256_set1_epi16((int16_t)(BARRETT_FACTOR << 3));
+    const __m256i q = _mm256_set1_epi16(KYBER_Q);
+    const __m256i mask = _mm256_set1_epi16((int16_t)((1 << d) - 1));
+    __m256i off, shift;
+
+    if (d >= 1 && d <= 7) {
+        shift = _mm256_set1_epi16((int16_t)(1 << (d + 5)));
+        for (i = 0; i < KYBER_N / 16; i++) {
+            x = _mm256_loadu_si256((const __m256i*)&f->coeffs[16*i]);
+            x = _mm256_add_epi16(x, _mm256_and_si256(_mm256_srai_epi16(x, 15), q));
+            x = _mm256_mulhrs_epi16(_mm256_mulhi_epi16(x, v), shift);
+            _mm256_storeu_si256((__m256i*)&f->coeffs[16*i], _mm256_and_si256(x, mask));
+        }
+    }
+    else if (d == 10 || d == 11) {
+        off = _mm256_set1_epi16(d == 10 ? 15 : 36);
+        shift = _mm256_set1_epi16((int16_t)(1 << (d + 2)));
+        for (i = 0; i < KYBER_N / 16; i++) {
+            x = _mm256_loadu_si256((const __m256i*)&f->coeffs[16*i]);
+            x = _mm256_add_epi16(x, _mm256_and_si256(_mm256_srai_epi16(x, 15), q));
+            lo = _mm256_mullo_epi16(x, v8);
+            t = _mm256_sub_epi16(lo, _mm256_add_epi16(x, off));
+            t = _mm256_srli_epi16(_mm256_andnot_si256(lo, t), 15);
+            x = _mm256_mulhi_epi16(_mm256_slli_epi16(x, 3), v);
+            x = _mm256_mulhrs_epi16(_mm256_sub_epi16(x, t), shift);
+            _mm256_storeu_si256((__m256i*)&f->coeffs[16*i], _mm256_and_si256(x, mask));
+        }
+    }
+    else {
+        poly_compress_ref(f, d);
+    }
+}
+
+/**
+ * @brief Same output as poly_decompress_ref for coefficients in [0, 2^d)
+ * @details mulhrs(x * 2^(15-d), q) = (x * q * 2^(15-d) + 2^14) >> 15 = (x * q + 2^(d-1)) >> d, and x * 2^(15-d) fits
+ *          in 15 bits.
+ */
+AVX2 void poly_decompress_avx2(poly_t* f, const unsigned d) {
+    int i;
+    __m256i x;
+    const __m256i q = _mm256_set1_epi16(KYBER_Q);
+    const __m128i shift = _mm_cvtsi32_si128(15 - (int)d);
+
+    for (i = 0; i < KYBER_N / 16; i++) {
+        x = _mm256_loadu_si256((const __m256i*)&f->coeffs[16*i]);
+        x = _mm256_mulhrs_epi16(_mm256_sll_epi16(x, shift), q);
+        _mm256_storeu_si256((__m256i*)&f->coeffs[16*i], x);
+    }
+}
+
+/************/
+/* VALIDITY */
+/************/
+
+/**
+ * @brief Same output as poly_is_valid_ref, in constant time
+ * @details Out of range lanes are accumulated in a register and only looked at once, at the end.
+ */
+AVX2 int poly_is_valid_avx2(const poly_t* f) {
+    int i;
+    __m256i x, invalid;
+    const __m256i half_q = _mm256_set1_epi16(KYBER_Q >> 1);
+    const __m256i q_minus_1 = _mm256_set1_epi16(KYBER_Q - 1);
+    const __m256i zero = _mm256_setzero_si256();
+
+    invalid = _mm256_setzero_si256();
+
+    for (i = 0; i < KYBER_N / 16; i++) {
+        x = _mm256_add_epi16(_mm256_loadu_si256((const __m256i*)&f->coeffs[16*i]), half_q);
+        invalid = _mm256_or_si256(invalid, _mm256_cmpgt_epi16(zero, x));
+        invalid = _mm256_or_si256(invalid, _mm256_cmpgt_epi16(x, q_minus_1));
+    }
+
+    return !_mm256_testz_si256(invalid, invalid);
+}
+
+/********************/
+/* MESSAGE ENCODING */
+/********************/
+
+/**
+ * @brief Same output as poly_frommsg, 16 coefficients per step
+ * @details The two message bytes of a step are broadcast to the 16 lanes, lane k keeps bit k and turns it into a mask.
+ */
+AVX2 void poly_frommsg_avx2(poly_t* r, const uint8_t msg[KYBER_N / 8]) {
+    int i;
+    __m256i w, bit;
+    const __m256i lane_bits = _mm256_setr_epi16(1 << 0, 1 << 1, 1 << 2, 1 << 3, 1 << 4, 1 << 5, 1 << 6, 1 << 7,
+                                                1 << 8, 1 << 9, 1 << 10, 1 << 11, 1 << 12, 1 << 13, 1 << 14, (int16_t)(1 << 15));
+    const __m256i half_q = _mm256_set1_epi16((KYBER_Q + 1) / 2);
+
+    for (i = 0; i < KYBER_N / 16; i++) {
+        w = _mm256_set1_epi16((int16_t)(msg[2*i] | (msg[2*i + 1] << 8)));
+        bit = _mm256_cmpeq_epi16(_mm256_and_si256(w, lane_bits), lane_bits);
+        _mm256_storeu_si256((__m256i*)&r->coeffs[16*i], _mm256_and_si256(bit, half_q));
+    }
+}
+
+/**
+ * @brief Same output as poly_tomsg, 32 coefficients per step
+ * @details The sign of (q-1)/4 - |x| is the message bit, the signs of 32 coefficients are packed to bytes and
+ *          gathered with a single movemask.
+ */
+AVX2 void poly_tomsg_avx2(uint8_t msg[KYBER_N / 8], const poly_t* f) {
+    int i;
+    __m256i f0, f1, t;
+    uint32_t bits;
+    const __m256i quarter_q = _mm256_set1_epi16((KYBER_Q - 1) / 4);
+
+    for (i = 0; i < KYBER_N / 32; i++) {
+        f0 = _mm256_loadu_si256((const __m256i*)&f->coeffs[32*i]);
+        f1 = _mm256_loadu_si256((const __m256i*)&f->coeffs[32*i + 16]);
+        f0 = _mm256_sub_epi16(quarter_q, _mm256_abs_epi16(f0));
+        f1 = _mm256_sub_epi16(quarter_q, _mm256_abs_epi16(f1));
+        // packs works inside each 128-bit lane, the 64-bit blocks are put back in order
+        t = _mm256_permute4x64_epi64(_mm256_packs_epi16(f0, f1), 0xD8);
+        bits = (uint32_t)_mm256_movemask_epi8(t);
+        memcpy(&msg[4*i], &bits, 4);
+    }
+}
+
+/***************************/
+/* CHECKED 12-BIT DECODING */
+/***************************/
+
+/**
+ * @brief Same output as poly_decode12_checked_ref, 16 coefficients per step
+ * @details Each 128-bit lane receives 12 bytes, a byte shuffle puts the two bytes holding each coefficient in its
+ *          16-bit lane, then even lanes are masked and odd lanes shifted. The comparisons with q are accumulated in
+ *          a register and only looked at once, at the end.
+ */
+AVX2 int poly_decode12_checked_avx2(poly_t* f, const uint8_t bytes[32 * 12]) {
+    int i;
+    __m128i lo, hi;
+    __m256i x, invalid;
+    uint8_t tail[32] = {0};
+    const __m256i shuffle = _mm256_setr_epi8(0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11,
+                                             0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11);
+    const __m256i lower_bits = _mm256_set1_epi16(0x0FFF);
+    const __m256i q_minus_1 = _mm256_set1_epi16(KYBER_Q - 1);
+
+    invalid = _mm256_setzero_si256();
+
+    for (i = 0; i < KYBER_N / 16; i++) {
+        if (i < KYBER_N / 16 - 1) {
+            lo = _mm_loadu_si128((const __m128i*)&bytes[24*i]);
+            hi = _mm_loadu_si128((const __m128i*)&bytes[24*i + 12]);
+        }
+        else {
+            // The 16-byte loads would read past the end of the last 24 bytes
+            memcpy(tail, &bytes[24*i], 24);
+            lo = _mm_loadu_si128((const __m128i*)&tail[0]);
+            hi = _mm_loadu_si128((const __m128i*)&tail[12]);
+        }
+
+        x = _mm256_shuffle_epi8(_mm256_set_m128i(hi, lo), shuffle);
+        x = _mm256_blend_epi16(_mm256_and_si256(x, lower_bits), _mm256_srli_epi16(x, 4), 0xAA);
+
+        invalid = _mm256_or_si256(invalid, _mm256_cmpgt_epi16(x, q_minus_1));
+        _mm256_storeu_si256((__m256i*)&f->coeffs[16*i], x);
+    }
+
+    return !_mm256_testz_si256(invalid, invalid);
+}
+
+#endif
@@ -5,6 +5,7 @@
  */
 
 #include "polyvec.h"
+#include "trace.h"
 
 /***********************/
 /* UTILITARY FUNCTIONS */
@@ -57,7 +58,7 @@ int polyvec_equal(const polyvec_t* f, const polyvec_t* g) {
     int i;
     int16_t are_equal = EXIT_SUCCESS;
 
-    for (i = 0; i < KYBER_N; i++) {
+    for (i = 0; i < KYBER_K; i++) {
         if (poly_equal(&f->vec[i], &g->vec[i]) == EXIT_FAILURE) {
             are_equal = EXIT_FAILURE;
         }
@@ -72,13 +73,8 @@ int polyvec_equal(const polyvec_t* f, const polyvec_t* g) {
 void polyvec_secure_free(polyvec_t** ptr) {
     if (ptr == NULL || *ptr == NULL) return;
 
-    int i;
-    poly_t* temp;
-
-    for (i = 0; i < KYBER_K; i++) {
-        temp = &(*ptr)->vec[i];
-        poly_secure_free(&temp);
-    }
+    // The entries are part of the same allocation, they are erased but must not be freed one by one
+    polyvec_zero(*ptr);
 
     free(*ptr);
     *ptr = NULL;
@@ -105,9 +101,13 @@ void polyvec_copy(polyvec_t *target, const polyvec_t *source) {
 void polyvec_ntt(polyvec_t* f) {
     int i;
 
+    TRACE_BEGIN("polyvec_ntt");
+
     for (i = 0; i < KYBER_K; i++) {
         NTT(f->vec[i].coeffs);
     }
+
+    TRACE_END("polyvec_ntt");
 }
 
 /**
@@ -116,13 +116,18 @@ void polyvec_ntt(polyvec_t* f) {
 void polyvec_ntt_inv(polyvec_t* f) {
     int i;
 
+    TRACE_BEGIN("polyvec_ntt_inv");
+
     for (i = 0; i < KYBER_K; i++) {
         NTT_inv(f->vec[i].coeffs);
     }
+
+    TRACE_END("polyvec_ntt_inv");
 }
 
 /**
  * @brief Computes the scalar product of two vectors inside NTT domain
+ * @details The K terms are added without reduction, the coefficients of r are bounded by POLY_BOUND_PRODUCT
  */
 void polyvec_ntt_scalar_product(poly_t* r, const polyvec_t* a, const polyvec_t* b) {
     int i;
@@ -132,7 +137,7 @@ void polyvec_ntt_scalar_product(poly_t* r, const polyvec_t* a, const polyvec_t*
     
     for (i = 0; i < KYBER_K; i++) {
         NTT_multiply(temp.coeffs, a->vec[i].coeffs, b->vec[i].coeffs);
-        poly_add(r, r, &temp);
+        poly_add_noreduce(r, r, &temp);
     }
 
     poly_zero(&temp); // At the end of the loop, temp contains a->vec[KYBER_K-1] * b->vec[KYBER_K-1], if a and b are private we shall erase this value
@@ -140,7 +145,8 @@ void polyvec_ntt_scalar_product(poly_t* r, const polyvec_t* a, const polyvec_t*
 
 /**
  * @brief Computes a matrix/vector product inside NTT domain
- * 
+ * @details Same bound on the output as polyvec_ntt_scalar_product
+ *
  * @param r[out]
  * @param A[in] matrix of size k*k
  * @param v[in] vector applied to A, of size k
@@ -148,9 +154,13 @@ void polyvec_ntt_scalar_product(poly_t* r, const polyvec_t* a, const polyvec_t*
 void polyvec_ntt_product(polyvec_t* r, const polyvec_t** A, const polyvec_t* v) {
     int i;
 
+    TRACE_BEGIN("polyvec_ntt_product");
+
     for (i = 0; i < KYBER_K; i++) {
         polyvec_ntt_scalar_product(&r->vec[i], A[i], v);
     }
+
+    TRACE_END("polyvec_ntt_product");
 }
 
 /*******************************/
@@ -197,6 +207,100 @@ void polyvec_transpose(polyvec_t** A) {
     }
 }
 
+/************/
+/* MATRICES */
+/************/
+
+/**
+ * @brief Allocates a matrix aligned on a cache line
+ * @return the matrix, NULL if the allocation failed. It should be released with polymat_secure_free
+ */
+polymat_t* polymat_new(void) {
+    return (polymat_t*)aligned_alloc(POLYMAT_ALIGN, sizeof(polymat_t));
+}
+
+/**
+ * @brief Safely frees up memory space
+ * @param ptr points to the pointer to the memory space to free
+ */
+void polymat_secure_free(polymat_t** ptr) {
+    if (ptr == NULL || *ptr == NULL) return;
+
+    int i;
+
+    for (i = 0; i < KYBER_K; i++) {
+        polyvec_zero(&(*ptr)->row[i]);
+    }
+
+    free(*ptr);
+    *ptr = NULL;
+}
+
+/**
+ * @brief Computes a matrix/vector product inside NTT domain, A or its transpose is applied to v without copying
+ * @details Same bound on the output as polyvec_ntt_scalar_product
+ *
+ * @param r[out] must not alias v
+ * @param A[in] matrix of size k*k
+ * @param v[in] vector applied to A, of size k
+ * @param transposed[in] if non-zero, the product is A^T * v, that is entry (j,i) of A is read in place of entry (i,j)
+ */
+void polymat_ntt_product(polyvec_t* r, const polymat_t* A, const polyvec_t* v, const int transposed) {
+    int i, j;
+    poly_t temp;
+    const poly_t* entry;
+
+    TRACE_BEGIN("polymat_ntt_product");
+
+    for (i = 0; i < KYBER_K; i++) {
+        poly_zero(&r->vec[i]);
+
+        for (j = 0; j < KYBER_K; j++) {
+            entry = transposed ? &A->row[j].vec[i] : &A->row[i].vec[j];
+            NTT_multiply(temp.coeffs, entry->coeffs, v->vec[j].coeffs);
+            poly_add_noreduce(&r->vec[i], &r->vec[i], &temp);
+        }
+    }
+
+    poly_zero(&temp);
+
+    TRACE_END("polymat_ntt_product");
+}
+
+/**
+ * @brief Same as polymat_ntt_product, with the entries of the matrix generated one at a time instead of stored
+ * @details Each entry is written to a single tile and accumulated into r right away, so that the working set is two
+ *          polynomials instead of the K*K of a polymat_t. The entries are requested in the order they are consumed :
+ *          row by row of the product, that is column by column of A when transposed is set.
+ *
+ * @param r[out] must not alias v
+ * @param A[in] generator of the entries of the matrix, in the NTT domain
+ * @param v[in] vector applied to A, of size k
+ * @param transposed[in] if non-zero, the product is A^T * v, that is entry (j,i) of A is generated in place of entry (i,j)
+ */
+void polyvec_ntt_product_stream(polyvec_t* r, const polymat_stream_t* A, const polyvec_t* v, const int transposed) {
+    int i, j;
+    poly_t tile, temp;
+
+    TRACE_BEGIN("polyvec_ntt_product_stream");
+
+    for (i = 0; i < KYBER_K; i++) {
+        poly_zero(&r->vec[i]);
+
+        for (j = 0; j < KYBER_K; j++) {
+            if (transposed) A->entry(&tile, j, i, A->arg);
+            else A->entry(&tile, i, j, A->arg);
+            NTT_multiply(temp.coeffs, tile.coeffs, v->vec[j].coeffs);
+            poly_add_noreduce(&r->vec[i], &r->vec[i], &temp);
+        }
+    }
+
+    poly_zero(&tile);
+    poly_zero(&temp);
+
+    TRACE_END("polyvec_ntt_product_stream");
+}
+
 /****************/
 /* BYTES ENCODE */
 /****************/
@@ -211,10 +315,14 @@ void polyvec_transpose(polyvec_t** A) {
  */
 void polyvec_byte_encode(uint8_t* bytes, const polyvec_t* f, const unsigned d) {
     int i;
-    
+
+    TRACE_BEGIN("polyvec_byte_encode");
+
     for (i = 0; i < KYBER_K; i++) {
         byte_encode(bytes + 32*d*i, f->vec[i].coeffs, d);
     }
+
+    TRACE_END("polyvec_byte_encode");
 }
 
 /**
@@ -226,9 +334,34 @@ void polyvec_byte_encode(uint8_t* bytes, const polyvec_t* f, const unsigned d) {
 void polyvec_byte_decode(polyvec_t* f, const uint8_t* bytes, const unsigned d) {
     int i;
 
+    TRACE_BEGIN("polyvec_byte_decode");
+
     for (i = 0; i < KYBER_K; i++) {
         byte_decode(f->vec[i].coeffs, bytes + 32*d*i, d);
     }
+
+    TRACE_END("polyvec_byte_decode");
+}
+
+/**
+ * @brief Decodes an encapsulation key vector with ByteDecode_12 and performs the FIPS 203 modulus check in the same pass
+ * @details Equivalent to polyvec_byte_decode, then checking that polyvec_byte_encode gives back bytes, in constant time
+ * @param[out] f
+ * @param[in] bytes byte array of length 384 * KYBER_K
+ * @return 0 if all the coefficients are smaller than q, 1 otherwise
+ */
+int polyvec_decode12_checked(polyvec_t* f, const uint8_t* bytes) {
+    int i;
+    int invalid = 0;
+
+    TRACE_BEGIN("polyvec_decode12_checked");
+
+    for (i = 0; i < KYBER_K; i++) {
+        invalid |= poly_decode12_checked(&f->vec[i], bytes + 32*12*i);
+    }
+
+    TRACE_END("polyvec_decode12_checked");
+    return invalid;
 }
 
 /*********************************/
@@ -242,9 +375,13 @@ void polyvec_byte_decode(polyvec_t* f, const uint8_t* bytes, const unsigned d) {
 void polyvec_compress(polyvec_t* f, const unsigned d) {
     int i;
 
+    TRACE_BEGIN("polyvec_compress");
+
     for (i = 0; i < KYBER_K; i++) {
-        compress(&f->vec[i], d);
+        poly_compress(&f->vec[i], d);
     }
+
+    TRACE_END("polyvec_compress");
 }
 
 /**
@@ -254,7 +391,178 @@ void polyvec_compress(polyvec_t* f, const unsigned d) {
 void polyvec_decompress(polyvec_t* f, const unsigned d) {
     int i;
 
+    TRACE_BEGIN("polyvec_decompress");
+
     for (i = 0; i < KYBER_K; i++) {
         poly_decompress(&f->vec[i], d);
     }
-}
\ No newline at end of file
+
+    TRACE_END("polyvec_decompress");
+}
+
+/**
+ * @brief Computes Compress_d(NTT_inv(f) + e), the tail of u in K-PKE.Encrypt, see poly_ntt_inv_add_compress
+ * @param[out] r compressed vector, may alias f
+ * @param[in] f vector in the NTT domain, overwritten
+ * @param[in] e noise vector
+ * @param[in] d
+ */
+void polyvec_ntt_inv_add_compress(polyvec_t* r, polyvec_t* f, const polyvec_t* e, const unsigned d) {
+    int i;
+
+    TRACE_BEGIN("polyvec_ntt_inv_add_compress");
+
+    for (i = 0; i < KYBER_K; i++) {
+        poly_ntt_inv_add_compress(&r->vec[i], &f->vec[i], &e->vec[i], NULL, d);
+    }
+
+    TRACE_END("polyvec_ntt_inv_add_compress");
+}
+
+/******************************/
+/* NTT-CACHED MULTIPLICATIONS */
+/******************************/
+
+/**
+ * @brief Computes once the NTT of all the entries of a and their basemul precomputations
+ * @param[out] cache
+ * @param[in] a vector in the normal domain
+ */
+void polyvec_ntt_cache_init(polyvec_ntt_cache_t* cache, const polyvec_t* a) {
+    int i;
+
+    for (i = 0; i < KYBER_K; i++) {
+        poly_ntt_cache_init(&cache->vec[i], &a->vec[i]);
+    }
+}
+
+/**
+ * @brief Allocates and initializes a handle on the NTT form of a
+ * @return the handle, NULL if the allocation failed. It should be released with polyvec_ntt_cache_secure_free
+ */
+polyvec_ntt_cache_t* polyvec_ntt_cache_new(const polyvec_t* a) {
+    polyvec_ntt_cache_t* cache = (polyvec_ntt_cache_t*)malloc(sizeof(polyvec_ntt_cache_t));
+
+    if (cache == NULL) return NULL;
+
+    polyvec_ntt_cache_init(cache, a);
+    return cache;
+}
+
+/**
+ * @brief Safely frees up a handle created by polyvec_ntt_cache_new
+ * @param ptr points to the pointer to the memory space to free
+ */
+void polyvec_ntt_cache_secure_free(polyvec_ntt_cache_t** ptr) {
+    int i, j;
+    volatile int16_t* mulcache;
+
+    if (ptr == NULL || *ptr == NULL) return;
+
+    for (i = 0; i < KYBER_K; i++) {
+        poly_zero(&(*ptr)->vec[i].hat);
+        mulcache = (*ptr)->vec[i].mulcache;
+        for (j = 0; j < KYBER_N / 2; j++) {
+            mulcache[j] = 0;
+        }
+    }
+
+    free(*ptr);
+    *ptr = NULL;
+}
+
+/**
+ * @brief Computes the scalar product of a cached vector and a vector in the normal domain
+ * @details Costs one NTT per entry of b and a single inverse NTT
+ * @param[out] r
+ * @param[in] a
+ * @param[in] b
+ */
+void polyvec_scalar_product_cached(poly_t* r, const polyvec_ntt_cache_t* a, const polyvec_t* b) {
+    int i;
+    poly_t temp;
+
+    TRACE_BEGIN("polyvec_scalar_product_cached");
+
+    poly_zero(r);
+
+    for (i = 0; i < KYBER_K; i++) {
+        poly_copy(&temp, &b->vec[i]);
+        NTT(temp.coeffs);
+        NTT_multiply_cached(temp.coeffs, a->vec[i].hat.coeffs, a->vec[i].mulcache, temp.coeffs);
+        poly_add_noreduce(r, r, &temp);
+    }
+
+    poly_zero(&temp);
+
+    POLY_ASSERT_BOUND(r, POLY_BOUND_NTT_INV);
+    NTT_inv_scaled(r->coeffs, NTT_INV_FACTOR_R1);
+
+    TRACE_END("polyvec_scalar_product_cached");
+}
+
+/******************/
+/* PACKED VECTORS */
+/******************/
+
+/**
+ * @brief Packs every entry of f with poly_pack
+ */
+void polyvec_pack(polyvec_packed_t* r, const polyvec_t* f) {
+    int i;
+
+    for (i = 0; i < KYBER_K; i++) {
+        poly_pack(&r->vec[i], &f->vec[i]);
+    }
+}
+
+/**
+ * @brief Unpacks every entry of f with poly_unpack
+ */
+void polyvec_unpack(polyvec_t* r, const polyvec_packed_t* f) {
+    int i;
+
+    for (i = 0; i < KYBER_K; i++) {
+        poly_unpack(&r->vec[i], &f->vec[i]);
+    }
+}
+
+/**
+ * @brief Same as polyvec_ntt_scalar_product, with the first operand packed
+ *
+ * @param r[out]
+ * @param a[in] vector in the NTT domain packed by polyvec_pack, e.g. a public key t
+ * @param b[in] vector in the NTT domain
+ */
+void polyvec_ntt_scalar_product_packed(poly_t* r, const polyvec_packed_t* a, const polyvec_t* b) {
+    int i;
+    poly_t temp;
+
+    poly_zero(r);
+
+    for (i = 0; i < KYBER_K; i++) {
+        NTT_multiply_packed(temp.coeffs, a->vec[i].bytes, b->vec[i].coeffs);
+        poly_add_noreduce(r, r, &temp);
+    }
+
+    poly_zero(&temp);
+}
+
+/**
+ * @brief Same as polyvec_ntt_product, with the rows of the matrix packed
+ *
+ * @param r[out] must not alias v
+ * @param A[in] the k rows of the matrix, packed by polyvec_pack
+ * @param v[in] vector applied to A, of size k
+ */
+void polyvec_ntt_product_packed(polyvec_t* r, const polyvec_packed_t A[KYBER_K], const polyvec_t* v) {
+    int i;
+
+    TRACE_BEGIN("polyvec_ntt_product_packed");
+
+    for (i = 0; i < KYBER_K; i++) {
+        polyvec_ntt_scalar_product_packed(&r->vec[i], &A[i], v);
+    }
+
+    TRACE_END("polyvec_ntt_product_packed");
+}
@@ -0,0 +1,202 @@
+/**
+ * @file randpool.c
+ * @brief Per-thread pool of OS randomness handing out the seeds d, z and m without a system call per operation
+ * @author Gabriel Abauzit
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "randpool.h"
+#include "ct.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<sys/random.h>)
+#include <sys/random.h>
+#define RANDPOOL_GETRANDOM 1
+#endif
+#endif
+
+typedef struct {
+    uint8_t buf[RANDPOOL_BYTES];
+    size_t pos;                           // bytes before pos were handed out and erased
+    unsigned generation;
+    uint64_t det_state;                   // generator of the deterministic mode
+} randpool_t;
+
+// Bumped by randpool_reseed, randpool_deterministic and in a forked child : a pool from an older generation refills
+static atomic_uint randpool_generation = 1;
+static atomic_uint_fast64_t randpool_refill_count = 0;
+static pthread_once_t randpool_atfork_once = PTHREAD_ONCE_INIT;
+
+static atomic_int randpool_det_enabled = 0;
+static uint8_t randpool_det_seed[RANDPOOL_SEED_BYTES];
+
+static _Thread_local randpool_t local_pool = {{0}, RANDPOOL_BYTES, 0, 0};
+
+static void randpool_atfork_child(void) {
+    atomic_fetch_add_explicit(&randpool_generation, 1, memory_order_release);
+}
+
+static void randpool_atfork_register(void) {
+    pthread_atfork(NULL, NULL, randpool_atfork_child);
+}
+
+/**
+ * @brief Fills buf with len bytes from the OS
+ * @return 0 on success, 1 if the OS source failed
+ */
+static int randpool_os_fill(uint8_t* buf, size_t len) {
+#ifdef RANDPOOL_GETRANDOM
+    ssize_t n;
+
+    while (len > 0) {
+        n = getrandom(buf, len, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return EXIT_FAILURE;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return EXIT_SUCCESS;
+#else
+    FILE* f = fopen("/dev/urandom", "rb");
+    size_t n;
+
+    if (f == NULL) return EXIT_FAILURE;
+    n = fread(buf, 1, len, f);
+    fclose(f);
+    return n == len ? EXIT_SUCCESS : EXIT_FAILURE;
+#endif
+}
+
+/**
+ * @brief splitmix64, the deterministic mode only needs a reproducible stream
+ */
+static uint64_t randpool_det_next(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Refills the pool of the calling thread
+ * @return 0 on success, 1 if the OS source failed, the pool is then left empty
+ */
+static int randpool_refill(randpool_t* p, const unsigned generation) {
+    uint64_t x;
+    size_t i;
+    int k;
+
+    if (atomic_load_explicit(&randpool_det_enabled, memory_order_acquire)) {
+        if (p->generation != generation) {
+            // Same stream in every thread from the seed, so that a single-threaded harness is reproducible. Each word
+            // of the seed goes through a splitmix64 step, a bijection : seeds differing in a single word never collide
+            p->det_state = 0;
+            for (k = 0; k < RANDPOOL_SEED_BYTES; k += 8) {
+                memcpy(&x, randpool_det_seed + k, 8);
+                p->det_state ^= x;
+                p->det_state = randpool_det_next(&p->det_state);
+            }
+        }
+        for (i = 0; i < RANDPOOL_BYTES; i += 8) {
+            x = randpool_det_next(&p->det_state);
+            memcpy(p->buf + i, &x, RANDPOOL_BYTES - i < 8 ? RANDPOOL_BYTES - i : 8);
+        }
+    }
+    else if (randpool_os_fill(p->buf, RANDPOOL_BYTES) == EXIT_FAILURE) {
+        ct_zero(p->buf, RANDPOOL_BYTES);
+        p->pos = RANDPOOL_BYTES;
+        return EXIT_FAILURE;
+    }
+
+    p->pos = 0;
+    p->generation = generation;
+    atomic_fetch_add_explicit(&randpool_refill_count, 1, memory_order_relaxed);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Fills out with random bytes from the pool of the calling thread
+ * @details The common case is a copy from the buffer. It only makes a system call when the buffer is exhausted, after a
+ *          fork or after randpool_reseed.
+ *
+ * @param[out] out
+ * @param[in] len
+ * @return 0 on success, 1 if the OS source failed, out is then erased
+ */
+int randpool_bytes(uint8_t* out, const size_t len) {
+    randpool_t* p = &local_pool;
+    unsigned generation;
+    size_t done = 0, n;
+
+    pthread_once(&randpool_atfork_once, randpool_atfork_register);
+    generation = atomic_load_explicit(&randpool_generation, memory_order_acquire);
+
+    if (p->generation != generation) {
+        // Bytes buffered before a fork are also in the parent, those buffered before a reseed are dropped
+        ct_zero(p->buf, RANDPOOL_BYTES);
+        p->pos = RANDPOOL_BYTES;
+    }
+
+    while (done < len) {
+        if (p->pos == RANDPOOL_BYTES || p->generation != generation) {
+            if (randpool_refill(p, generation) == EXIT_FAILURE) {
+                ct_zero(out, len);
+                return EXIT_FAILURE;
+            }
+        }
+        n = len - done < RANDPOOL_BYTES - p->pos ? len - done : RANDPOOL_BYTES - p->pos;
+        memcpy(out + done, p->buf + p->pos, n);
+        ct_zero(p->buf + p->pos, n);
+        p->pos += n;
+        done += n;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Draws a 32-byte seed, see randpool_bytes
+ */
+int randpool_seed(uint8_t seed[RANDPOOL_SEED_BYTES]) {
+    return randpool_bytes(seed, RANDPOOL_SEED_BYTES);
+}
+
+/**
+ * @brief Makes every thread refill from the OS before its next draw, the bytes buffered so far are never handed out
+ * @details Call it after restoring a VM snapshot, or whenever the buffered bytes may have been duplicated.
+ */
+void randpool_reseed(void) {
+    atomic_fetch_add_explicit(&randpool_generation, 1, memory_order_release);
+}
+
+/**
+ * @brief Switches to a reproducible stream for the tests, benchmarks and known-answer harnesses
+ * @details With a seed, every thread restarts the same stream expanded from it, which is NOT random and must never be
+ *          used to generate real keys. With NULL, the pools go back to the OS. Call it while no other thread draws.
+ */
+void randpool_deterministic(const uint8_t seed[RANDPOOL_SEED_BYTES]) {
+    if (seed != NULL) {
+        memcpy(randpool_det_seed, seed, RANDPOOL_SEED_BYTES);
+    }
+    else {
+        ct_zero(randpool_det_seed, RANDPOOL_SEED_BYTES);
+    }
+    atomic_store_explicit(&randpool_det_enabled, seed != NULL, memory_order_release);
+    randpool_reseed();
+}
+
+/**
+ * @brief Number of refills of all the pools since the start of the process, each one being a system call outside of the
+ *        deterministic mode
+ */
+uint64_t randpool_refills(void) {
+    return atomic_load_explicit(&randpool_refill_count, memory_order_relaxed);
+}
@@ -0,0 +1,262 @@
+/**
+ * @file serialize.c
+ * @brief Scatter-gather serialization of polynomials, vectors and ciphertexts
+ * @author Gabriel Abauzit
+ */
+
+#include "serialize.h"
+
+// Number of 8-coefficient blocks in a polynomial, each one is encoded to exactly d bytes
+#define POLY_BLOCKS (KYBER_N / 8)
+
+/***********/
+/* CURSORS */
+/***********/
+
+/**
+ * @brief Skips the segments that are empty or fully used
+ */
+static void iov_cursor_settle(iov_cursor_t* c) {
+    while (c->index < c->iovcnt && c->offset >= c->iov[c->index].iov_len) {
+        c->index++;
+        c->offset = 0;
+    }
+}
+
+/**
+ * @brief Pointer to the current position, the number of contiguous bytes available there is stored in len
+ */
+static uint8_t* iov_cursor_peek(iov_cursor_t* c, size_t* len) {
+    iov_cursor_settle(c);
+    if (c->index == c->iovcnt) {
+        *len = 0;
+        return NULL;
+    }
+    *len = c->iov[c->index].iov_len - c->offset;
+    return (uint8_t*)c->iov[c->index].iov_base + c->offset;
+}
+
+/**
+ * @brief Places a cursor at the beginning of a list of segments
+ */
+void iov_cursor_init(iov_cursor_t* c, const struct iovec* iov, const size_t iovcnt) {
+    c->iov = iov;
+    c->iovcnt = iovcnt;
+    c->index = 0;
+    c->offset = 0;
+}
+
+/**
+ * @brief Describes a window of a ring buffer as at most two segments
+ *
+ * @param[out] iov segments of the window
+ * @param[in] base ring buffer
+ * @param[in] capacity size of the ring buffer
+ * @param[in] start position of the window in the ring buffer, in [0, capacity)
+ * @param[in] length size of the window, at most capacity
+ * @return number of segments filled in iov
+ */
+size_t iov_ring_window(struct iovec iov[2], uint8_t* base, const size_t capacity, const size_t start, const size_t length) {
+    size_t first = capacity - start;
+
+    if (length <= first) {
+        iov[0].iov_base = base + start;
+        iov[0].iov_len = length;
+        return 1;
+    }
+
+    iov[0].iov_base = base + start;
+    iov[0].iov_len = first;
+    iov[1].iov_base = base;
+    iov[1].iov_len = length - first;
+    return 2;
+}
+
+/**
+ * @brief Number of bytes left between the cursor and the end of the last segment
+ */
+size_t iov_cursor_remaining(const iov_cursor_t* c) {
+    size_t i;
+    size_t total = 0;
+
+    for (i = c->index; i < c->iovcnt; i++) {
+        total += c->iov[i].iov_len;
+    }
+
+    return total - (c->index < c->iovcnt ? c->offset : 0);
+}
+
+/**
+ * @brief Copies len bytes at the cursor position, crossing segment boundaries if needed
+ * @return 0 on success, 1 if the segments are too short (nothing is written in this case)
+ */
+int iov_cursor_write(iov_cursor_t* c, const uint8_t* src, size_t len) {
+    size_t room, n;
+    uint8_t* dst;
+
+    if (iov_cursor_remaining(c) < len) return EXIT_FAILURE;
+
+    while (len > 0) {
+        dst = iov_cursor_peek(c, &room);
+        n = room < len ? room : len;
+        memcpy(dst, src, n);
+        c->offset += n;
+        src += n;
+        len -= n;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Copies len bytes from the cursor position, crossing segment boundaries if needed
+ * @return 0 on success, 1 if the segments are too short (nothing is read in this case)
+ */
+int iov_cursor_read(iov_cursor_t* c, uint8_t* dst, size_t len) {
+    size_t room, n;
+    const uint8_t* src;
+
+    if (iov_cursor_remaining(c) < len) return EXIT_FAILURE;
+
+    while (len > 0) {
+        src = iov_cursor_peek(c, &room);
+        n = room < len ? room : len;
+        memcpy(dst, src, n);
+        c->offset += n;
+        dst += n;
+        len -= n;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*************************/
+/* ENCODING AND DECODING */
+/*************************/
+
+/**
+ * @brief Encodes f with byte_encode straight into the segments of the cursor
+ * @details Every block of 8 coefficients that fits in the current segment is encoded in place, only a block
+ *          straddling two segments goes through a d-byte staging buffer.
+ * @return 0 on success, 1 if the segments are too short (nothing is written in this case)
+ */
+int poly_byte_encode_iov(iov_cursor_t* c, const poly_t* f, const unsigned d) {
+    unsigned block, n;
+    size_t room;
+    uint8_t* dst;
+    uint8_t staging[12];
+
+    if (iov_cursor_remaining(c) < POLY_BYTES(d)) return EXIT_FAILURE;
+
+    block = 0;
+    while (block < POLY_BLOCKS) {
+        dst = iov_cursor_peek(c, &room);
+        n = room / d < POLY_BLOCKS - block ? (unsigned)(room / d) : POLY_BLOCKS - block;
+
+        if (n > 0) {
+            byte_encode_blocks(dst, f->coeffs + 8*block, d, n);
+            c->offset += n * d;
+            block += n;
+        }
+        else {
+            byte_encode_blocks(staging, f->coeffs + 8*block, d, 1);
+            iov_cursor_write(c, staging, d);
+            block++;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Decodes f with byte_decode straight from the segments of the cursor, see poly_byte_encode_iov
+ * @return 0 on success, 1 if the segments are too short (nothing is read in this case)
+ */
+int poly_byte_decode_iov(poly_t* f, iov_cursor_t* c, const unsigned d) {
+    unsigned block, n;
+    size_t room;
+    const uint8_t* src;
+    uint8_t staging[12];
+
+    if (iov_cursor_remaining(c) < POLY_BYTES(d)) return EXIT_FAILURE;
+
+    block = 0;
+    while (block < POLY_BLOCKS) {
+        src = iov_cursor_peek(c, &room);
+        n = room / d < POLY_BLOCKS - block ? (unsigned)(room / d) : POLY_BLOCKS - block;
+
+        if (n > 0) {
+            byte_decode_blocks(f->coeffs + 8*block, src, d, n);
+            c->offset += n * d;
+            block += n;
+        }
+        else {
+            iov_cursor_read(c, staging, d);
+            byte_decode_blocks(f->coeffs + 8*block, staging, d, 1);
+            block++;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Same layout as polyvec_byte_encode, written straight into the segments of the cursor
+ * @return 0 on success, 1 if the segments are too short (nothing is written in this case)
+ */
+int polyvec_byte_encode_iov(iov_cursor_t* c, const polyvec_t* f, const unsigned d) {
+    int i;
+
+    if (iov_cursor_remaining(c) < POLYVEC_BYTES(d)) return EXIT_FAILURE;
+
+    for (i = 0; i < KYBER_K; i++) {
+        poly_byte_encode_iov(c, &f->vec[i], d);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Same layout as polyvec_byte_decode, read straight from the segments of the cursor
+ * @return 0 on success, 1 if the segments are too short (nothing is read in this case)
+ */
+int polyvec_byte_decode_iov(polyvec_t* f, iov_cursor_t* c, const unsigned d) {
+    int i;
+
+    if (iov_cursor_remaining(c) < POLYVEC_BYTES(d)) return EXIT_FAILURE;
+
+    for (i = 0; i < KYBER_K; i++) {
+        poly_byte_decode_iov(&f->vec[i], c, d);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Writes the ciphertext c = ByteEncode_du(u) || ByteEncode_dv(v) straight into the segments of the cursor
+ * @param[out] c
+ * @param[in] u compressed with d = KYBER_DU
+ * @param[in] v compressed with d = KYBER_DV
+ * @return 0 on success, 1 if the segments are too short (nothing is written in this case)
+ */
+int ciphertext_encode_iov(iov_cursor_t* c, const polyvec_t* u, const poly_t* v) {
+    if (iov_cursor_remaining(c) < CIPHERTEXT_BYTES) return EXIT_FAILURE;
+
+    polyvec_byte_encode_iov(c, u, KYBER_DU);
+    poly_byte_encode_iov(c, v, KYBER_DV);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Reads a ciphertext written by ciphertext_encode_iov from non-contiguous input
+ * @return 0 on success, 1 if the segments are too short (nothing is read in this case)
+ */
+int ciphertext_decode_iov(polyvec_t* u, poly_t* v, iov_cursor_t* c) {
+    if (iov_cursor_remaining(c) < CIPHERTEXT_BYTES) return EXIT_FAILURE;
+
+    polyvec_byte_decode_iov(u, c, KYBER_DU);
+    poly_byte_decode_iov(v, c, KYBER_DV);
+
+    return EXIT_SUCCESS;
+}
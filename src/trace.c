@@ -0,0 +1,155 @@
+/**
+ * @file trace.c
+ * @brief Timeline tracing of the computation stages, written as a Chrome/Perfetto trace-event JSON file
+ * @author Gabriel Abauzit
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "trace.h"
+
+typedef struct {
+    const char* name;
+    uint64_t ts_ns;
+    char phase;
+} trace_record_t;
+
+// Only the owning thread writes a buffer. It publishes each event by a release store of count, so that trace_flush
+// can read the first count events from another thread.
+typedef struct trace_buffer_s {
+    struct trace_buffer_s* next;
+    uint32_t tid;
+    atomic_size_t count;
+    atomic_uint_fast64_t dropped;
+    trace_record_t events[TRACE_BUFFER_EVENTS];
+} trace_buffer_t;
+
+atomic_int trace_enabled = 0;
+
+// Every buffer ever created since the last trace_reset, pushed without lock
+static _Atomic(trace_buffer_t*) trace_buffers = NULL;
+static atomic_uint trace_next_tid = 1;
+// Bumped by trace_reset, a thread whose buffer is from an older generation gets a new one
+static atomic_uint trace_generation = 1;
+
+static _Thread_local trace_buffer_t* local_buffer = NULL;
+static _Thread_local unsigned local_generation = 0;
+
+static uint64_t trace_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Buffer of the calling thread, created on its first event
+ * @return NULL if the allocation failed
+ */
+static trace_buffer_t* trace_local_buffer(void) {
+    unsigned generation = atomic_load_explicit(&trace_generation, memory_order_acquire);
+    trace_buffer_t* b;
+
+    if (local_buffer != NULL && local_generation == generation) return local_buffer;
+
+    b = (trace_buffer_t*)calloc(1, sizeof(trace_buffer_t));
+    if (b == NULL) return NULL;
+    b->tid = atomic_fetch_add_explicit(&trace_next_tid, 1, memory_order_relaxed);
+
+    b->next = atomic_load_explicit(&trace_buffers, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&trace_buffers, &b->next, b, memory_order_release, memory_order_relaxed));
+
+    local_buffer = b;
+    local_generation = generation;
+    return b;
+}
+
+/**
+ * @brief Starts or stops recording, the events already recorded are kept
+ */
+void trace_enable(const int enabled) {
+    atomic_store_explicit(&trace_enabled, enabled != 0, memory_order_relaxed);
+}
+
+/**
+ * @brief Records an event of the calling thread, called by TRACE_BEGIN and TRACE_END
+ * @param[in] name must outlive the next trace_flush, in practice a string literal
+ * @param[in] phase 'B' for the beginning of a stage, 'E' for its end
+ */
+void trace_event(const char* name, const char phase) {
+    trace_buffer_t* b = trace_local_buffer();
+    size_t n;
+
+    if (b == NULL) return;
+
+    n = atomic_load_explicit(&b->count, memory_order_relaxed);
+    if (n >= TRACE_BUFFER_EVENTS) {
+        atomic_fetch_add_explicit(&b->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    b->events[n].name = name;
+    b->events[n].ts_ns = trace_now_ns();
+    b->events[n].phase = phase;
+    atomic_store_explicit(&b->count, n + 1, memory_order_release);
+}
+
+/**
+ * @brief Writes all the events recorded since the last trace_reset in the Chrome trace-event JSON format
+ * @details Can be called while other threads are still recording, their events published so far are written.
+ * @return 0 on success, 1 if the file could not be written
+ */
+int trace_flush(const char* path) {
+    FILE* f = fopen(path, "w");
+    trace_buffer_t* b;
+    size_t i, n;
+    int first = 1;
+    long pid = (long)getpid();
+
+    if (f == NULL) return EXIT_FAILURE;
+
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (b = atomic_load_explicit(&trace_buffers, memory_order_acquire); b != NULL; b = b->next) {
+        n = atomic_load_explicit(&b->count, memory_order_acquire);
+        for (i = 0; i < n; i++) {
+            fprintf(f, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":%ld,\"tid\":%u}",
+                first ? "" : ",", b->events[i].name, b->events[i].phase,
+                (unsigned long long)(b->events[i].ts_ns / 1000), (unsigned)(b->events[i].ts_ns % 1000), pid, b->tid);
+            first = 0;
+        }
+    }
+    fprintf(f, "\n]}\n");
+
+    return fclose(f) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Number of events dropped because the buffer of their thread was full
+ */
+uint64_t trace_dropped(void) {
+    trace_buffer_t* b;
+    uint64_t dropped = 0;
+
+    for (b = atomic_load_explicit(&trace_buffers, memory_order_acquire); b != NULL; b = b->next) {
+        dropped += atomic_load_explicit(&b->dropped, memory_order_relaxed);
+    }
+    return dropped;
+}
+
+/**
+ * @brief Forgets all the events and frees the buffers
+ * @details No thread should be recording at the same time, threads get a new buffer on their next event
+ */
+void trace_reset(void) {
+    trace_buffer_t* b = atomic_exchange_explicit(&trace_buffers, NULL, memory_order_acq_rel);
+    trace_buffer_t* next;
+
+    atomic_fetch_add_explicit(&trace_generation, 1, memory_order_release);
+
+    for (; b != NULL; b = next) {
+        next = b->next;
+        free(b);
+    }
+}
@@ -0,0 +1,319 @@
+/**
+ * @file vecext.c
+ * @brief Portable SIMD backend written with the GCC/Clang vector extensions
+ * @author Gabriel Abauzit
+ */
+
+#include "vecext.h"
+
+#ifdef VECEXT_AVAILABLE
+
+// Padding around the working copy of the NTT, so that the layers with len < VECEXT_LANES can load f[p - len] and f[p + len]
+#define VECEXT_PAD 16
+
+// A coefficient pair (a_0, a_1) of NTT_multiply seen as a single 32-bit lane
+typedef uint32_t vecpair_t __attribute__((vector_size(2 * VECEXT_LANES)));
+
+static const vec16_t lane_index = {0, 1, 2, 3, 4, 5, 6, 7};
+
+// The layers with len < VECEXT_LANES and NTT_multiply_vecext need a different zeta in each lane. Entry c of a row is
+// the zeta used for coefficient c, so that a vector of them is a single load. Row 0 is len = 2, row 1 is len = 4.
+_Static_assert(VECEXT_LANES == 8, "the lane-expanded zetas cover the layers with len = 2 and 4");
+
+// vecext_zetas_ntt[len >> 2][c] = zetas[128 / len + c / (2 * len)]
+static const int16_t vecext_zetas_ntt[2][256] __attribute__((aligned(16))) = {
+    {
+        -1103, -1103, -1103, -1103, 430, 430, 430, 430, 555, 555, 555, 555, 843, 843, 843, 843,
+        -1251, -1251, -1251, -1251, 871, 871, 871, 871, 1550, 1550, 1550, 1550, 105, 105, 105, 105,
+        422, 422, 422, 422, 587, 587, 587, 587, 177, 177, 177, 177, -235, -235, -235, -235,
+        -291, -291, -291, -291, -460, -460, -460, -460, 1574, 1574, 1574, 1574, 1653, 1653, 1653, 1653,
+        -246, -246, -246, -246, 778, 778, 778, 778, 1159, 1159, 1159, 1159, -147, -147, -147, -147,
+        -777, -777, -777, -777, 1483, 1483, 1483, 1483, -602, -602, -602, -602, 1119, 1119, 1119, 1119,
+        -1590, -1590, -1590, -1590, 644, 644, 644, 644, -872, -872, -872, -872, 349, 349, 349, 349,
+        418, 418, 418, 418, 329, 329, 329, 329, -156, -156, -156, -156, -75, -75, -75, -75,
+        817, 817, 817, 817, 1097, 1097, 1097, 1097, 603, 603, 603, 603, 610, 610, 610, 610,
+        1322, 1322, 1322, 1322, -1285, -1285, -1285, -1285, -1465, -1465, -1465, -1465, 384, 384, 384, 384,
+        -1215, -1215, -1215, -1215, -136, -136, -136, -136, 1218, 1218, 1218, 1218, -1335, -1335, -1335, -1335,
+        -874, -874, -874, -874, 220, 220, 220, 220, -1187, -1187, -1187, -1187, -1659, -1659, -1659, -1659,
+        -1185, -1185, -1185, -1185, -1530, -1530, -1530, -1530, -1278, -1278, -1278, -1278, 794, 794, 794, 794,
+        -1510, -1510, -1510, -1510, -854, -854, -854, -854, -870, -870, -870, -870, 478, 478, 478, 478,
+        -108, -108, -108, -108, -308, -308, -308, -308, 996, 996, 996, 996, 991, 991, 991, 991,
+        958, 958, 958, 958, -1460, -1460, -1460, -1460, 1522, 1522, 1522, 1522, 1628, 1628, 1628, 1628
+    },
+    {
+        1223, 1223, 1223, 1223, 1223, 1223, 1223, 1223, 652, 652, 652, 652, 652, 652, 652, 652,
+        -552, -552, -552, -552, -552, -552, -552, -552, 1015, 1015, 1015, 1015, 1015, 1015, 1015, 1015,
+        -1293, -1293, -1293, -1293, -1293, -1293, -1293, -1293, 1491, 1491, 1491, 1491, 1491, 1491, 1491, 1491,
+        -282, -282, -282, -282, -282, -282, -282, -282, -1544, -1544, -1544, -1544, -1544, -1544, -1544, -1544,
+        516, 516, 516, 516, 516, 516, 516, 516, -8, -8, -8, -8, -8, -8, -8, -8,
+        -320, -320, -320, -320, -320, -320, -320, -320, -666, -666, -666, -666, -666, -666, -666, -666,
+        -1618, -1618, -1618, -1618, -1618, -1618, -1618, -1618, -1162, -1162, -1162, -1162, -1162, -1162, -1162, -1162,
+        126, 126, 126, 126, 126, 126, 126, 126, 1469, 1469, 1469, 1469, 1469, 1469, 1469, 1469,
+        -853, -853, -853, -853, -853, -853, -853, -853, -90, -90, -90, -90, -90, -90, -90, -90,
+        -271, -271, -271, -271, -271, -271, -271, -271, 830, 830, 830, 830, 830, 830, 830, 830,
+        107, 107, 107, 107, 107, 107, 107, 107, -1421, -1421, -1421, -1421, -1421, -1421, -1421, -1421,
+        -247, -247, -247, -247, -247, -247, -247, -247, -951, -951, -951, -951, -951, -951, -951, -951,
+        -398, -398, -398, -398, -398, -398, -398, -398, 961, 961, 961, 961, 961, 961, 961, 961,
+        -1508, -1508, -1508, -1508, -1508, -1508, -1508, -1508, -725, -725, -725, -725, -725, -725, -725, -725,
+        448, 448, 448, 448, 448, 448, 448, 448, -1065, -1065, -1065, -1065, -1065, -1065, -1065, -1065,
+        677, 677, 677, 677, 677, 677, 677, 677, -1275, -1275, -1275, -1275, -1275, -1275, -1275, -1275
+    }
+};
+
+// vecext_zetas_ntt_inv[len >> 2][c] = zetas[256 / len - 1 - c / (2 * len)]
+static const int16_t vecext_zetas_ntt_inv[2][256] __attribute__((aligned(16))) = {
+    {
+        1628, 1628, 1628, 1628, 1522, 1522, 1522, 1522, -1460, -1460, -1460, -1460, 958, 958, 958, 958,
+        991, 991, 991, 991, 996, 996, 996, 996, -308, -308, -308, -308, -108, -108, -108, -108,
+        478, 478, 478, 478, -870, -870, -870, -870, -854, -854, -854, -854, -1510, -1510, -1510, -1510,
+        794, 794, 794, 794, -1278, -1278, -1278, -1278, -1530, -1530, -1530, -1530, -1185, -1185, -1185, -1185,
+        -1659, -1659, -1659, -1659, -1187, -1187, -1187, -1187, 220, 220, 220, 220, -874, -874, -874, -874,
+        -1335, -1335, -1335, -1335, 1218, 1218, 1218, 1218, -136, -136, -136, -136, -1215, -1215, -1215, -1215,
+        384, 384, 384, 384, -1465, -1465, -1465, -1465, -1285, -1285, -1285, -1285, 1322, 1322, 1322, 1322,
+        610, 610, 610, 610, 603, 603, 603, 603, 1097, 1097, 1097, 1097, 817, 817, 817, 817,
+        -75, -75, -75, -75, -156, -156, -156, -156, 329, 329, 329, 329, 418, 418, 418, 418,
+        349, 349, 349, 349, -872, -872, -872, -872, 644, 644, 644, 644, -1590, -1590, -1590, -1590,
+        1119, 1119, 1119, 1119, -602, -602, -602, -602, 1483, 1483, 1483, 1483, -777, -777, -777, -777,
+        -147, -147, -147, -147, 1159, 1159, 1159, 1159, 778, 778, 778, 778, -246, -246, -246, -246,
+        1653, 1653, 1653, 1653, 1574, 1574, 1574, 1574, -460, -460, -460, -460, -291, -291, -291, -291,
+        -235, -235, -235, -235, 177, 177, 177, 177, 587, 587, 587, 587, 422, 422, 422, 422,
+        105, 105, 105, 105, 1550, 1550, 1550, 1550, 871, 871, 871, 871, -1251, -1251, -1251, -1251,
+        843, 843, 843, 843, 555, 555, 555, 555, 430, 430, 430, 430, -1103, -1103, -1103, -1103
+    },
+    {
+        -1275, -1275, -1275, -1275, -1275, -1275, -1275, -1275, 677, 677, 677, 677, 677, 677, 677, 677,
+        -1065, -1065, -1065, -1065, -1065, -1065, -1065, -1065, 448, 448, 448, 448, 448, 448, 448, 448,
+        -725, -725, -725, -725, -725, -725, -725, -725, -1508, -1508, -1508, -1508, -1508, -1508, -1508, -1508,
+        961, 961, 961, 961, 961, 961, 961, 961, -398, -398, -398, -398, -398, -398, -398, -398,
+        -951, -951, -951, -951, -951, -951, -951, -951, -247, -247, -247, -247, -247, -247, -247, -247,
+        -1421, -1421, -1421, -1421, -1421, -1421, -1421, -1421, 107, 107, 107, 107, 107, 107, 107, 107,
+        830, 830, 830, 830, 830, 830, 830, 830, -271, -271, -271, -271, -271, -271, -271, -271,
+        -90, -90, -90, -90, -90, -90, -90, -90, -853, -853, -853, -853, -853, -853, -853, -853,
+        1469, 1469, 1469, 1469, 1469, 1469, 1469, 1469, 126, 126, 126, 126, 126, 126, 126, 126,
+        -1162, -1162, -1162, -1162, -1162, -1162, -1162, -1162, -1618, -1618, -1618, -1618, -1618, -1618, -1618, -1618,
+        -666, -666, -666, -666, -666, -666, -666, -666, -320, -320, -320, -320, -320, -320, -320, -320,
+        -8, -8, -8, -8, -8, -8, -8, -8, 516, 516, 516, 516, 516, 516, 516, 516,
+        -1544, -1544, -1544, -1544, -1544, -1544, -1544, -1544, -282, -282, -282, -282, -282, -282, -282, -282,
+        1491, 1491, 1491, 1491, 1491, 1491, 1491, 1491, -1293, -1293, -1293, -1293, -1293, -1293, -1293, -1293,
+        1015, 1015, 1015, 1015, 1015, 1015, 1015, 1015, -552, -552, -552, -552, -552, -552, -552, -552,
+        652, 652, 652, 652, 652, 652, 652, 652, 1223, 1223, 1223, 1223, 1223, 1223, 1223, 1223
+    }
+};
+
+// vecext_zetas_basemul[c] = zetas_basemul[c / 2]
+static const int16_t vecext_zetas_basemul[256] __attribute__((aligned(16))) = {
+    -1103, -1103, 1103, 1103, 430, 430, -430, -430, 555, 555, -555, -555, 843, 843, -843, -843,
+    -1251, -1251, 1251, 1251, 871, 871, -871, -871, 1550, 1550, -1550, -1550, 105, 105, -105, -105,
+    422, 422, -422, -422, 587, 587, -587, -587, 177, 177, -177, -177, -235, -235, 235, 235,
+    -291, -291, 291, 291, -460, -460, 460, 460, 1574, 1574, -1574, -1574, 1653, 1653, -1653, -1653,
+    -246, -246, 246, 246, 778, 778, -778, -778, 1159, 1159, -1159, -1159, -147, -147, 147, 147,
+    -777, -777, 777, 777, 1483, 1483, -1483, -1483, -602, -602, 602, 602, 1119, 1119, -1119, -1119,
+    -1590, -1590, 1590, 1590, 644, 644, -644, -644, -872, -872, 872, 872, 349, 349, -349, -349,
+    418, 418, -418, -418, 329, 329, -329, -329, -156, -156, 156, 156, -75, -75, 75, 75,
+    817, 817, -817, -817, 1097, 1097, -1097, -1097, 603, 603, -603, -603, 610, 610, -610, -610,
+    1322, 1322, -1322, -1322, -1285, -1285, 1285, 1285, -1465, -1465, 1465, 1465, 384, 384, -384, -384,
+    -1215, -1215, 1215, 1215, -136, -136, 136, 136, 1218, 1218, -1218, -1218, -1335, -1335, 1335, 1335,
+    -874, -874, 874, 874, 220, 220, -220, -220, -1187, -1187, 1187, 1187, -1659, -1659, 1659, 1659,
+    -1185, -1185, 1185, 1185, -1530, -1530, 1530, 1530, -1278, -1278, 1278, 1278, 794, 794, -794, -794,
+    -1510, -1510, 1510, 1510, -854, -854, 854, 854, -870, -870, 870, 870, 478, 478, -478, -478,
+    -108, -108, 108, 108, -308, -308, 308, 308, 996, 996, -996, -996, 991, 991, -991, -991,
+    958, 958, -958, -958, -1460, -1460, 1460, 1460, 1522, 1522, -1522, -1522, 1628, 1628, -1628, -1628
+};
+
+static inline vec16_t load_vec(const int16_t* src) {
+    vec16_t v;
+
+    memcpy(&v, src, sizeof(vec16_t));
+    return v;
+}
+
+static inline void store_vec(int16_t* dst, vec16_t v) {
+    memcpy(dst, &v, sizeof(vec16_t));
+}
+
+/**
+ * @brief Lane-wise mask ? a : b, mask lanes should be 0 or -1
+ */
+static inline vec16_t select_vec(vec16_t mask, vec16_t a, vec16_t b) {
+    return (mask & a) | (~mask & b);
+}
+
+/*******/
+/* NTT */
+/*******/
+
+/**
+ * @brief Sends an array to its NTT transform
+ * @details Same output as NTT. For len >= VECEXT_LANES the butterflies of a block are done VECEXT_LANES at a time.
+ *          For smaller len both halves of a butterfly lie in the same vector : every lane computes its own half,
+ *          reading its partner at distance len, and the zetas come from the lane-expanded tables.
+ */
+void NTT_vecext(int16_t tab[256]) {
+    int len, start, i, j, p;
+    int16_t buf[VECEXT_PAD + 256 + VECEXT_PAD] = {0};
+    int16_t* f = buf + VECEXT_PAD;
+    vec16_t x, y_plus, y_minus, low, z, t;
+
+    memcpy(f, tab, 256 * sizeof(int16_t));
+
+    i = 1;
+
+    for (len = 128; len >= VECEXT_LANES; len >>= 1) {
+        for (start = 0; start < 256; start += 2*len) {
+            z = (vec16_t){0} + zetas[i++];
+            for (j = start; j < start + len; j += VECEXT_LANES) {
+                x = load_vec(f + j);
+                t = fqmul_vec(z, load_vec(f + j + len));
+                store_vec(f + j + len, barrett_reduce_vec(x - t));
+                store_vec(f + j, barrett_reduce_vec(x + t));
+            }
+        }
+    }
+
+    for (len = VECEXT_LANES / 2; len >= 2; len >>= 1) {
+        for (p = 0; p < 256; p += VECEXT_LANES) {
+            x = load_vec(f + p);
+            y_plus = load_vec(f + p + len);
+            y_minus = load_vec(f + p - len);
+            low = (((int16_t)p + lane_index) & (int16_t)len) == 0;
+            z = load_vec(&vecext_zetas_ntt[len >> 2][p]);
+            // low lane j : f[j] + zeta * f[j + len], high lane j + len : f[j] - zeta * f[j + len]
+            t = fqmul_vec(z, select_vec(low, y_plus, x));
+            t = select_vec(low, t, -t);
+            store_vec(f + p, barrett_reduce_vec(select_vec(low, x, y_minus) + t));
+        }
+    }
+
+    memcpy(tab, f, 256 * sizeof(int16_t));
+}
+
+/**
+ * @brief Inverse NTT transform followed by a multiplication of every coefficient by factor * R^{-1}
+ * @details Same output as NTT_inv_scaled, see NTT_vecext for the layers with len < VECEXT_LANES
+ */
+void NTT_inv_scaled_vecext(int16_t tab[256], const int16_t factor) {
+    int len, start, i, j, p;
+    int16_t buf[VECEXT_PAD + 256 + VECEXT_PAD] = {0};
+    int16_t* f = buf + VECEXT_PAD;
+    vec16_t x, y, low, z, sum, diff;
+
+    memcpy(f, tab, 256 * sizeof(int16_t));
+
+    for (len = 2; len < VECEXT_LANES; len <<= 1) {
+        for (p = 0; p < 256; p += VECEXT_LANES) {
+            x = load_vec(f + p);
+            low = (((int16_t)p + lane_index) & (int16_t)len) == 0;
+            z = load_vec(&vecext_zetas_ntt_inv[len >> 2][p]);
+            // low lane j : f[j] + f[j + len], high lane j + len : zeta * (f[j + len] - f[j])
+            sum = barrett_reduce_vec(x + load_vec(f + p + len));
+            diff = fqmul_vec(z, x - load_vec(f + p - len));
+            store_vec(f + p, select_vec(low, sum, diff));
+        }
+    }
+
+    i = 256 / VECEXT_LANES - 1;
+
+    for (len = VECEXT_LANES; len <= 128; len <<= 1) {
+        for (start = 0; start < 256; start += 2*len) {
+            z = (vec16_t){0} + zetas[i--];
+            for (j = start; j < start + len; j += VECEXT_LANES) {
+                x = load_vec(f + j);
+                y = load_vec(f + j + len);
+                store_vec(f + j, barrett_reduce_vec(x + y));
+                store_vec(f + j + len, fqmul_vec(z, y - x));
+            }
+        }
+    }
+
+    z = (vec16_t){0} + factor;
+    for (j = 0; j < 256; j += VECEXT_LANES) {
+        store_vec(tab + j, fqmul_vec(load_vec(f + j), z));
+    }
+}
+
+/**
+ * @brief Sends an array to its inverse NTT transform
+ * @details Same output as NTT_inv
+ */
+void NTT_inv_vecext(int16_t tab[256]) {
+    NTT_inv_scaled_vecext(tab, NTT_INV_FACTOR_R0);
+}
+
+/**
+ * @brief Multiplies two NTT together
+ * @details Same output as NTT_multiply. Each coefficient pair (a_0, a_1) is swapped inside its 32-bit lane to give
+ *          every lane the other half of its pair, even lanes then compute r_0 and odd lanes r_1.
+ */
+void NTT_multiply_vecext(int16_t r[256], const int16_t a[256], const int16_t b[256]) {
+    int p;
+    vec16_t va, vb, a_sw, b_sw, m, even, r0, r1;
+    vecpair_t w;
+
+    even = (lane_index & 1) == 0;
+
+    for (p = 0; p < 256; p += VECEXT_LANES) {
+        va = load_vec(a + p);
+        vb = load_vec(b + p);
+
+        w = (vecpair_t)va;
+        a_sw = (vec16_t)((w << 16) | (w >> 16));
+        w = (vecpair_t)vb;
+        b_sw = (vec16_t)((w << 16) | (w >> 16));
+
+        m = load_vec(&vecext_zetas_basemul[p]);
+
+        r0 = fqmul_vec(fqmul_vec(a_sw, b_sw), m) + fqmul_vec(va, vb);
+        r1 = fqmul_vec(a_sw, vb) + fqmul_vec(va, b_sw);
+        store_vec(r + p, select_vec(even, r0, r1));
+    }
+}
+
+/********************************/
+/* ARITHMETIC OPERATIONS IN R_q */
+/********************************/
+
+/**
+ * @brief Addition in R_q, same output as poly_add
+ */
+void poly_add_vecext(poly_t* r, const poly_t* a, const poly_t* b) {
+    int i;
+
+    for (i = 0; i < KYBER_N; i += VECEXT_LANES) {
+        store_vec(r->coeffs + i, barrett_reduce_vec(load_vec(a->coeffs + i) + load_vec(b->coeffs + i)));
+    }
+}
+
+/**
+ * @brief Subtraction in R_q, same output as poly_sub
+ */
+void poly_sub_vecext(poly_t* r, const poly_t* a, const poly_t* b) {
+    int i;
+
+    for (i = 0; i < KYBER_N; i += VECEXT_LANES) {
+        store_vec(r->coeffs + i, barrett_reduce_vec(load_vec(a->coeffs + i) - load_vec(b->coeffs + i)));
+    }
+}
+
+/***************/
+/* COMPRESSION */
+/***************/
+
+/**
+ * @brief Compresses all the coefficients of f, same output as poly_compress
+ */
+void poly_compress_vecext(poly_t* f, const unsigned d) {
+    int i;
+    vec32_t x;
+    vecu64_t t;
+
+    for (i = 0; i < KYBER_N; i += VECEXT_LANES) {
+        x = __builtin_convertvector(load_vec(f->coeffs + i), vec32_t);
+        x += (x >> 15) & KYBER_Q;
+        t = __builtin_convertvector(__builtin_convertvector((x << (int)d) + KYBER_Q / 2, vecu32_t), vecu64_t);
+        t = (t * COMPRESS_FACTOR) >> 33;
+        t &= (1U << d) - 1;
+        store_vec(f->coeffs + i, __builtin_convertvector(t, vec16_t));
+    }
+}
+
+#endif
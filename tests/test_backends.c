@@ -0,0 +1,583 @@
+/**
+ * @file test_backends.c
+ * @details Differential test of every backend of the dispatched kernels, of the lazy products and of the operations
+ *          that pick their AVX2 kernel by themselves against the scalar reference, on the same seeded random inputs
+ *          and edge cases, followed by a kernel x backend throughput matrix
+ * @author Gabriel Abauzit
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "consts.h"
+#include "reduce.h"
+#include "poly.h"
+#include "ntt.h"
+#include "encode.h"
+#include "dispatch.h"
+#include "poly_avx2.h"
+
+#ifndef NUM_TRIALS
+	#define NUM_TRIALS 1000
+#endif
+
+// Calls of each kernel timed for the throughput matrix
+#ifndef MATRIX_ITERATIONS
+	#define MATRIX_ITERATIONS 2000
+#endif
+
+#define MAX_BACKENDS 8
+
+// Inputs 0 to EDGE_CASES-1 are the edge cases, the next ones are drawn from the seeded stream
+#define EDGE_CASES 5
+
+static const unsigned encode_ds[] = {1, 4, 5, KYBER_DU, 11, 12};
+static const unsigned compress_ds[] = {1, 4, 5, KYBER_DU, 11};
+
+// Rows of the operations of poly.h that route to their AVX2 kernel without the dispatch table, after its kernels
+typedef enum {
+	ROW_DECOMPRESS = DISPATCH_KERNELS,
+	ROW_DECODE12_CHECKED,
+	ROW_FROMMSG,
+	ROW_TOMSG,
+	ROWS
+} row_t;
+
+static const char* row_names[ROWS - DISPATCH_KERNELS] = {"decompress", "decode12_chk", "frommsg", "tomsg"};
+
+// Backends outside of the dispatch table : the lazy products, that replace NTT_multiply when an operand is reused, and
+// the two kernels of each row above
+typedef struct {
+	int row;
+	const char* name;
+} extra_backend_t;
+
+static const extra_backend_t extra_backends[] = {
+	{DISPATCH_NTT_MULTIPLY, "cached"},
+	{DISPATCH_NTT_MULTIPLY, "packed"},
+	{ROW_DECOMPRESS, "ref"},
+	{ROW_DECOMPRESS, "avx2"},
+	{ROW_DECODE12_CHECKED, "ref"},
+	{ROW_DECODE12_CHECKED, "avx2"},
+	{ROW_FROMMSG, "ref"},
+	{ROW_FROMMSG, "avx2"},
+	{ROW_TOMSG, "ref"},
+	{ROW_TOMSG, "avx2"},
+};
+
+#define EXTRA_BACKENDS (sizeof(extra_backends) / sizeof(extra_backends[0]))
+
+// Kernel f##_avx2 or f##_ref, the first one only exists in builds with POLY_AVX2_AVAILABLE
+#ifdef POLY_AVX2_AVAILABLE
+	#define AVX2_OR_REF(avx2, f) ((avx2) ? f##_avx2 : f##_ref)
+#else
+	#define AVX2_OR_REF(avx2, f) ((void)(avx2), f##_ref)
+#endif
+
+uint64_t stream_state;
+
+uint64_t stream_next() {
+	uint64_t z = (stream_state += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/**
+ * @brief Input number c of a kernel, with coefficients in [-bound, bound]
+ * @details Edge cases : all-zero, all bound, all -bound, alternating bound and -bound, and bound on a single coefficient
+ */
+void input_poly(int16_t f[KYBER_N], const int c, const int16_t bound) {
+	int i;
+
+	for (i = 0; i < KYBER_N; i++) {
+		switch (c) {
+			case 0: f[i] = 0; break;
+			case 1: f[i] = bound; break;
+			case 2: f[i] = (int16_t)-bound; break;
+			case 3: f[i] = (int16_t)(i % 2 ? -bound : bound); break;
+			case 4: f[i] = (int16_t)(i == KYBER_N - 1 ? bound : 0); break;
+			default: f[i] = (int16_t)((int)(stream_next() % (uint64_t)(2 * bound + 1)) - bound); break;
+		}
+	}
+}
+
+/**
+ * @brief Input number c of byte_encode with parameter d, in [0, 2^d) or [0, q) for d = 12
+ */
+void input_encode(int16_t f[KYBER_N], const int c, const unsigned d) {
+	const int16_t max = d == 12 ? KYBER_Q - 1 : (int16_t)((1 << d) - 1);
+	int i;
+
+	for (i = 0; i < KYBER_N; i++) {
+		switch (c) {
+			case 0: f[i] = 0; break;
+			case 1: f[i] = max; break;
+			case 2: f[i] = (int16_t)(i % 2 ? max : 0); break;
+			case 3: f[i] = (int16_t)(i % (max + 1)); break;
+			case 4: f[i] = (int16_t)(i == KYBER_N - 1 ? max : 0); break;
+			default: f[i] = (int16_t)(stream_next() % (uint64_t)(max + 1)); break;
+		}
+	}
+}
+
+/**
+ * @brief Input number c of byte_decode, 32 d bytes
+ */
+void input_decode(uint8_t bytes[KYBER_N * 12 / 8], const int c, const unsigned d) {
+	unsigned i;
+
+	for (i = 0; i < 32 * d; i++) {
+		switch (c) {
+			case 0: bytes[i] = 0x00; break;
+			case 1: bytes[i] = 0xFF; break;
+			case 2: bytes[i] = 0xAA; break;
+			case 3: bytes[i] = (uint8_t)i; break;
+			case 4: bytes[i] = (uint8_t)(i == 32 * d - 1 ? 0x80 : 0); break;
+			default: bytes[i] = (uint8_t)stream_next(); break;
+		}
+	}
+}
+
+/*****************************/
+/* DIFFERENTIAL CONFORMANCE */
+/*****************************/
+
+/**
+ * @brief Runs the kernel installed for k on input c and the scalar reference on the same input
+ * @return 0 if the outputs are bit-exact, 1 otherwise
+ */
+int check_input(const dispatch_kernel_t k, const int c) {
+	int16_t a[KYBER_N], b[KYBER_N], got[KYBER_N], expected[KYBER_N];
+	uint8_t bytes[KYBER_N * 12 / 8], bytes_ref[KYBER_N * 12 / 8];
+	poly_t f, g;
+	size_t i;
+
+	switch (k) {
+		case DISPATCH_NTT:
+			input_poly(a, c, POLY_BOUND_CANONICAL);
+			memcpy(got, a, sizeof(a));
+			memcpy(expected, a, sizeof(a));
+			NTT(got);
+			NTT_ref(expected);
+			return memcmp(got, expected, sizeof(got)) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+		case DISPATCH_NTT_INV:
+			// The inverse NTT takes the unreduced sums of the products
+			input_poly(a, c, POLY_BOUND_PRODUCT);
+			memcpy(got, a, sizeof(a));
+			memcpy(expected, a, sizeof(a));
+			NTT_inv_scaled(got, NTT_INV_FACTOR_R1);
+			NTT_inv_scaled_ref(expected, NTT_INV_FACTOR_R1);
+			return memcmp(got, expected, sizeof(got)) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+		case DISPATCH_NTT_MULTIPLY:
+			input_poly(a, c, POLY_BOUND_CANONICAL);
+			input_poly(b, c < EDGE_CASES ? (c + 2) % EDGE_CASES : c, POLY_BOUND_CANONICAL);
+			NTT_multiply(got, a, b);
+			NTT_multiply_ref(expected, a, b);
+			return memcmp(got, expected, sizeof(got)) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+		case DISPATCH_BYTE_ENCODE:
+			for (i = 0; i < sizeof(encode_ds) / sizeof(encode_ds[0]); i++) {
+				input_encode(a, c, encode_ds[i]);
+				byte_encode(bytes, a, encode_ds[i]);
+				byte_encode_ref(bytes_ref, a, encode_ds[i]);
+				if (memcmp(bytes, bytes_ref, 32 * encode_ds[i]) != 0) return EXIT_FAILURE;
+			}
+			return EXIT_SUCCESS;
+
+		case DISPATCH_BYTE_DECODE:
+			for (i = 0; i < sizeof(encode_ds) / sizeof(encode_ds[0]); i++) {
+				input_decode(bytes, c, encode_ds[i]);
+				byte_decode(got, bytes, encode_ds[i]);
+				byte_decode_ref(expected, bytes, encode_ds[i]);
+				if (memcmp(got, expected, sizeof(got)) != 0) return EXIT_FAILURE;
+			}
+			return EXIT_SUCCESS;
+
+		case DISPATCH_COMPRESS:
+			for (i = 0; i < sizeof(compress_ds) / sizeof(compress_ds[0]); i++) {
+				input_poly(f.coeffs, c, POLY_BOUND_CANONICAL);
+				g = f;
+				poly_compress(&f, compress_ds[i]);
+				poly_compress_ref(&g, compress_ds[i]);
+				if (memcmp(f.coeffs, g.coeffs, sizeof(f.coeffs)) != 0) return EXIT_FAILURE;
+			}
+			return EXIT_SUCCESS;
+
+		default:
+			return EXIT_FAILURE;
+	}
+}
+
+/**
+ * @brief Checks every backend of kernel k on the edge cases and NUM_TRIALS seeded random inputs
+ * @details Every backend sees the same inputs, the stream being reseeded before each one. A mismatch is reported with
+ *          the backend and the input number, which replays it.
+ */
+int check_kernel(const dispatch_kernel_t k) {
+	const char* names[MAX_BACKENDS];
+	size_t n, v;
+	int c, status = EXIT_SUCCESS;
+
+	n = dispatch_variants(k, names, MAX_BACKENDS);
+	if (n == 0 || n > MAX_BACKENDS) return EXIT_FAILURE;
+
+	for (v = 0; v < n; v++) {
+		if (dispatch_select(k, names[v]) == EXIT_FAILURE) return EXIT_FAILURE;
+		stream_state = 0x5eed0000 + (uint64_t)k;
+
+		for (c = 0; c < EDGE_CASES + NUM_TRIALS; c++) {
+			if (check_input(k, c) == EXIT_FAILURE) {
+				printf("   %s / %s differs from the reference on input %d\n", dispatch_kernel_name(k), names[v], c);
+				status = EXIT_FAILURE;
+				break;
+			}
+		}
+	}
+
+	dispatch_reset();
+	return status;
+}
+
+/******************/
+/* OTHER BACKENDS */
+/******************/
+
+const char* row_name(const int row) {
+	return row < DISPATCH_KERNELS ? dispatch_kernel_name((dispatch_kernel_t)row) : row_names[row - DISPATCH_KERNELS];
+}
+
+int extra_is_avx2(const size_t e) {
+	return strcmp(extra_backends[e].name, "avx2") == 0;
+}
+
+int extra_supported(const size_t e) {
+	if (!extra_is_avx2(e)) return 1;
+#ifdef POLY_AVX2_AVAILABLE
+	return poly_avx2_supported();
+#else
+	return 0;
+#endif
+}
+
+/**
+ * @brief Runs the backend e of extra_backends on input c and the scalar reference on the same input, see check_input
+ * @return 0 if the outputs are bit-exact, 1 otherwise
+ */
+int check_extra_input(const size_t e, const int c) {
+	const int avx2 = extra_is_avx2(e);
+	int16_t a[KYBER_N], b[KYBER_N], cache[KYBER_N / 2], got[KYBER_N], expected[KYBER_N];
+	uint8_t bytes[KYBER_N * 12 / 8], msg[KYBER_N / 8], msg_ref[KYBER_N / 8];
+	poly_packed_t packed;
+	poly_t f, g;
+	size_t i;
+
+	switch (extra_backends[e].row) {
+		case DISPATCH_NTT_MULTIPLY:
+			input_poly(a, c, POLY_BOUND_CANONICAL);
+			input_poly(b, c < EDGE_CASES ? (c + 2) % EDGE_CASES : c, POLY_BOUND_CANONICAL);
+			NTT_multiply_ref(expected, a, b);
+			if (strcmp(extra_backends[e].name, "packed") == 0) {
+				memcpy(f.coeffs, a, sizeof(a));
+				poly_pack(&packed, &f);
+				NTT_multiply_packed(got, packed.bytes, b);
+			}
+			else {
+				NTT_multiply_cache(cache, a);
+				NTT_multiply_cached(got, a, cache, b);
+			}
+			return memcmp(got, expected, sizeof(got)) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+		case ROW_DECOMPRESS:
+			for (i = 0; i < sizeof(compress_ds) / sizeof(compress_ds[0]); i++) {
+				input_encode(f.coeffs, c, compress_ds[i]);
+				g = f;
+				AVX2_OR_REF(avx2, poly_decompress)(&f, compress_ds[i]);
+				poly_decompress_ref(&g, compress_ds[i]);
+				if (memcmp(f.coeffs, g.coeffs, sizeof(f.coeffs)) != 0) return EXIT_FAILURE;
+			}
+			return EXIT_SUCCESS;
+
+		case ROW_DECODE12_CHECKED:
+			// Most of the raw inputs hold a coefficient larger than q and are rejected, the encoding of input_encode
+			// is accepted
+			input_decode(bytes, c, 12);
+			if (AVX2_OR_REF(avx2, poly_decode12_checked)(&f, bytes) != poly_decode12_checked_ref(&g, bytes)) return EXIT_FAILURE;
+			if (memcmp(f.coeffs, g.coeffs, sizeof(f.coeffs)) != 0) return EXIT_FAILURE;
+			input_encode(a, c, 12);
+			byte_encode_ref(bytes, a, 12);
+			if (AVX2_OR_REF(avx2, poly_decode12_checked)(&f, bytes) != EXIT_SUCCESS) return EXIT_FAILURE;
+			if (poly_decode12_checked_ref(&g, bytes) != EXIT_SUCCESS) return EXIT_FAILURE;
+			return memcmp(f.coeffs, g.coeffs, sizeof(f.coeffs)) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+		case ROW_FROMMSG:
+			input_decode(bytes, c, 1);
+			AVX2_OR_REF(avx2, poly_frommsg)(&f, bytes);
+			poly_frommsg_ref(&g, bytes);
+			return memcmp(f.coeffs, g.coeffs, sizeof(f.coeffs)) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+		case ROW_TOMSG:
+			input_poly(f.coeffs, c, POLY_BOUND_CANONICAL);
+			AVX2_OR_REF(avx2, poly_tomsg)(msg, &f);
+			poly_tomsg_ref(msg_ref, &f);
+			return memcmp(msg, msg_ref, sizeof(msg)) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+		default:
+			return EXIT_FAILURE;
+	}
+}
+
+/**
+ * @brief Checks the backends of extra_backends in a row that run on this host, on the inputs of check_kernel
+ */
+int check_extra(const int row) {
+	size_t e;
+	int c, status = EXIT_SUCCESS;
+
+	for (e = 0; e < EXTRA_BACKENDS; e++) {
+		if (extra_backends[e].row != row || !extra_supported(e)) continue;
+		stream_state = 0x5eed0000 + (uint64_t)row;
+
+		for (c = 0; c < EDGE_CASES + NUM_TRIALS; c++) {
+			if (check_extra_input(e, c) == EXIT_FAILURE) {
+				printf("   %s / %s differs from the reference on input %d\n", row_name(row), extra_backends[e].name, c);
+				status = EXIT_FAILURE;
+				break;
+			}
+		}
+	}
+
+	return status;
+}
+
+int test_ntt() { return check_kernel(DISPATCH_NTT); }
+int test_ntt_inv() { return check_kernel(DISPATCH_NTT_INV); }
+int test_byte_encode() { return check_kernel(DISPATCH_BYTE_ENCODE); }
+int test_byte_decode() { return check_kernel(DISPATCH_BYTE_DECODE); }
+int test_compress() { return check_kernel(DISPATCH_COMPRESS); }
+int test_decompress() { return check_extra(ROW_DECOMPRESS); }
+int test_decode12_checked() { return check_extra(ROW_DECODE12_CHECKED); }
+int test_frommsg() { return check_extra(ROW_FROMMSG); }
+int test_tomsg() { return check_extra(ROW_TOMSG); }
+
+int test_ntt_multiply() {
+	int status = check_kernel(DISPATCH_NTT_MULTIPLY);
+
+	return check_extra(DISPATCH_NTT_MULTIPLY) == EXIT_FAILURE ? EXIT_FAILURE : status;
+}
+
+/*********************/
+/* THROUGHPUT MATRIX */
+/*********************/
+
+uint64_t now_ns() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Average time in ns of one call of the kernel installed for k, on the parameters KEM uses the most
+ */
+double time_kernel(const dispatch_kernel_t k) {
+	static int16_t a[KYBER_N], b[KYBER_N];
+	static uint8_t bytes[KYBER_N * 12 / 8];
+	static poly_t f;
+	uint64_t start;
+	int i;
+
+	stream_state = 1;
+	input_poly(a, EDGE_CASES, POLY_BOUND_CANONICAL);
+	input_poly(b, EDGE_CASES, POLY_BOUND_CANONICAL);
+	input_decode(bytes, EDGE_CASES, 12);
+	memcpy(f.coeffs, a, sizeof(a));
+
+	start = now_ns();
+	for (i = 0; i < MATRIX_ITERATIONS; i++) {
+		switch (k) {
+			case DISPATCH_NTT: NTT(a); break;
+			case DISPATCH_NTT_INV: NTT_inv_scaled(a, NTT_INV_FACTOR_R1); break;
+			case DISPATCH_NTT_MULTIPLY: NTT_multiply(a, a, b); break;
+			case DISPATCH_BYTE_ENCODE: byte_encode(bytes, b, KYBER_DV); break;
+			case DISPATCH_BYTE_DECODE: byte_decode(a, bytes, KYBER_DU); break;
+			case DISPATCH_COMPRESS: memcpy(f.coeffs, b, sizeof(b)); poly_compress(&f, KYBER_DU); break;
+			default: break;
+		}
+	}
+	return (double)(now_ns() - start) / MATRIX_ITERATIONS;
+}
+
+/**
+ * @brief Average time in ns of one call of the backend e of extra_backends, on the parameters KEM uses the most
+ * @details The lazy products are timed without their precomputation, that is done once per reused operand.
+ */
+double time_extra(const size_t e) {
+	static int16_t a[KYBER_N], b[KYBER_N], cache[KYBER_N / 2], r[KYBER_N], compressed[KYBER_N];
+	static uint8_t bytes[KYBER_N * 12 / 8], msg[KYBER_N / 8];
+	static poly_packed_t packed;
+	static poly_t f;
+	const int avx2 = extra_is_avx2(e), cached = strcmp(extra_backends[e].name, "cached") == 0;
+	uint64_t start;
+	int i;
+
+	stream_state = 1;
+	input_poly(a, EDGE_CASES, POLY_BOUND_CANONICAL);
+	input_poly(b, EDGE_CASES, POLY_BOUND_CANONICAL);
+	input_encode(compressed, EDGE_CASES, KYBER_DU);
+	memcpy(f.coeffs, a, sizeof(a));
+	NTT_multiply_cache(cache, a);
+	poly_pack(&packed, &f);
+	// Canonical coefficients for the checked decoding, which must accept them
+	for (i = 0; i < KYBER_N; i++) {
+		f.coeffs[i] = (int16_t)(a[i] + ((a[i] >> 15) & KYBER_Q));
+	}
+	byte_encode_ref(bytes, f.coeffs, 12);
+	memcpy(f.coeffs, a, sizeof(a));
+
+	start = now_ns();
+	for (i = 0; i < MATRIX_ITERATIONS; i++) {
+		switch (extra_backends[e].row) {
+			case DISPATCH_NTT_MULTIPLY:
+				if (cached) NTT_multiply_cached(r, a, cache, b);
+				else NTT_multiply_packed(r, packed.bytes, b);
+				break;
+			case ROW_DECOMPRESS: memcpy(f.coeffs, compressed, sizeof(compressed)); AVX2_OR_REF(avx2, poly_decompress)(&f, KYBER_DU); break;
+			case ROW_DECODE12_CHECKED: AVX2_OR_REF(avx2, poly_decode12_checked)(&f, bytes); break;
+			case ROW_FROMMSG: AVX2_OR_REF(avx2, poly_frommsg)(&f, bytes); break;
+			case ROW_TOMSG: AVX2_OR_REF(avx2, poly_tomsg)(msg, &f); break;
+			default: break;
+		}
+	}
+	return (double)(now_ns() - start) / MATRIX_ITERATIONS;
+}
+
+/**
+ * @brief Prints the time of every kernel with every backend, "-" where the backend does not exist or does not run here
+ */
+void print_matrix() {
+	const char* columns[MAX_BACKENDS * DISPATCH_KERNELS + EXTRA_BACKENDS];
+	const char* names[MAX_BACKENDS];
+	size_t ncols = 0, n, v, col, e;
+	int k;
+
+	for (k = 0; k < DISPATCH_KERNELS; k++) {
+		n = dispatch_variants((dispatch_kernel_t)k, names, MAX_BACKENDS);
+		for (v = 0; v < n && v < MAX_BACKENDS; v++) {
+			for (col = 0; col < ncols && strcmp(columns[col], names[v]) != 0; col++);
+			if (col == ncols) columns[ncols++] = names[v];
+		}
+	}
+	for (e = 0; e < EXTRA_BACKENDS; e++) {
+		for (col = 0; col < ncols && strcmp(columns[col], extra_backends[e].name) != 0; col++);
+		if (col == ncols) columns[ncols++] = extra_backends[e].name;
+	}
+
+	printf("%-14s", "ns/call");
+	for (col = 0; col < ncols; col++) printf(" %10s", columns[col]);
+	printf("\n");
+
+	for (k = 0; k < ROWS; k++) {
+		printf("%-14s", row_name(k));
+		for (col = 0; col < ncols; col++) {
+			if (k < DISPATCH_KERNELS && dispatch_select((dispatch_kernel_t)k, columns[col]) == EXIT_SUCCESS) {
+				printf(" %10.1f", time_kernel((dispatch_kernel_t)k));
+				continue;
+			}
+			for (e = 0; e < EXTRA_BACKENDS; e++) {
+				if (extra_backends[e].row == k && strcmp(extra_backends[e].name, columns[col]) == 0 && extra_supported(e)) break;
+			}
+			if (e == EXTRA_BACKENDS) printf(" %10s", "-");
+			else printf(" %10.1f", time_extra(e));
+		}
+		printf("\n");
+	}
+	dispatch_reset();
+}
+
+/**********************/
+/* DISPLAYING RESULTS */
+/**********************/
+
+void display_results(int num, int success, int* test_success) {
+	if (success == EXIT_SUCCESS) {
+		(*test_success)++;
+		printf("✅ TEST %i : Successful\n", num);
+	}
+	else {
+		printf("❌ TEST %i : Failure\n", num);
+	}
+}
+
+void run_test(int num, int (*test)(void), int trials, int* test_success, int* test_total) {
+	int i;
+	int success = EXIT_SUCCESS;
+
+	for (i = 0; i < trials; i++) {
+		if (test() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(num, success, test_success);
+	(*test_total)++;
+}
+
+/********************/
+/* TESTS EXECUTIONS */
+/********************/
+
+int main() {
+
+	int test_success = 0;
+	int test_total = 0;
+
+	printf("╔══════════════════════════════════════╗\n");
+	printf("║   RUNNING KYBER-mini BACKENDS TESTS  ║\n");
+	printf("╚══════════════════════════════════════╝\n");
+
+	// Each test runs all the backends of a kernel on the same EDGE_CASES + NUM_TRIALS inputs
+	run_test(1, test_ntt, 1, &test_success, &test_total);
+	run_test(2, test_ntt_inv, 1, &test_success, &test_total);
+	run_test(3, test_ntt_multiply, 1, &test_success, &test_total);
+	run_test(4, test_byte_encode, 1, &test_success, &test_total);
+	run_test(5, test_byte_decode, 1, &test_success, &test_total);
+	run_test(6, test_compress, 1, &test_success, &test_total);
+	run_test(7, test_decompress, 1, &test_success, &test_total);
+	run_test(8, test_decode12_checked, 1, &test_success, &test_total);
+	run_test(9, test_frommsg, 1, &test_success, &test_total);
+	run_test(10, test_tomsg, 1, &test_success, &test_total);
+
+	/*********************/
+	/* THROUGHPUT MATRIX */
+	/*********************/
+
+	printf("╔════════════════════════════════════════╗\n");
+	printf("║           THROUGHPUT MATRIX            ║\n");
+	printf("╚════════════════════════════════════════╝\n");
+	print_matrix();
+
+	/*****************/
+	/* FINAL SUMMARY */
+	/*****************/
+
+	printf("╔════════════════════════════════════════╗\n");
+	printf("║              FINAL SUMMARY             ║\n");
+	printf("╚════════════════════════════════════════╝\n");
+	printf("Successful tests : %i/%i\n", test_success, test_total);
+
+	if (test_success == test_total) {
+		printf("🎉 ALL TESTS WERE SUCCESSFUL 🎉\n");
+		return EXIT_SUCCESS;
+	}
+	else {
+		printf("⚠️  %i TEST(S) FAILED.\n", test_total - test_success);
+		return EXIT_FAILURE;
+	}
+
+}
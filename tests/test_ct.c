@@ -0,0 +1,326 @@
+/**
+ * @file test_ct.c
+ * @details Test the constant time comparison, conditional move and erasure : results against memcmp and a bytewise select,
+ *          then, with CT_TIMING, a dudect-style timing test (Welch's t-test between two classes of inputs). The
+ *          timing tests are left out by default : their threshold is only meaningful on a quiet machine, not on a
+ *          shared CI runner.
+ * @author Gabriel Abauzit
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "ct.h"
+#include "serialize.h"
+
+#ifndef NUM_TRIALS
+	#define NUM_TRIALS 100
+#endif
+
+// Measurements per timing test, and the share of the slowest ones discarded as interrupts and migrations
+#ifndef CT_MEASUREMENTS
+	#define CT_MEASUREMENTS 200000
+#endif
+#define CT_CROP_PERCENT 90
+
+// dudect considers |t| > 10 as a definite leak, the constant time functions must stay below
+#define CT_T_THRESHOLD 10.0
+
+/*********/
+/* TOOLS */
+/*********/
+
+void random_bytes(uint8_t* a, const size_t len) {
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		a[i] = (uint8_t)rand();
+	}
+}
+
+static inline uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+	uint32_t lo, hi;
+
+	__asm__ volatile("lfence\n\trdtsc" : "=a"(lo), "=d"(hi) :: "memory");
+	return ((uint64_t)hi << 32) | lo;
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+int compare_u64(const void* a, const void* b) {
+	const uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief Welch's t statistic between the two classes of measurements, after cropping the slowest ones
+ * @param[in] times n measurements
+ * @param[in] classes class (0 or 1) of each measurement
+ * @param[in] n
+ * @return t, large in absolute value when the running time depends on the class
+ */
+double welch_t(const uint64_t* times, const uint8_t* classes, const size_t n) {
+	uint64_t* sorted = malloc(n * sizeof(uint64_t));
+	uint64_t cutoff;
+	double mean[2] = {0, 0}, m2[2] = {0, 0}, count[2] = {0, 0}, delta, var0, var1;
+	size_t i;
+	int c;
+
+	memcpy(sorted, times, n * sizeof(uint64_t));
+	qsort(sorted, n, sizeof(uint64_t), compare_u64);
+	cutoff = sorted[n * CT_CROP_PERCENT / 100];
+	free(sorted);
+
+	// Online mean and variance (Welford), as dudect does
+	for (i = 0; i < n; i++) {
+		if (times[i] > cutoff) continue;
+		c = classes[i];
+		count[c] += 1;
+		delta = (double)times[i] - mean[c];
+		mean[c] += delta / count[c];
+		m2[c] += delta * ((double)times[i] - mean[c]);
+	}
+	if (count[0] < 2 || count[1] < 2) return 0;
+
+	var0 = m2[0] / (count[0] - 1);
+	var1 = m2[1] / (count[1] - 1);
+	if (var0 + var1 == 0) return 0;
+	return (mean[0] - mean[1]) / sqrt(var0 / count[0] + var1 / count[1]);
+}
+
+/**********************/
+/* FUNCTIONAL RESULTS */
+/**********************/
+
+// TEST 1 : ct_differ agrees with memcmp, for a difference on any single byte and any bit of it
+
+int test_differ() {
+	uint8_t a[CIPHERTEXT_BYTES], b[CIPHERTEXT_BYTES];
+	const size_t len = 1 + (size_t)rand() % CIPHERTEXT_BYTES;
+	size_t i;
+
+	random_bytes(a, len);
+	memcpy(b, a, len);
+	if (ct_differ(a, b, len) != 0) return EXIT_FAILURE;
+
+	for (i = 0; i < len; i++) {
+		b[i] ^= (uint8_t)(1 << (rand() % 8));
+		if (ct_differ(a, b, len) != 1) return EXIT_FAILURE;
+		b[i] = a[i];
+	}
+
+	random_bytes(b, len);
+	if (ct_differ(a, b, len) != (memcmp(a, b, len) != 0)) return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
+
+// TEST 2 : accumulating ct_diff over pieces of any length gives the same answer as one comparison
+
+int test_diff_pieces() {
+	uint8_t a[CIPHERTEXT_BYTES], b[CIPHERTEXT_BYTES];
+	uint64_t acc = 0;
+	size_t i = 0, piece;
+
+	random_bytes(a, CIPHERTEXT_BYTES);
+	memcpy(b, a, CIPHERTEXT_BYTES);
+	if (rand() % 2) b[rand() % CIPHERTEXT_BYTES] ^= 0x80;
+
+	while (i < CIPHERTEXT_BYTES) {
+		piece = (size_t)rand() % 100;
+		if (piece > CIPHERTEXT_BYTES - i) piece = CIPHERTEXT_BYTES - i;
+		acc = ct_diff(acc, a + i, b + i, piece);
+		i += piece;
+	}
+	if (ct_nonzero(acc) != ct_differ(a, b, CIPHERTEXT_BYTES)) return EXIT_FAILURE;
+	if (ct_nonzero(acc) != (memcmp(a, b, CIPHERTEXT_BYTES) != 0)) return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
+
+// TEST 3 : ct_cmov copies everything when b is 1, nothing when b is 0, and never writes past len
+
+int test_cmov() {
+	uint8_t r[CT_BLOCK_BYTES * 4 + 16], x[sizeof(r)], expected[sizeof(r)];
+	const size_t len = (size_t)rand() % (sizeof(r) - 8);
+	const uint8_t b = (uint8_t)(rand() % 2);
+
+	random_bytes(r, sizeof(r));
+	random_bytes(x, sizeof(x));
+	memcpy(expected, r, sizeof(r));
+	if (b) memcpy(expected, x, len);
+
+	ct_cmov(r, x, len, b);
+	if (memcmp(r, expected, sizeof(r)) != 0) return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
+
+// TEST 4 : ct_zero clears exactly len bytes
+
+int test_zero() {
+	uint8_t r[CT_BLOCK_BYTES * 4], expected[sizeof(r)];
+	const size_t offset = (size_t)rand() % 16, len = (size_t)rand() % (sizeof(r) - 16);
+
+	random_bytes(r, sizeof(r));
+	memcpy(expected, r, sizeof(r));
+	memset(expected + offset, 0, len);
+
+	ct_zero(r + offset, len);
+	if (memcmp(r, expected, sizeof(r)) != 0) return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
+
+#ifdef CT_TIMING
+
+/**********/
+/* TIMING */
+/**********/
+
+// TEST 5 : ct_differ on a ciphertext takes the same time whether it is equal or differs on its first byte
+
+int test_differ_timing() {
+	static uint64_t times[CT_MEASUREMENTS];
+	static uint8_t classes[CT_MEASUREMENTS];
+	uint8_t a[CIPHERTEXT_BYTES], b[2][CIPHERTEXT_BYTES];
+	volatile uint8_t sink = 0;
+	uint64_t start;
+	double t_ct, t_memcmp;
+	size_t i;
+
+	random_bytes(a, CIPHERTEXT_BYTES);
+	memcpy(b[0], a, CIPHERTEXT_BYTES);
+	memcpy(b[1], a, CIPHERTEXT_BYTES);
+	b[1][0] ^= 1;
+
+	// The classes are interleaved at random, so that a drift of the clock hits both of them alike
+	for (i = 0; i < CT_MEASUREMENTS; i++) {
+		classes[i] = (uint8_t)(rand() & 1);
+	}
+
+	for (i = 0; i < CT_MEASUREMENTS; i++) {
+		start = cycles();
+		sink ^= ct_differ(a, b[classes[i]], CIPHERTEXT_BYTES);
+		times[i] = cycles() - start;
+	}
+	t_ct = welch_t(times, classes, CT_MEASUREMENTS);
+
+	// memcmp stops at the first difference, its t shows what this test is able to detect
+	for (i = 0; i < CT_MEASUREMENTS; i++) {
+		start = cycles();
+		sink ^= (uint8_t)(memcmp(a, b[classes[i]], CIPHERTEXT_BYTES) != 0);
+		times[i] = cycles() - start;
+	}
+	t_memcmp = welch_t(times, classes, CT_MEASUREMENTS);
+
+	printf("   ct_differ : t = %.2f (memcmp for reference : t = %.2f)\n", t_ct, t_memcmp);
+	(void)sink;
+	return fabs(t_ct) < CT_T_THRESHOLD ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// TEST 6 : ct_cmov of a shared secret takes the same time whether it copies or not
+
+int test_cmov_timing() {
+	static uint64_t times[CT_MEASUREMENTS];
+	static uint8_t classes[CT_MEASUREMENTS];
+	uint8_t r[32], x[32];
+	uint64_t start;
+	double t;
+	size_t i;
+
+	random_bytes(r, sizeof(r));
+	random_bytes(x, sizeof(x));
+
+	for (i = 0; i < CT_MEASUREMENTS; i++) {
+		classes[i] = (uint8_t)(rand() & 1);
+	}
+
+	for (i = 0; i < CT_MEASUREMENTS; i++) {
+		start = cycles();
+		ct_cmov(r, x, sizeof(r), classes[i]);
+		times[i] = cycles() - start;
+	}
+	t = welch_t(times, classes, CT_MEASUREMENTS);
+
+	printf("   ct_cmov : t = %.2f\n", t);
+	return fabs(t) < CT_T_THRESHOLD ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#endif
+
+/**********************/
+/* RESULTS PROCESSING */
+/**********************/
+
+void display_results(int num, int success, int* test_success) {
+	if (success == EXIT_SUCCESS) {
+		(*test_success)++;
+		printf("✅ TEST %i : Successful\n", num);
+	}
+	else {
+		printf("❌ TEST %i : Failure\n", num);
+	}
+}
+
+void run_test(int num, int (*test)(void), int trials, int* test_success, int* test_total) {
+	int i;
+	int success = EXIT_SUCCESS;
+
+	for (i = 0; i < trials; i++) {
+		if (test() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(num, success, test_success);
+	(*test_total)++;
+}
+
+/********************/
+/* TESTS EXECUTIONS */
+/********************/
+
+int main() {
+
+	int test_success = 0;
+	int test_total = 0;
+
+	srand((unsigned)time(NULL));
+
+	printf("╔════════════════════════════════════════╗\n");
+	printf("║ RUNNING KYBER-mini CONSTANT-TIME TESTS ║\n");
+	printf("╚════════════════════════════════════════╝\n");
+
+	run_test(1, test_differ, NUM_TRIALS, &test_success, &test_total);
+	run_test(2, test_diff_pieces, NUM_TRIALS, &test_success, &test_total);
+	run_test(3, test_cmov, NUM_TRIALS, &test_success, &test_total);
+	run_test(4, test_zero, NUM_TRIALS, &test_success, &test_total);
+#ifdef CT_TIMING
+	run_test(5, test_differ_timing, 1, &test_success, &test_total);
+	run_test(6, test_cmov_timing, 1, &test_success, &test_total);
+#endif
+
+	/*****************/
+	/* FINAL SUMMARY */
+	/*****************/
+
+	printf("╔════════════════════════════════════════╗\n");
+	printf("║              FINAL SUMMARY             ║\n");
+	printf("╚════════════════════════════════════════╝\n");
+	printf("Successful tests : %i/%i\n", test_success, test_total);
+
+	if (test_success == test_total) {
+		printf("🎉 ALL TESTS WERE SUCCESSFUL 🎉\n");
+		return EXIT_SUCCESS;
+	}
+	else {
+		printf("⚠️  %i TEST(S) FAILED.\n", test_total - test_success);
+		return EXIT_FAILURE;
+	}
+
+}
@@ -0,0 +1,286 @@
+/**
+ * @file test_decaps.c
+ * @details Test the batch decapsulation against ciphertexts of the encapsulation context, valid or not
+ * @author Gabriel Abauzit
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "consts.h"
+#include "reduce.h"
+#include "poly.h"
+#include "polyvec.h"
+#include "serialize.h"
+#include "keycache.h"
+#include "encaps.h"
+#include "decaps.h"
+
+#ifndef NUM_TRIALS
+	#define NUM_TRIALS 100
+#endif
+
+#define MAX_CIPHERTEXTS (4 * DECAPS_BATCH + 3)
+
+// The library has no hash function, the tests derive everything from a splitmix64 stream seeded by the input bytes.
+// It is neither a hash nor constant time, it only has to be deterministic.
+
+typedef struct {
+	uint64_t state;
+} stream_t;
+
+void stream_init(stream_t* s, const uint8_t* a, const size_t a_len, const uint8_t* b, const size_t b_len) {
+	size_t i;
+
+	s->state = 0xcbf29ce484222325ULL;
+	for (i = 0; i < a_len; i++) s->state = (s->state ^ a[i]) * 0x100000001b3ULL;
+	for (i = 0; i < b_len; i++) s->state = (s->state ^ b[i]) * 0x100000001b3ULL;
+}
+
+uint64_t stream_next(stream_t* s) {
+	uint64_t z = (s->state += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+void stream_small_poly(stream_t* s, poly_t* f, int eta) {
+	int i;
+
+	for (i = 0; i < KYBER_N; i++) {
+		f->coeffs[i] = (int16_t)((int)(stream_next(s) % (uint64_t)(2 * eta + 1)) - eta);
+	}
+}
+
+void test_derive(uint8_t K[DECAPS_KEY_BYTES], polyvec_t* r, polyvec_t* e1, poly_t* e2, const uint8_t m[KYBER_N / 8], const uint8_t ek_hash[KEYCACHE_FINGERPRINT_BYTES], void* arg) {
+	stream_t s;
+	int i;
+
+	(void)arg;
+	stream_init(&s, m, KYBER_N / 8, ek_hash, KEYCACHE_FINGERPRINT_BYTES);
+	for (i = 0; i < DECAPS_KEY_BYTES; i++) K[i] = (uint8_t)stream_next(&s);
+	for (i = 0; i < KYBER_K; i++) stream_small_poly(&s, &r->vec[i], KYBER_ETA1);
+	for (i = 0; i < KYBER_K; i++) stream_small_poly(&s, &e1->vec[i], KYBER_ETA2);
+	stream_small_poly(&s, e2, KYBER_ETA2);
+}
+
+void test_reject(uint8_t K_bar[DECAPS_KEY_BYTES], const uint8_t ct[CIPHERTEXT_BYTES], void* arg) {
+	stream_t s;
+	int i;
+
+	stream_init(&s, (const uint8_t*)arg, 32, ct, CIPHERTEXT_BYTES);
+	for (i = 0; i < DECAPS_KEY_BYTES; i++) K_bar[i] = (uint8_t)stream_next(&s);
+}
+
+uint8_t z[32];
+decaps_primitives_t prim = {test_derive, test_reject, z};
+prepared_key_t dk;
+encaps_ctx_t* ek;
+
+poly_t random_poly() {
+	int i;
+	poly_t f;
+
+	for (i = 0; i < KYBER_N; i++) {
+		f.coeffs[i] = barrett_reduce((int16_t)(rand() % KYBER_Q));
+	}
+
+	return f;
+}
+
+poly_t random_small_poly(int eta) {
+	int i;
+	poly_t f;
+
+	for (i = 0; i < KYBER_N; i++) {
+		f.coeffs[i] = (int16_t)(rand() % (2 * eta + 1) - eta);
+	}
+
+	return f;
+}
+
+// K-PKE.KeyGen with a random matrix, prepared for decapsulation and for encapsulation
+int keygen() {
+	polymat_t* A = polymat_new();
+	polyvec_t s_hat, e, t_hat;
+	polyvec_packed_t packed;
+	uint8_t s_bytes[KEYCACHE_VECTOR_BYTES], t_bytes[KEYCACHE_VECTOR_BYTES];
+	uint8_t ek_hash[KEYCACHE_FINGERPRINT_BYTES];
+	int i, j;
+
+	if (A == NULL) return EXIT_FAILURE;
+
+	for (i = 0; i < KYBER_K; i++) {
+		for (j = 0; j < KYBER_K; j++) {
+			A->row[i].vec[j] = random_poly();
+		}
+		s_hat.vec[i] = random_small_poly(KYBER_ETA1);
+		e.vec[i] = random_small_poly(KYBER_ETA1);
+	}
+	for (i = 0; i < KEYCACHE_FINGERPRINT_BYTES; i++) ek_hash[i] = (uint8_t)rand();
+	for (i = 0; i < 32; i++) z[i] = (uint8_t)rand();
+
+	polyvec_ntt(&s_hat);
+	polyvec_ntt(&e);
+	polymat_ntt_product(&t_hat, A, &s_hat, 0);
+	for (i = 0; i < KYBER_K; i++) {
+		poly_to_montgomery(&t_hat.vec[i]);
+	}
+	polyvec_add(&t_hat, &t_hat, &e);
+	polyvec_pack(&packed, &s_hat);
+	memcpy(s_bytes, packed.vec, KEYCACHE_VECTOR_BYTES);
+	polyvec_pack(&packed, &t_hat);
+	memcpy(t_bytes, packed.vec, KEYCACHE_VECTOR_BYTES);
+
+	if (prepared_key_init(&dk, ek_hash, s_bytes, t_bytes, A) == EXIT_FAILURE) return EXIT_FAILURE;
+	ek = encaps_ctx_new(t_bytes, A, ek_hash);
+
+	polymat_secure_free(&A);
+	return ek == NULL ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// ML-KEM.Encaps with the test primitives
+void encaps(uint8_t ct[CIPHERTEXT_BYTES], uint8_t K[DECAPS_KEY_BYTES]) {
+	uint8_t m[KYBER_N / 8];
+	polyvec_t r, e1;
+	poly_t e2;
+	int i;
+
+	for (i = 0; i < KYBER_N / 8; i++) m[i] = (uint8_t)rand();
+	test_derive(K, &r, &e1, &e2, m, ek->ek_hash, NULL);
+	encaps_ctx_encrypt(ct, ek, m, &r, &e1, &e2);
+}
+
+uint8_t cts[MAX_CIPHERTEXTS][CIPHERTEXT_BYTES];
+uint8_t expected[MAX_CIPHERTEXTS][DECAPS_KEY_BYTES];
+uint8_t keys[MAX_CIPHERTEXTS][DECAPS_KEY_BYTES];
+
+// Fills cts with n ciphertexts, each one tampered with probability 1/2 if tamper is set, and expected with their keys
+void make_ciphertexts(size_t n, int tamper) {
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		encaps(cts[i], expected[i]);
+		if (tamper && rand() % 2) {
+			cts[i][rand() % CIPHERTEXT_BYTES] ^= (uint8_t)(1 + rand() % 255);
+			test_reject(expected[i], cts[i], z);
+		}
+	}
+}
+
+/*****************/
+/* DECAPSULATION */
+/*****************/
+
+// TEST 1 : valid ciphertexts give back their key, for any number of ciphertexts
+
+int test_valid() {
+	size_t n = (size_t)(rand() % (MAX_CIPHERTEXTS + 1));
+
+	make_ciphertexts(n, 0);
+	kem_dec_many(&dk, &prim, n, (const uint8_t (*)[CIPHERTEXT_BYTES])cts, keys);
+
+	return memcmp(keys, expected, n * DECAPS_KEY_BYTES) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// TEST 2 : tampered ciphertexts are implicitly rejected, without affecting the other ones of their batch
+
+int test_implicit_rejection() {
+	size_t n = (size_t)(1 + rand() % MAX_CIPHERTEXTS);
+
+	make_ciphertexts(n, 1);
+	kem_dec_many(&dk, &prim, n, (const uint8_t (*)[CIPHERTEXT_BYTES])cts, keys);
+
+	return memcmp(keys, expected, n * DECAPS_KEY_BYTES) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// TEST 3 : kem_dec_many gives the same keys as kem_dec on each ciphertext
+
+int test_single() {
+	size_t n = MAX_CIPHERTEXTS, i;
+	uint8_t key[DECAPS_KEY_BYTES];
+
+	make_ciphertexts(n, 1);
+	kem_dec_many(&dk, &prim, n, (const uint8_t (*)[CIPHERTEXT_BYTES])cts, keys);
+
+	for (i = 0; i < n; i++) {
+		kem_dec(&dk, &prim, cts[i], key);
+		if (memcmp(key, keys[i], DECAPS_KEY_BYTES) != 0) return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/**********************/
+/* DISPLAYING RESULTS */
+/**********************/
+
+void display_results(int num, int success, int* test_success) {
+	if (success == EXIT_SUCCESS) {
+		(*test_success)++;
+		printf("✅ TEST %i : Successful\n", num);
+	}
+	else {
+		printf("❌ TEST %i : Failure\n", num);
+	}
+}
+
+void run_test(int num, int (*test)(void), int trials, int* test_success, int* test_total) {
+	int i;
+	int success = EXIT_SUCCESS;
+
+	for (i = 0; i < trials; i++) {
+		if (test() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(num, success, test_success);
+	(*test_total)++;
+}
+
+/********************/
+/* TESTS EXECUTIONS */
+/********************/
+
+int main() {
+
+	int test_success = 0;
+	int test_total = 0;
+
+	printf("╔══════════════════════════════════════╗\n");
+	printf("║    RUNNING KYBER-mini DECAPS TESTS   ║\n");
+	printf("╚══════════════════════════════════════╝\n");
+
+	if (keygen() == EXIT_FAILURE) {
+		printf("⚠️  Key generation failure\n");
+		return EXIT_FAILURE;
+	}
+
+	run_test(1, test_valid, NUM_TRIALS, &test_success, &test_total);
+	run_test(2, test_implicit_rejection, NUM_TRIALS, &test_success, &test_total);
+	run_test(3, test_single, NUM_TRIALS, &test_success, &test_total);
+
+	encaps_ctx_secure_free(&ek);
+
+	/*****************/
+	/* FINAL SUMMARY */
+	/*****************/
+
+	printf("╔════════════════════════════════════════╗\n");
+	printf("║              FINAL SUMMARY             ║\n");
+	printf("╚════════════════════════════════════════╝\n");
+	printf("Successful tests : %i/%i\n", test_success, test_total);
+
+	if (test_success == test_total) {
+		printf("🎉 ALL TESTS WERE SUCCESSFUL 🎉\n");
+		return EXIT_SUCCESS;
+	}
+	else {
+		printf("⚠️  %i TEST(S) FAILED.\n", test_total - test_success);
+		return EXIT_FAILURE;
+	}
+
+}
@@ -0,0 +1,403 @@
+/**
+ * @file test_dispatch.c
+ * @details Test every variant of the dispatch table against the reference, the check that keeps wrong variants out of
+ *          the autotuning, and the autotuner with its cache file, also written by several processes at once
+ * @author Gabriel Abauzit
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "consts.h"
+#include "reduce.h"
+#include "poly.h"
+#include "ntt.h"
+#include "encode.h"
+#include "dispatch.h"
+
+#ifndef NUM_TRIALS
+	#define NUM_TRIALS 100
+#endif
+
+#define CACHE_PATH "test_dispatch.cache"
+
+// Processes saving the cache file at the same time
+#define CONCURRENT_SAVES 4
+
+poly_t random_poly() {
+	int i;
+	poly_t f;
+
+	for (i = 0; i < KYBER_N; i++) {
+		f.coeffs[i] = barrett_reduce((int16_t)(rand() % KYBER_Q));
+	}
+
+	return f;
+}
+
+// Runs every kernel through the public functions and checks them against the reference functions
+int kernels_match_ref() {
+	static const unsigned ds[] = {1, KYBER_DV, KYBER_DU, 12};
+	poly_t a = random_poly(), b = random_poly(), f, g;
+	uint8_t bytes[KYBER_N * 12 / 8], bytes_ref[KYBER_N * 12 / 8];
+	size_t i;
+	int j;
+
+	f = a; g = a;
+	NTT(f.coeffs);
+	NTT_ref(g.coeffs);
+	if (poly_equal(&f, &g) != 0) return EXIT_FAILURE;
+
+	f = a; g = a;
+	NTT_inv_scaled(f.coeffs, NTT_INV_FACTOR_R1);
+	NTT_inv_scaled_ref(g.coeffs, NTT_INV_FACTOR_R1);
+	if (poly_equal(&f, &g) != 0) return EXIT_FAILURE;
+
+	NTT_multiply(f.coeffs, a.coeffs, b.coeffs);
+	NTT_multiply_ref(g.coeffs, a.coeffs, b.coeffs);
+	if (poly_equal(&f, &g) != 0) return EXIT_FAILURE;
+
+	for (i = 0; i < sizeof(ds) / sizeof(ds[0]); i++) {
+		for (j = 0; j < KYBER_N; j++) {
+			f.coeffs[j] = (int16_t)(rand() & ((1 << ds[i]) - 1));
+		}
+		byte_encode(bytes, f.coeffs, ds[i]);
+		byte_encode_ref(bytes_ref, f.coeffs, ds[i]);
+		if (memcmp(bytes, bytes_ref, 32 * ds[i]) != 0) return EXIT_FAILURE;
+
+		byte_decode(g.coeffs, bytes, ds[i]);
+		byte_decode_ref(f.coeffs, bytes, ds[i]);
+		if (poly_equal(&f, &g) != 0) return EXIT_FAILURE;
+	}
+
+	f = a; g = a;
+	poly_compress(&f, KYBER_DU);
+	poly_compress_ref(&g, KYBER_DU);
+	if (poly_equal(&f, &g) != 0) return EXIT_FAILURE;
+
+	return EXIT_SUCCESS;
+}
+
+/************/
+/* VARIANTS */
+/************/
+
+// TEST 1 : every combination of variants gives the output of the reference functions
+
+int test_variants() {
+	const char* names[8];
+	size_t n, v;
+	int k, status = EXIT_SUCCESS;
+
+	for (k = 0; k < DISPATCH_KERNELS; k++) {
+		n = dispatch_variants((dispatch_kernel_t)k, names, 8);
+		if (n == 0 || n > 8) return EXIT_FAILURE;
+		for (v = 0; v < n; v++) {
+			if (dispatch_select((dispatch_kernel_t)k, names[v]) == EXIT_FAILURE) status = EXIT_FAILURE;
+			if (strcmp(dispatch_selected((dispatch_kernel_t)k), names[v]) != 0) status = EXIT_FAILURE;
+			if (kernels_match_ref() == EXIT_FAILURE) status = EXIT_FAILURE;
+		}
+	}
+
+	dispatch_reset();
+	return status;
+}
+
+// TEST 2 : an unknown variant is rejected and leaves the table unchanged
+
+int test_unknown_variant() {
+	const char* before = dispatch_selected(DISPATCH_NTT);
+
+	if (dispatch_select(DISPATCH_NTT, "unknown") == EXIT_SUCCESS) return EXIT_FAILURE;
+	if (dispatch_select(DISPATCH_KERNELS, "ref") == EXIT_SUCCESS) return EXIT_FAILURE;
+	if (strcmp(dispatch_selected(DISPATCH_NTT), before) != 0) return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
+
+// Entry of kernel in dispatch_table
+void (*installed(const dispatch_kernel_t kernel))(void) {
+	switch (kernel) {
+		case DISPATCH_NTT: return (void (*)(void))dispatch_table.ntt;
+		case DISPATCH_NTT_INV: return (void (*)(void))dispatch_table.ntt_inv_scaled;
+		case DISPATCH_NTT_MULTIPLY: return (void (*)(void))dispatch_table.ntt_multiply;
+		case DISPATCH_BYTE_ENCODE: return (void (*)(void))dispatch_table.byte_encode;
+		case DISPATCH_BYTE_DECODE: return (void (*)(void))dispatch_table.byte_decode;
+		case DISPATCH_COMPRESS: return (void (*)(void))dispatch_table.poly_compress;
+		default: return NULL;
+	}
+}
+
+// Wrong variants, only for one of the parameters d that are checked before the last one
+
+void broken_byte_encode(uint8_t* bytes, const int16_t* F, const unsigned d) {
+	byte_encode_ref(bytes, F, d);
+	if (d == 1) bytes[0] ^= 1;
+}
+
+void broken_byte_decode(int16_t* F, const uint8_t* bytes, const unsigned d) {
+	byte_decode_ref(F, bytes, d);
+	if (d == 1) F[0] ^= 1;
+}
+
+void broken_compress(poly_t* f, const unsigned d) {
+	poly_compress_ref(f, d);
+	if (d == KYBER_DU) f->coeffs[0] ^= 1;
+}
+
+// TEST 3 : dispatch_check accepts the variants of the table and rejects a variant wrong for any parameter d
+
+int test_check() {
+	const char* names[8];
+	size_t n, v;
+	int k, status = EXIT_SUCCESS;
+
+	for (k = 0; k < DISPATCH_KERNELS; k++) {
+		if (dispatch_check((dispatch_kernel_t)k, NULL) == EXIT_SUCCESS) status = EXIT_FAILURE;
+		n = dispatch_variants((dispatch_kernel_t)k, names, 8);
+		for (v = 0; v < n && v < 8; v++) {
+			dispatch_select((dispatch_kernel_t)k, names[v]);
+			if (dispatch_check((dispatch_kernel_t)k, installed((dispatch_kernel_t)k)) == EXIT_FAILURE) status = EXIT_FAILURE;
+		}
+	}
+	dispatch_reset();
+	if (status == EXIT_FAILURE) return EXIT_FAILURE;
+
+	if (dispatch_check(DISPATCH_BYTE_ENCODE, (void (*)(void))broken_byte_encode) == EXIT_SUCCESS) return EXIT_FAILURE;
+	if (dispatch_check(DISPATCH_BYTE_DECODE, (void (*)(void))broken_byte_decode) == EXIT_SUCCESS) return EXIT_FAILURE;
+	if (dispatch_check(DISPATCH_COMPRESS, (void (*)(void))broken_compress) == EXIT_SUCCESS) return EXIT_FAILURE;
+	// The right function for another kernel
+	if (dispatch_check(DISPATCH_NTT, (void (*)(void))NTT_inv_scaled_ref) == EXIT_SUCCESS) return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
+
+/**************/
+/* AUTOTUNING */
+/**************/
+
+// TEST 4 : the tuned table gives the output of the reference functions, and the cache file holds its choice
+
+int test_autotune() {
+	char line[128], kernel[32], variant[32];
+	FILE* f;
+	int k = 0, status = EXIT_SUCCESS;
+
+	remove(CACHE_PATH);
+	if (dispatch_autotune(CACHE_PATH) == EXIT_FAILURE) return EXIT_FAILURE;
+	if (kernels_match_ref() == EXIT_FAILURE) status = EXIT_FAILURE;
+
+	f = fopen(CACHE_PATH, "r");
+	if (f == NULL) return EXIT_FAILURE;
+	if (fgets(line, sizeof(line), f) == NULL || strncmp(line, "kyber-dispatch ", 15) != 0) status = EXIT_FAILURE;
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (sscanf(line, "%31s %31s", kernel, variant) != 2 || k >= DISPATCH_KERNELS) {
+			status = EXIT_FAILURE;
+			break;
+		}
+		if (strcmp(kernel, dispatch_kernel_name((dispatch_kernel_t)k)) != 0) status = EXIT_FAILURE;
+		if (strcmp(variant, dispatch_selected((dispatch_kernel_t)k)) != 0) status = EXIT_FAILURE;
+		k++;
+	}
+	fclose(f);
+
+	dispatch_reset();
+	return k == DISPATCH_KERNELS ? status : EXIT_FAILURE;
+}
+
+// TEST 5 : a cache file written on this host is installed as is, the reference variants being forced in it
+
+int test_cache_load() {
+	char header[128];
+	FILE* f;
+	int k;
+
+	remove(CACHE_PATH);
+	if (dispatch_autotune(CACHE_PATH) == EXIT_FAILURE) return EXIT_FAILURE;
+
+	f = fopen(CACHE_PATH, "r");
+	if (f == NULL || fgets(header, sizeof(header), f) == NULL) {
+		if (f != NULL) fclose(f);
+		return EXIT_FAILURE;
+	}
+	fclose(f);
+
+	f = fopen(CACHE_PATH, "w");
+	if (f == NULL) return EXIT_FAILURE;
+	fputs(header, f);
+	for (k = 0; k < DISPATCH_KERNELS; k++) {
+		fprintf(f, "%s ref\n", dispatch_kernel_name((dispatch_kernel_t)k));
+	}
+	fclose(f);
+
+	dispatch_reset();
+	if (dispatch_autotune(CACHE_PATH) == EXIT_FAILURE) return EXIT_FAILURE;
+	for (k = 0; k < DISPATCH_KERNELS; k++) {
+		if (strcmp(dispatch_selected((dispatch_kernel_t)k), "ref") != 0) return EXIT_FAILURE;
+	}
+
+	dispatch_reset();
+	return kernels_match_ref();
+}
+
+// TEST 6 : a cache file from another host or with an unknown variant is ignored and written again
+
+int test_cache_invalid() {
+	static const char* contents[] = {
+		"kyber-dispatch 0 another-host\nntt ref\n",
+		"garbage",
+		"",
+	};
+	char header[128], line[128];
+	FILE* f;
+	size_t i;
+	int k, status = EXIT_SUCCESS;
+
+	remove(CACHE_PATH);
+	if (dispatch_autotune(CACHE_PATH) == EXIT_FAILURE) return EXIT_FAILURE;
+	f = fopen(CACHE_PATH, "r");
+	if (f == NULL || fgets(header, sizeof(header), f) == NULL) {
+		if (f != NULL) fclose(f);
+		return EXIT_FAILURE;
+	}
+	fclose(f);
+
+	for (i = 0; i < sizeof(contents) / sizeof(contents[0]) + 1; i++) {
+		f = fopen(CACHE_PATH, "w");
+		if (f == NULL) return EXIT_FAILURE;
+		if (i < sizeof(contents) / sizeof(contents[0])) {
+			fputs(contents[i], f);
+		}
+		else {
+			// Right host, but a variant that does not exist
+			fputs(header, f);
+			for (k = 0; k < DISPATCH_KERNELS; k++) {
+				fprintf(f, "%s %s\n", dispatch_kernel_name((dispatch_kernel_t)k), k == 0 ? "unknown" : "ref");
+			}
+		}
+		fclose(f);
+
+		dispatch_reset();
+		if (dispatch_autotune(CACHE_PATH) == EXIT_FAILURE) status = EXIT_FAILURE;
+		if (kernels_match_ref() == EXIT_FAILURE) status = EXIT_FAILURE;
+
+		// The retuned choice replaced the invalid file
+		f = fopen(CACHE_PATH, "r");
+		if (f == NULL) return EXIT_FAILURE;
+		if (fgets(line, sizeof(line), f) == NULL || strcmp(line, header) != 0) status = EXIT_FAILURE;
+		fclose(f);
+	}
+
+	dispatch_reset();
+	remove(CACHE_PATH);
+	return status;
+}
+
+// TEST 7 : processes tuning at the same time all succeed, and leave one complete cache file and no temporary one
+
+int test_cache_concurrent() {
+	char line[128];
+	struct dirent* entry;
+	DIR* dir;
+	FILE* f;
+	pid_t pids[CONCURRENT_SAVES];
+	int i, wstatus, lines = 0, status = EXIT_SUCCESS;
+
+	remove(CACHE_PATH);
+	for (i = 0; i < CONCURRENT_SAVES; i++) {
+		pids[i] = fork();
+		if (pids[i] < 0) return EXIT_FAILURE;
+		if (pids[i] == 0) _exit(dispatch_autotune(CACHE_PATH) == EXIT_SUCCESS ? 0 : 1);
+	}
+	for (i = 0; i < CONCURRENT_SAVES; i++) {
+		if (waitpid(pids[i], &wstatus, 0) != pids[i] || !WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0) status = EXIT_FAILURE;
+	}
+
+	f = fopen(CACHE_PATH, "r");
+	if (f == NULL) return EXIT_FAILURE;
+	while (fgets(line, sizeof(line), f) != NULL) lines++;
+	fclose(f);
+	if (lines != 1 + DISPATCH_KERNELS) status = EXIT_FAILURE;
+
+	dir = opendir(".");
+	if (dir == NULL) return EXIT_FAILURE;
+	while ((entry = readdir(dir)) != NULL) {
+		if (strncmp(entry->d_name, CACHE_PATH ".", sizeof(CACHE_PATH)) == 0) status = EXIT_FAILURE;
+	}
+	closedir(dir);
+
+	remove(CACHE_PATH);
+	return status;
+}
+
+/**********************/
+/* DISPLAYING RESULTS */
+/**********************/
+
+void display_results(int num, int success, int* test_success) {
+	if (success == EXIT_SUCCESS) {
+		(*test_success)++;
+		printf("✅ TEST %i : Successful\n", num);
+	}
+	else {
+		printf("❌ TEST %i : Failure\n", num);
+	}
+}
+
+void run_test(int num, int (*test)(void), int trials, int* test_success, int* test_total) {
+	int i;
+	int success = EXIT_SUCCESS;
+
+	for (i = 0; i < trials; i++) {
+		if (test() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(num, success, test_success);
+	(*test_total)++;
+}
+
+/********************/
+/* TESTS EXECUTIONS */
+/********************/
+
+int main() {
+
+	int test_success = 0;
+	int test_total = 0;
+
+	printf("╔══════════════════════════════════════╗\n");
+	printf("║   RUNNING KYBER-mini DISPATCH TESTS  ║\n");
+	printf("╚══════════════════════════════════════╝\n");
+
+	run_test(1, test_variants, NUM_TRIALS, &test_success, &test_total);
+	run_test(2, test_unknown_variant, NUM_TRIALS, &test_success, &test_total);
+	run_test(3, test_check, 1, &test_success, &test_total);
+	// Each autotuning takes about DISPATCH_KERNELS * DISPATCH_TUNE_NS
+	run_test(4, test_autotune, 2, &test_success, &test_total);
+	run_test(5, test_cache_load, 2, &test_success, &test_total);
+	run_test(6, test_cache_invalid, 1, &test_success, &test_total);
+	run_test(7, test_cache_concurrent, 5, &test_success, &test_total);
+
+	/*****************/
+	/* FINAL SUMMARY */
+	/*****************/
+
+	printf("╔════════════════════════════════════════╗\n");
+	printf("║              FINAL SUMMARY             ║\n");
+	printf("╚════════════════════════════════════════╝\n");
+	printf("Successful tests : %i/%i\n", test_success, test_total);
+
+	if (test_success == test_total) {
+		printf("🎉 ALL TESTS WERE SUCCESSFUL 🎉\n");
+		return EXIT_SUCCESS;
+	}
+	else {
+		printf("⚠️  %i TEST(S) FAILED.\n", test_total - test_success);
+		return EXIT_FAILURE;
+	}
+
+}
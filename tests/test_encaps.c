@@ -0,0 +1,273 @@
+/**
+ * @file test_encaps.c
+ * @details Test the encapsulation context against the unfused K-PKE.Encrypt, and decryption of its ciphertexts
+ * @author Gabriel Abauzit
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "consts.h"
+#include "reduce.h"
+#include "poly.h"
+#include "polyvec.h"
+#include "serialize.h"
+#include "encaps.h"
+
+#ifndef NUM_TRIALS
+	#define NUM_TRIALS 1000
+#endif
+
+// A K-PKE key pair built from its definition, the matrix being random instead of expanded from rho
+typedef struct {
+	polymat_t* A;
+	polyvec_t s_hat;
+	uint8_t t_bytes[ENCAPS_T_BYTES];
+	uint8_t ek_hash[ENCAPS_HASH_BYTES];
+} test_keypair_t;
+
+test_keypair_t kp;
+encaps_ctx_t* ctx;
+
+poly_t random_poly() {
+	int i;
+	poly_t f;
+
+	for (i = 0; i < KYBER_N; i++) {
+		f.coeffs[i] = barrett_reduce((int16_t)(rand() % KYBER_Q));
+	}
+
+	return f;
+}
+
+poly_t random_small_poly(int eta) {
+	int i;
+	poly_t f;
+
+	for (i = 0; i < KYBER_N; i++) {
+		f.coeffs[i] = (int16_t)(rand() % (2 * eta + 1) - eta);
+	}
+
+	return f;
+}
+
+void random_small_polyvec(polyvec_t* f, int eta) {
+	int i;
+
+	for (i = 0; i < KYBER_K; i++) {
+		f->vec[i] = random_small_poly(eta);
+	}
+}
+
+// t = A s + e in the NTT domain, as in K-PKE.KeyGen
+int keygen() {
+	polyvec_t e, t_hat;
+	polyvec_packed_t packed;
+	int i, j;
+
+	kp.A = polymat_new();
+	if (kp.A == NULL) return EXIT_FAILURE;
+
+	for (i = 0; i < KYBER_K; i++) {
+		for (j = 0; j < KYBER_K; j++) {
+			kp.A->row[i].vec[j] = random_poly();
+		}
+	}
+	for (i = 0; i < ENCAPS_HASH_BYTES; i++) {
+		kp.ek_hash[i] = (uint8_t)rand();
+	}
+
+	random_small_polyvec(&kp.s_hat, KYBER_ETA1);
+	random_small_polyvec(&e, KYBER_ETA1);
+	polyvec_ntt(&kp.s_hat);
+	polyvec_ntt(&e);
+
+	polymat_ntt_product(&t_hat, kp.A, &kp.s_hat, 0);
+	for (i = 0; i < KYBER_K; i++) {
+		poly_to_montgomery(&t_hat.vec[i]); // removes the factor R^{-1} of NTT_multiply
+	}
+	polyvec_add(&t_hat, &t_hat, &e);
+	polyvec_pack(&packed, &t_hat);
+	memcpy(kp.t_bytes, packed.vec, ENCAPS_T_BYTES);
+
+	return EXIT_SUCCESS;
+}
+
+/*****************/
+/* K-PKE.ENCRYPT */
+/*****************/
+
+// TEST 1 : encaps_ctx_encrypt = ByteEncode(Compress(NTT_inv(A^T r) + e1)) || ByteEncode(Compress(NTT_inv(t^T r) + e2 + Decompress_1(m)))
+
+int test_encrypt() {
+	uint8_t m[KYBER_N / 8], ct[CIPHERTEXT_BYTES], expected[CIPHERTEXT_BYTES];
+	polyvec_t r, r_hat, e1, u, t_hat, At[KYBER_K];
+	const polyvec_t* rows[KYBER_K];
+	poly_t e2, v, mu;
+	int i, j;
+
+	for (i = 0; i < KYBER_N / 8; i++) {
+		m[i] = (uint8_t)rand();
+	}
+	random_small_polyvec(&r, KYBER_ETA1);
+	random_small_polyvec(&e1, KYBER_ETA2);
+	e2 = random_small_poly(KYBER_ETA2);
+
+	encaps_ctx_encrypt(ct, ctx, m, &r, &e1, &e2);
+
+	polyvec_copy(&r_hat, &r);
+	polyvec_ntt(&r_hat);
+	for (i = 0; i < KYBER_K; i++) {
+		for (j = 0; j < KYBER_K; j++) {
+			At[i].vec[j] = kp.A->row[j].vec[i];
+		}
+		rows[i] = &At[i];
+	}
+	polyvec_ntt_product(&u, rows, &r_hat);
+	for (i = 0; i < KYBER_K; i++) {
+		NTT_inv_scaled(u.vec[i].coeffs, NTT_INV_FACTOR_R1);
+	}
+	polyvec_add(&u, &u, &e1);
+	polyvec_compress(&u, KYBER_DU);
+	polyvec_byte_encode(expected, &u, KYBER_DU);
+
+	polyvec_byte_decode(&t_hat, kp.t_bytes, 12);
+	polyvec_ntt_scalar_product(&v, &t_hat, &r_hat);
+	NTT_inv_scaled(v.coeffs, NTT_INV_FACTOR_R1);
+	poly_add(&v, &v, &e2);
+	poly_frommsg(&mu, m);
+	poly_add(&v, &v, &mu);
+	poly_compress(&v, KYBER_DV);
+	byte_encode(expected + POLYVEC_BYTES(KYBER_DU), v.coeffs, KYBER_DV);
+
+	return memcmp(ct, expected, CIPHERTEXT_BYTES) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// TEST 2 : K-PKE.Decrypt with s gives m back
+
+int test_decrypt() {
+	uint8_t m[KYBER_N / 8], m_dec[KYBER_N / 8], ct[CIPHERTEXT_BYTES];
+	polyvec_t r, e1, u;
+	poly_t e2, v, w;
+	int i;
+
+	for (i = 0; i < KYBER_N / 8; i++) {
+		m[i] = (uint8_t)rand();
+	}
+	random_small_polyvec(&r, KYBER_ETA1);
+	random_small_polyvec(&e1, KYBER_ETA2);
+	e2 = random_small_poly(KYBER_ETA2);
+
+	encaps_ctx_encrypt(ct, ctx, m, &r, &e1, &e2);
+
+	polyvec_byte_decode(&u, ct, KYBER_DU);
+	polyvec_decompress(&u, KYBER_DU);
+	byte_decode(v.coeffs, ct + POLYVEC_BYTES(KYBER_DU), KYBER_DV);
+	poly_decompress(&v, KYBER_DV);
+
+	polyvec_ntt(&u);
+	polyvec_ntt_scalar_product(&w, &kp.s_hat, &u);
+	NTT_inv_scaled(w.coeffs, NTT_INV_FACTOR_R1);
+	poly_sub(&w, &v, &w);
+	poly_tomsg(m_dec, &w);
+
+	return memcmp(m, m_dec, sizeof(m)) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/******************/
+/* PUBLIC KEY USE */
+/******************/
+
+// TEST 3 : a public key with a coefficient of t out of [0, q) is rejected
+
+int test_invalid_key() {
+	uint8_t t_bytes[ENCAPS_T_BYTES];
+	encaps_ctx_t* invalid;
+	int pos = 3 * (rand() % (ENCAPS_T_BYTES / 3));
+
+	memcpy(t_bytes, kp.t_bytes, ENCAPS_T_BYTES);
+	// Second coefficient of the pair at pos set to 0xFFF
+	t_bytes[pos + 1] |= 0xF0;
+	t_bytes[pos + 2] = 0xFF;
+
+	invalid = encaps_ctx_new(t_bytes, kp.A, kp.ek_hash);
+	if (invalid != NULL) {
+		encaps_ctx_secure_free(&invalid);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+/**********************/
+/* DISPLAYING RESULTS */
+/**********************/
+
+void display_results(int num, int success, int* test_success) {
+	if (success == EXIT_SUCCESS) {
+		(*test_success)++;
+		printf("✅ TEST %i : Successful\n", num);
+	}
+	else {
+		printf("❌ TEST %i : Failure\n", num);
+	}
+}
+
+void run_test(int num, int (*test)(void), int trials, int* test_success, int* test_total) {
+	int i;
+	int success = EXIT_SUCCESS;
+
+	for (i = 0; i < trials; i++) {
+		if (test() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(num, success, test_success);
+	(*test_total)++;
+}
+
+/********************/
+/* TESTS EXECUTIONS */
+/********************/
+
+int main() {
+
+	int test_success = 0;
+	int test_total = 0;
+
+	printf("╔══════════════════════════════════════╗\n");
+	printf("║    RUNNING KYBER-mini ENCAPS TESTS   ║\n");
+	printf("╚══════════════════════════════════════╝\n");
+
+	if (keygen() == EXIT_FAILURE || (ctx = encaps_ctx_new(kp.t_bytes, kp.A, kp.ek_hash)) == NULL) {
+		printf("⚠️  Key generation failure\n");
+		return EXIT_FAILURE;
+	}
+
+	run_test(1, test_encrypt, NUM_TRIALS, &test_success, &test_total);
+	run_test(2, test_decrypt, NUM_TRIALS, &test_success, &test_total);
+	run_test(3, test_invalid_key, NUM_TRIALS, &test_success, &test_total);
+
+	encaps_ctx_secure_free(&ctx);
+	polymat_secure_free(&kp.A);
+
+	/*****************/
+	/* FINAL SUMMARY */
+	/*****************/
+
+	printf("╔════════════════════════════════════════╗\n");
+	printf("║              FINAL SUMMARY             ║\n");
+	printf("╚════════════════════════════════════════╝\n");
+	printf("Successful tests : %i/%i\n", test_success, test_total);
+
+	if (test_success == test_total) {
+		printf("🎉 ALL TESTS WERE SUCCESSFUL 🎉\n");
+		return EXIT_SUCCESS;
+	}
+	else {
+		printf("⚠️  %i TEST(S) FAILED.\n", test_total - test_success);
+		return EXIT_FAILURE;
+	}
+
+}
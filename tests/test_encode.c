@@ -9,6 +9,9 @@
 #include <stdint.h>
 #include <string.h>
 #include "encode.h"
+#include "poly.h"
+#include "poly_avx2.h"
+#include "serialize.h"
 
 #ifndef NUM_TRIALS
 	#define NUM_TRIALS 1000
@@ -131,6 +134,434 @@ int test_decompress_compress() {
     return err <= err_max ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
+// TEST 5 : compress(x) = round(x * 2^d / q) mod 2^d for all canonical x and all d < 12
+
+int test_compress_exhaustive() {
+    int32_t x, x_pos, expected;
+    unsigned d;
+
+    for (d = 1; d < 12; d++) {
+        for (x = -(KYBER_Q - 1) / 2; x <= (KYBER_Q - 1) / 2; x++) {
+            x_pos = x < 0 ? x + KYBER_Q : x;
+            expected = (int32_t)(((2 * ((int64_t)x_pos << d) + KYBER_Q) / (2 * KYBER_Q)) & ((1 << d) - 1));
+            if (compress((int16_t)x, d) != expected) return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/************************/
+/* BMI2 PEXT/PDEP PATHS */
+/************************/
+
+#ifdef ENCODE_BMI2_AVAILABLE
+
+// TEST 6 : bits_to_bytes_bmi2 = bits_to_bytes_ref and bytes_to_bits_bmi2 = bytes_to_bits_ref
+
+int test_bits_bytes_bmi2() {
+    unsigned l = (unsigned)(1 + rand() % MAX_L);
+    uint8_t bits[8 * MAX_L], bytes[MAX_L], out_ref[8 * MAX_L], out_bmi2[8 * MAX_L];
+
+    random_bits(bits, 8*l);
+    bits_to_bytes_ref(out_ref, bits, l);
+    bits_to_bytes_bmi2(out_bmi2, bits, l);
+    if (memcmp(out_ref, out_bmi2, l) != 0) return EXIT_FAILURE;
+
+    random_bytes(bytes, l);
+    bytes_to_bits_ref(out_ref, bytes, l);
+    bytes_to_bits_bmi2(out_bmi2, bytes, l);
+    return memcmp(out_ref, out_bmi2, 8*l) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// TEST 7 : byte_encode_bmi2 = byte_encode_ref for all d in [1,12], on any int16 input
+
+int test_byte_encode_bmi2() {
+    unsigned i, d;
+    int16_t F[256];
+    uint8_t out_ref[32 * 12], out_bmi2[32 * 12];
+
+    for (d = 1; d <= 12; d++) {
+        for (i = 0; i < 256; i++) {
+            F[i] = (int16_t)(rand() & 0xFFFF);
+        }
+        byte_encode_ref(out_ref, F, d);
+        byte_encode_bmi2(out_bmi2, F, d);
+        if (memcmp(out_ref, out_bmi2, 32*d) != 0) return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// TEST 8 : byte_decode_bmi2 = byte_decode_ref for all d in [1,12]
+
+int test_byte_decode_bmi2() {
+    unsigned d;
+    uint8_t bytes[32 * 12];
+    int16_t F_ref[256], F_bmi2[256];
+
+    for (d = 1; d <= 12; d++) {
+        random_bytes(bytes, 32*d);
+        byte_decode_ref(F_ref, bytes, d);
+        byte_decode_bmi2(F_bmi2, bytes, d);
+        if (memcmp(F_ref, F_bmi2, sizeof(F_ref)) != 0) return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+#endif
+
+/********************/
+/* MESSAGE ENCODING */
+/********************/
+
+void random_canonical(int16_t* F) {
+    unsigned i;
+
+    for (i = 0; i < KYBER_N; i++) {
+        F[i] = (int16_t)(rand() % KYBER_Q - (KYBER_Q - 1) / 2);
+    }
+}
+
+// TEST 9 : poly_frommsg_bits(m) = ByteDecode_1(m), poly_frommsg(m) = Decompress_1(ByteDecode_1(m)) and
+// poly_tomsg(f) = ByteEncode_1(Compress_1(f))
+
+int test_msg_ref() {
+    uint8_t msg[32], msg_ref[32];
+    poly_t f, g;
+
+    random_bytes(msg, 32);
+    byte_decode_ref(g.coeffs, msg, 1);
+    poly_frommsg_bits(&f, msg);
+    if (memcmp(f.coeffs, g.coeffs, sizeof(f.coeffs)) != 0) return EXIT_FAILURE;
+    poly_decompress(&g, 1);
+    poly_frommsg_ref(&f, msg);
+    if (memcmp(f.coeffs, g.coeffs, sizeof(f.coeffs)) != 0) return EXIT_FAILURE;
+
+    random_canonical(f.coeffs);
+    poly_copy(&g, &f);
+    poly_compress(&g, 1);
+    byte_encode_ref(msg_ref, g.coeffs, 1);
+    poly_tomsg_ref(msg, &f);
+    return memcmp(msg, msg_ref, 32) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// TEST 10 : poly_tomsg_ref = ByteEncode_1(Compress_1(f)) for every canonical coefficient
+
+int test_tomsg_exhaustive() {
+    int32_t x;
+    unsigned i;
+    uint8_t msg[32];
+    poly_t f;
+
+    for (x = -(KYBER_Q - 1) / 2; x <= (KYBER_Q - 1) / 2; x++) {
+        for (i = 0; i < KYBER_N; i++) {
+            f.coeffs[i] = (int16_t)x;
+        }
+        poly_tomsg_ref(msg, &f);
+        if (msg[0] != (compress((int16_t)x, 1) ? 0xFF : 0x00)) return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+#ifdef POLY_AVX2_AVAILABLE
+
+// TEST 11 : poly_frommsg_avx2 = poly_frommsg_ref and poly_tomsg_avx2 = poly_tomsg_ref
+
+int test_msg_avx2() {
+    uint8_t msg[32], msg_avx2[32];
+    poly_t f, g;
+
+    random_bytes(msg, 32);
+    poly_frommsg_ref(&f, msg);
+    poly_frommsg_avx2(&g, msg);
+    if (memcmp(f.coeffs, g.coeffs, sizeof(f.coeffs)) != 0) return EXIT_FAILURE;
+
+    random_canonical(f.coeffs);
+    poly_tomsg_ref(msg, &f);
+    poly_tomsg_avx2(msg_avx2, &f);
+    return memcmp(msg, msg_avx2, 32) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#endif
+
+/********************************/
+/* SCATTER-GATHER SERIALIZATION */
+/********************************/
+
+// TEST 12 : byte_encode_blocks and byte_decode_blocks on the 32 blocks = byte_encode_ref and byte_decode_ref
+
+int test_blocks() {
+    unsigned i, d;
+    int16_t F[256], F_ref[256], F_blocks[256];
+    uint8_t out_ref[32 * 12], out_blocks[32 * 12];
+
+    for (d = 1; d <= 12; d++) {
+        for (i = 0; i < 256; i++) {
+            F[i] = (int16_t)(rand() & 0xFFFF);
+        }
+        byte_encode_ref(out_ref, F, d);
+        byte_encode_blocks_scalar(out_blocks, F, d, 32);
+        if (memcmp(out_ref, out_blocks, 32*d) != 0) return EXIT_FAILURE;
+        byte_encode_blocks(out_blocks, F, d, 32);
+        if (memcmp(out_ref, out_blocks, 32*d) != 0) return EXIT_FAILURE;
+
+        byte_decode_ref(F_ref, out_ref, d);
+        byte_decode_blocks_scalar(F_blocks, out_ref, d, 32);
+        if (memcmp(F_ref, F_blocks, sizeof(F_ref)) != 0) return EXIT_FAILURE;
+        byte_decode_blocks(F_blocks, out_ref, d, 32);
+        if (memcmp(F_ref, F_blocks, sizeof(F_ref)) != 0) return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// Splits a buffer of size len into at most max_segments random segments, some of them empty
+size_t random_segments(struct iovec* iov, size_t max_segments, uint8_t* buf, size_t len) {
+    size_t n = 0, cut;
+
+    while (len > 0 && n < max_segments - 1) {
+        cut = (size_t)rand() % (len < 40 ? len + 1 : 40);
+        iov[n].iov_base = buf;
+        iov[n].iov_len = cut;
+        buf += cut;
+        len -= cut;
+        n++;
+    }
+    iov[n].iov_base = buf;
+    iov[n].iov_len = len;
+
+    return n + 1;
+}
+
+// TEST 13 : the ciphertext written into random segments is ByteEncode_du(u) || ByteEncode_dv(v), and reads back
+
+int test_ciphertext_iov() {
+    unsigned i, j;
+    polyvec_t u, u_dec;
+    poly_t v, v_dec;
+    uint8_t expected[CIPHERTEXT_BYTES], buf[CIPHERTEXT_BYTES];
+    struct iovec iov[CIPHERTEXT_BYTES];
+    iov_cursor_t c;
+    size_t iovcnt;
+
+    for (i = 0; i < KYBER_K; i++) {
+        for (j = 0; j < KYBER_N; j++) {
+            u.vec[i].coeffs[j] = (int16_t)(rand() % (1 << KYBER_DU));
+        }
+    }
+    for (j = 0; j < KYBER_N; j++) {
+        v.coeffs[j] = (int16_t)(rand() % (1 << KYBER_DV));
+    }
+
+    polyvec_byte_encode(expected, &u, KYBER_DU);
+    byte_encode(expected + POLYVEC_BYTES(KYBER_DU), v.coeffs, KYBER_DV);
+
+    iovcnt = random_segments(iov, 1 + rand() % 64, buf, CIPHERTEXT_BYTES);
+    iov_cursor_init(&c, iov, iovcnt);
+    if (ciphertext_encode_iov(&c, &u, &v) == EXIT_FAILURE) return EXIT_FAILURE;
+    if (memcmp(expected, buf, CIPHERTEXT_BYTES) != 0 || iov_cursor_remaining(&c) != 0) return EXIT_FAILURE;
+
+    // Too short output : nothing is written
+    iov_cursor_init(&c, iov, iovcnt - 1);
+    if (iov[iovcnt - 1].iov_len > 0 && ciphertext_encode_iov(&c, &u, &v) == EXIT_SUCCESS) return EXIT_FAILURE;
+
+    iovcnt = random_segments(iov, 1 + rand() % 64, buf, CIPHERTEXT_BYTES);
+    iov_cursor_init(&c, iov, iovcnt);
+    if (ciphertext_decode_iov(&u_dec, &v_dec, &c) == EXIT_FAILURE) return EXIT_FAILURE;
+    for (i = 0; i < KYBER_K; i++) {
+        if (memcmp(u.vec[i].coeffs, u_dec.vec[i].coeffs, sizeof(v.coeffs)) != 0) return EXIT_FAILURE;
+    }
+    return memcmp(v.coeffs, v_dec.coeffs, sizeof(v.coeffs)) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// TEST 14 : a polynomial written into a ring buffer window wrapping around the end reads back
+
+int test_ring_window() {
+    unsigned j;
+    uint8_t ring[500];
+    struct iovec iov[2];
+    iov_cursor_t c;
+    poly_t f, g;
+    size_t iovcnt, start = (size_t)rand() % sizeof(ring);
+
+    for (j = 0; j < KYBER_N; j++) {
+        f.coeffs[j] = (int16_t)(rand() % KYBER_Q);
+    }
+
+    iovcnt = iov_ring_window(iov, ring, sizeof(ring), start, POLY_BYTES(12));
+    iov_cursor_init(&c, iov, iovcnt);
+    if (poly_byte_encode_iov(&c, &f, 12) == EXIT_FAILURE) return EXIT_FAILURE;
+
+    iov_cursor_init(&c, iov, iovcnt);
+    if (poly_byte_decode_iov(&g, &c, 12) == EXIT_FAILURE) return EXIT_FAILURE;
+
+    return memcmp(f.coeffs, g.coeffs, sizeof(f.coeffs)) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/***************************/
+/* CHECKED 12-BIT DECODING */
+/***************************/
+
+// Random encapsulation key vector, with one coefficient out of range half of the time
+void random_ek_bytes(uint8_t* bytes) {
+    unsigned i, j;
+    polyvec_t f;
+
+    for (i = 0; i < KYBER_K; i++) {
+        for (j = 0; j < KYBER_N; j++) {
+            f.vec[i].coeffs[j] = (int16_t)(rand() % KYBER_Q);
+        }
+    }
+    if (rand() & 1) {
+        f.vec[rand() % KYBER_K].coeffs[rand() % KYBER_N] = (int16_t)(KYBER_Q + rand() % (4096 - KYBER_Q));
+    }
+
+    polyvec_byte_encode(bytes, &f, 12);
+}
+
+// TEST 15 : polyvec_decode12_checked = polyvec_byte_decode, and fails exactly when re-encoding does not give the input back
+
+int test_decode12_checked() {
+    uint8_t bytes[POLYVEC_BYTES(12)], reencoded[POLYVEC_BYTES(12)];
+    polyvec_t f, g;
+    int expected, i, j;
+
+    random_ek_bytes(bytes);
+
+    polyvec_byte_decode(&f, bytes, 12);
+    for (i = 0; i < KYBER_K; i++) {
+        for (j = 0; j < KYBER_N; j++) {
+            f.vec[i].coeffs[j] %= KYBER_Q; // ByteEncode_12(ByteDecode_12(ek)) of FIPS 203
+        }
+    }
+    polyvec_byte_encode(reencoded, &f, 12);
+    expected = memcmp(bytes, reencoded, sizeof(bytes)) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    polyvec_byte_decode(&f, bytes, 12);
+    if (polyvec_decode12_checked(&g, bytes) != expected) return EXIT_FAILURE;
+    for (i = 0; i < KYBER_K; i++) {
+        if (memcmp(f.vec[i].coeffs, g.vec[i].coeffs, sizeof(f.vec[i].coeffs)) != 0) return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+#ifdef POLY_AVX2_AVAILABLE
+
+// TEST 16 : poly_decode12_checked_avx2 = poly_decode12_checked_ref
+
+int test_decode12_checked_avx2() {
+    uint8_t bytes[POLYVEC_BYTES(12)];
+    poly_t f, g;
+    int i;
+
+    random_ek_bytes(bytes);
+
+    for (i = 0; i < KYBER_K; i++) {
+        if (poly_decode12_checked_ref(&f, bytes + POLY_BYTES(12) * i) != poly_decode12_checked_avx2(&g, bytes + POLY_BYTES(12) * i)) return EXIT_FAILURE;
+        if (memcmp(f.coeffs, g.coeffs, sizeof(f.coeffs)) != 0) return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+#endif
+
+/********************************/
+/* AVX2 COEFFICIENT-WISE PASSES */
+/********************************/
+
+#ifdef POLY_AVX2_AVAILABLE
+
+// TEST 17 : poly_compress_avx2 = poly_compress_ref on all of [-q, q) and poly_decompress_avx2 = poly_decompress_ref
+// on all of [0, 2^d), for every d up to 11
+
+int test_compress_avx2_exhaustive() {
+    poly_t f, g;
+    unsigned d;
+    int x, i;
+
+    for (d = 1; d <= 11; d++) {
+        for (x = -KYBER_Q; x < KYBER_Q; x += KYBER_N) {
+            for (i = 0; i < KYBER_N; i++) {
+                f.coeffs[i] = (int16_t)(x + i < KYBER_Q ? x + i : 0);
+            }
+            g = f;
+            poly_compress_ref(&f, d);
+            poly_compress_avx2(&g, d);
+            if (memcmp(f.coeffs, g.coeffs, sizeof(f.coeffs)) != 0) return EXIT_FAILURE;
+        }
+
+        for (x = 0; x < (1 << d); x += KYBER_N) {
+            for (i = 0; i < KYBER_N; i++) {
+                f.coeffs[i] = (int16_t)((x + i) & ((1 << d) - 1));
+            }
+            g = f;
+            poly_decompress_ref(&f, d);
+            poly_decompress_avx2(&g, d);
+            if (memcmp(f.coeffs, g.coeffs, sizeof(f.coeffs)) != 0) return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// TEST 18 : poly_reduce, poly_to_montgomery and poly_from_montgomery on every 16-bit coefficient, poly_add, poly_sub
+// and poly_is_valid on random inputs, AVX2 against the scalar versions
+
+int test_arith_avx2() {
+    poly_t f, g, a, b;
+    int x, i;
+
+    for (x = INT16_MIN; x <= INT16_MAX; x += KYBER_N) {
+        for (i = 0; i < KYBER_N; i++) {
+            f.coeffs[i] = (int16_t)(x + i);
+        }
+        g = f;
+        poly_reduce_ref(&g);
+        a = f;
+        poly_reduce_avx2(&a);
+        if (memcmp(g.coeffs, a.coeffs, sizeof(g.coeffs)) != 0) return EXIT_FAILURE;
+
+        g = f;
+        poly_to_montgomery_ref(&g);
+        a = f;
+        poly_to_montgomery_avx2(&a);
+        if (memcmp(g.coeffs, a.coeffs, sizeof(g.coeffs)) != 0) return EXIT_FAILURE;
+
+        g = f;
+        poly_from_montgomery_ref(&g);
+        a = f;
+        poly_from_montgomery_avx2(&a);
+        if (memcmp(g.coeffs, a.coeffs, sizeof(g.coeffs)) != 0) return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < KYBER_N; i++) {
+        a.coeffs[i] = (int16_t)rand();
+        b.coeffs[i] = (int16_t)rand();
+    }
+    poly_add_ref(&f, &a, &b);
+    poly_add_avx2(&g, &a, &b);
+    if (memcmp(f.coeffs, g.coeffs, sizeof(f.coeffs)) != 0) return EXIT_FAILURE;
+    poly_sub_ref(&f, &a, &b);
+    poly_sub_avx2(&g, &a, &b);
+    if (memcmp(f.coeffs, g.coeffs, sizeof(f.coeffs)) != 0) return EXIT_FAILURE;
+
+    // Canonical, then one coefficient just out of range on either side, then any 16-bit value
+    random_canonical(f.coeffs);
+    if (poly_is_valid_ref(&f) != 0 || poly_is_valid_avx2(&f) != 0) return EXIT_FAILURE;
+    f.coeffs[rand() % KYBER_N] = (int16_t)(rand() % 2 ? (KYBER_Q + 1) / 2 : -(KYBER_Q + 1) / 2);
+    if (poly_is_valid_ref(&f) != 1 || poly_is_valid_avx2(&f) != 1) return EXIT_FAILURE;
+    if (poly_is_valid_ref(&a) != poly_is_valid_avx2(&a)) return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
+
+#endif
+
 /**********************/
 /* DISPLAYING RESULTS */
 /**********************/
@@ -212,6 +643,190 @@ int main() {
 
 	display_results(4, success, &test_success);
 	test_total++;
+
+    // TEST 5
+
+	display_results(5, test_compress_exhaustive(), &test_success);
+	test_total++;
+
+#ifdef ENCODE_BMI2_AVAILABLE
+	if (encode_bmi2_supported()) {
+		// TEST 6
+
+		success = EXIT_SUCCESS;
+
+		for (i = 0; i < NUM_TRIALS; i++) {
+			if (test_bits_bytes_bmi2() == EXIT_FAILURE) {
+				success = EXIT_FAILURE;
+			}
+		}
+
+		display_results(6, success, &test_success);
+		test_total++;
+
+		// TEST 7
+
+		success = EXIT_SUCCESS;
+
+		for (i = 0; i < NUM_TRIALS; i++) {
+			if (test_byte_encode_bmi2() == EXIT_FAILURE) {
+				success = EXIT_FAILURE;
+			}
+		}
+
+		display_results(7, success, &test_success);
+		test_total++;
+
+		// TEST 8
+
+		success = EXIT_SUCCESS;
+
+		for (i = 0; i < NUM_TRIALS; i++) {
+			if (test_byte_decode_bmi2() == EXIT_FAILURE) {
+				success = EXIT_FAILURE;
+			}
+		}
+
+		display_results(8, success, &test_success);
+		test_total++;
+	}
+	else {
+		printf("BMI2 is not supported by this host, TESTS 6 to 8 skipped\n");
+	}
+#endif
+
+	// TEST 9
+
+	success = EXIT_SUCCESS;
+
+	for (i = 0; i < NUM_TRIALS; i++) {
+		if (test_msg_ref() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(9, success, &test_success);
+	test_total++;
+
+	// TEST 10
+
+	display_results(10, test_tomsg_exhaustive(), &test_success);
+	test_total++;
+
+#ifdef POLY_AVX2_AVAILABLE
+	if (poly_avx2_supported()) {
+		// TEST 11
+
+		success = EXIT_SUCCESS;
+
+		for (i = 0; i < NUM_TRIALS; i++) {
+			if (test_msg_avx2() == EXIT_FAILURE) {
+				success = EXIT_FAILURE;
+			}
+		}
+
+		display_results(11, success, &test_success);
+		test_total++;
+	}
+	else {
+		printf("AVX2 is not supported by this host, TEST 11 skipped\n");
+	}
+#endif
+
+	// TEST 12
+
+	success = EXIT_SUCCESS;
+
+	for (i = 0; i < NUM_TRIALS; i++) {
+		if (test_blocks() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(12, success, &test_success);
+	test_total++;
+
+	// TEST 13
+
+	success = EXIT_SUCCESS;
+
+	for (i = 0; i < NUM_TRIALS; i++) {
+		if (test_ciphertext_iov() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(13, success, &test_success);
+	test_total++;
+
+	// TEST 14
+
+	success = EXIT_SUCCESS;
+
+	for (i = 0; i < NUM_TRIALS; i++) {
+		if (test_ring_window() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(14, success, &test_success);
+	test_total++;
+
+	// TEST 15
+
+	success = EXIT_SUCCESS;
+
+	for (i = 0; i < NUM_TRIALS; i++) {
+		if (test_decode12_checked() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(15, success, &test_success);
+	test_total++;
+
+#ifdef POLY_AVX2_AVAILABLE
+	if (poly_avx2_supported()) {
+		// TEST 16
+
+		success = EXIT_SUCCESS;
+
+		for (i = 0; i < NUM_TRIALS; i++) {
+			if (test_decode12_checked_avx2() == EXIT_FAILURE) {
+				success = EXIT_FAILURE;
+			}
+		}
+
+		display_results(16, success, &test_success);
+		test_total++;
+	}
+	else {
+		printf("AVX2 is not supported by this host, TEST 16 skipped\n");
+	}
+
+	if (poly_avx2_supported()) {
+		// TEST 17
+
+		display_results(17, test_compress_avx2_exhaustive(), &test_success);
+		test_total++;
+
+		// TEST 18
+
+		success = EXIT_SUCCESS;
+
+		for (i = 0; i < NUM_TRIALS / 10; i++) {
+			if (test_arith_avx2() == EXIT_FAILURE) {
+				success = EXIT_FAILURE;
+			}
+		}
+
+		display_results(18, success, &test_success);
+		test_total++;
+	}
+	else {
+		printf("AVX2 is not supported by this host, TESTS 17 and 18 skipped\n");
+	}
+#endif
 	
 	/*****************/
 	/* FINAL SUMMARY */
@@ -0,0 +1,359 @@
+/**
+ * @file test_keycache.c
+ * @details Test the prepared decapsulation keys and their LRU cache
+ * @author Gabriel Abauzit
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include "consts.h"
+#include "reduce.h"
+#include "poly.h"
+#include "polyvec.h"
+#include "keycache.h"
+
+#ifndef NUM_TRIALS
+	#define NUM_TRIALS 100
+#endif
+
+// Number of distinct keys used by the tests
+#define NUM_KEYS 8
+
+#define NUM_THREADS 4
+
+typedef struct {
+	uint8_t fingerprint[KEYCACHE_FINGERPRINT_BYTES];
+	uint8_t s_bytes[KEYCACHE_VECTOR_BYTES];
+	uint8_t t_bytes[KEYCACHE_VECTOR_BYTES];
+	polyvec_t s;         // s in the normal domain
+	polymat_t* A;
+} test_key_t;
+
+test_key_t keys[NUM_KEYS];
+
+poly_t random_poly() {
+	int i;
+	poly_t f;
+
+	for (i = 0; i < KYBER_N; i++) {
+		f.coeffs[i] = barrett_reduce((int16_t)(rand() % KYBER_Q));
+	}
+
+	return f;
+}
+
+int generate_keys() {
+	int k, i, j;
+	polyvec_t v;
+	polyvec_packed_t packed;
+
+	for (k = 0; k < NUM_KEYS; k++) {
+		for (i = 0; i < KEYCACHE_FINGERPRINT_BYTES; i++) {
+			keys[k].fingerprint[i] = (uint8_t)rand();
+		}
+
+		for (i = 0; i < KYBER_K; i++) {
+			keys[k].s.vec[i] = random_poly();
+		}
+		polyvec_copy(&v, &keys[k].s);
+		polyvec_ntt(&v);
+		polyvec_pack(&packed, &v);
+		memcpy(keys[k].s_bytes, packed.vec, KEYCACHE_VECTOR_BYTES);
+
+		for (i = 0; i < KYBER_K; i++) {
+			v.vec[i] = random_poly();
+		}
+		polyvec_pack(&packed, &v);
+		memcpy(keys[k].t_bytes, packed.vec, KEYCACHE_VECTOR_BYTES);
+
+		keys[k].A = polymat_new();
+		if (keys[k].A == NULL) return EXIT_FAILURE;
+		for (i = 0; i < KYBER_K; i++) {
+			for (j = 0; j < KYBER_K; j++) {
+				keys[k].A->row[i].vec[j] = random_poly();
+			}
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+const prepared_key_t* acquire(keycache_t* cache, int k) {
+	return keycache_acquire(cache, keys[k].fingerprint, keys[k].s_bytes, keys[k].t_bytes, keys[k].A);
+}
+
+// The prepared key of k holds the right s, t, A and fingerprint
+
+int check_prepared_key(const prepared_key_t* key, int k) {
+	polyvec_t u;
+	polyvec_ntt_cache_t* s_cache;
+	poly_t expected, r;
+	int i;
+
+	if (key == NULL) return EXIT_FAILURE;
+	if (memcmp(key->fingerprint, keys[k].fingerprint, KEYCACHE_FINGERPRINT_BYTES) != 0) return EXIT_FAILURE;
+	if (memcmp(key->t_hat.vec, keys[k].t_bytes, KEYCACHE_VECTOR_BYTES) != 0) return EXIT_FAILURE;
+	for (i = 0; i < KYBER_K; i++) {
+		if (polyvec_equal(&key->A.row[i], &keys[k].A->row[i]) == EXIT_FAILURE) return EXIT_FAILURE;
+	}
+
+	s_cache = polyvec_ntt_cache_new(&keys[k].s);
+	if (s_cache == NULL) return EXIT_FAILURE;
+	for (i = 0; i < KYBER_K; i++) {
+		u.vec[i] = random_poly();
+	}
+	polyvec_scalar_product_cached(&expected, s_cache, &u);
+	prepared_key_secret_product(&r, key, &u);
+	polyvec_ntt_cache_secure_free(&s_cache);
+
+	return poly_equal(&expected, &r);
+}
+
+/*****************/
+/* PREPARED KEYS */
+/*****************/
+
+// TEST 1 : prepared_key_secret_product(prepare(s), u) = polyvec_scalar_product_cached(s, u)
+
+int test_prepared_key() {
+	prepared_key_t* key = (prepared_key_t*)aligned_alloc(POLYMAT_ALIGN, sizeof(prepared_key_t));
+	int k = rand() % NUM_KEYS;
+	int success;
+
+	if (key == NULL) return EXIT_FAILURE;
+
+	success = prepared_key_init(key, keys[k].fingerprint, keys[k].s_bytes, keys[k].t_bytes, keys[k].A);
+	if (success == EXIT_SUCCESS) success = check_prepared_key(key, k);
+
+	free(key);
+	return success;
+}
+
+// TEST 2 : a key with a coefficient of s or t out of [0, q) is rejected and never cached
+
+int test_invalid_key() {
+	keycache_t* cache = keycache_new(NUM_KEYS);
+	keycache_stats_t stats;
+	uint8_t s_bytes[KEYCACHE_VECTOR_BYTES], t_bytes[KEYCACHE_VECTOR_BYTES];
+	int pos = 3 * (rand() % (KEYCACHE_VECTOR_BYTES / 3));
+	int success = EXIT_SUCCESS;
+
+	if (cache == NULL) return EXIT_FAILURE;
+
+	memcpy(s_bytes, keys[0].s_bytes, KEYCACHE_VECTOR_BYTES);
+	memcpy(t_bytes, keys[0].t_bytes, KEYCACHE_VECTOR_BYTES);
+	// First coefficient of the pair at pos set to 0xFFF
+	if (rand() & 1) {
+		s_bytes[pos] = 0xFF;
+		s_bytes[pos + 1] |= 0x0F;
+	}
+	else {
+		t_bytes[pos] = 0xFF;
+		t_bytes[pos + 1] |= 0x0F;
+	}
+
+	if (keycache_acquire(cache, keys[0].fingerprint, s_bytes, t_bytes, keys[0].A) != NULL) success = EXIT_FAILURE;
+	keycache_stats(cache, &stats);
+	if (stats.size != 0 || stats.misses != 1) success = EXIT_FAILURE;
+
+	keycache_secure_free(&cache);
+	return success;
+}
+
+/*********/
+/* CACHE */
+/*********/
+
+// TEST 3 : hits, misses and least recently used evictions
+
+int test_lru() {
+	keycache_t* cache = keycache_new(3);
+	keycache_stats_t stats;
+	const prepared_key_t* first;
+	const prepared_key_t* key;
+	int k, success = EXIT_SUCCESS;
+
+	if (cache == NULL) return EXIT_FAILURE;
+
+	// Misses on 0, 1, 2 then hits on 0 : 1 becomes the least recently used
+	for (k = 0; k < 3; k++) {
+		key = acquire(cache, k);
+		if (check_prepared_key(key, k) == EXIT_FAILURE) success = EXIT_FAILURE;
+		keycache_release(cache, key);
+	}
+	first = acquire(cache, 0);
+	keycache_release(cache, first);
+
+	// 3 evicts 1, then 0 and 2 are still there and 1 is prepared again
+	key = acquire(cache, 3);
+	keycache_release(cache, key);
+	key = acquire(cache, 0);
+	if (key != first) success = EXIT_FAILURE;
+	keycache_release(cache, key);
+	key = acquire(cache, 2);
+	keycache_release(cache, key);
+	key = acquire(cache, 1);
+	if (check_prepared_key(key, 1) == EXIT_FAILURE) success = EXIT_FAILURE;
+	keycache_release(cache, key);
+
+	keycache_stats(cache, &stats);
+	if (stats.hits != 3 || stats.misses != 5 || stats.evictions != 2 || stats.size != 3 || stats.capacity != 3) success = EXIT_FAILURE;
+
+	keycache_secure_free(&cache);
+	return success;
+}
+
+// TEST 4 : a key evicted while in use stays valid until it is released
+
+int test_evicted_in_use() {
+	keycache_t* cache = keycache_new(1);
+	const prepared_key_t* held;
+	const prepared_key_t* key;
+	int success = EXIT_SUCCESS;
+
+	if (cache == NULL) return EXIT_FAILURE;
+
+	held = acquire(cache, 0);
+	key = acquire(cache, 1);
+	keycache_release(cache, key);
+	key = acquire(cache, 2);
+	keycache_release(cache, key);
+
+	if (check_prepared_key(held, 0) == EXIT_FAILURE) success = EXIT_FAILURE;
+	keycache_release(cache, held);
+
+	keycache_secure_free(&cache);
+	return success;
+}
+
+// TEST 5 : concurrent acquisitions always give the right key, and every one of them is counted
+
+typedef struct {
+	keycache_t* cache;
+	unsigned seed;
+	int success;
+} worker_arg_t;
+
+void* worker(void* arg) {
+	worker_arg_t* w = (worker_arg_t*)arg;
+	const prepared_key_t* key;
+	int i, k;
+
+	w->success = EXIT_SUCCESS;
+	for (i = 0; i < NUM_TRIALS; i++) {
+		k = rand_r(&w->seed) % NUM_KEYS;
+		key = acquire(w->cache, k);
+		if (key == NULL || memcmp(key->fingerprint, keys[k].fingerprint, KEYCACHE_FINGERPRINT_BYTES) != 0 || memcmp(key->t_hat.vec, keys[k].t_bytes, KEYCACHE_VECTOR_BYTES) != 0) {
+			w->success = EXIT_FAILURE;
+		}
+		keycache_release(w->cache, key);
+	}
+
+	return NULL;
+}
+
+int test_threads() {
+	keycache_t* cache = keycache_new(NUM_KEYS / 2);
+	keycache_stats_t stats;
+	pthread_t threads[NUM_THREADS];
+	worker_arg_t args[NUM_THREADS];
+	int i, success = EXIT_SUCCESS;
+
+	if (cache == NULL) return EXIT_FAILURE;
+
+	for (i = 0; i < NUM_THREADS; i++) {
+		args[i].cache = cache;
+		args[i].seed = (unsigned)rand();
+		if (pthread_create(&threads[i], NULL, worker, &args[i]) != 0) return EXIT_FAILURE;
+	}
+	for (i = 0; i < NUM_THREADS; i++) {
+		pthread_join(threads[i], NULL);
+		if (args[i].success == EXIT_FAILURE) success = EXIT_FAILURE;
+	}
+
+	keycache_stats(cache, &stats);
+	if (stats.hits + stats.misses != NUM_THREADS * NUM_TRIALS || stats.size > stats.capacity) success = EXIT_FAILURE;
+
+	keycache_secure_free(&cache);
+	return success;
+}
+
+/**********************/
+/* DISPLAYING RESULTS */
+/**********************/
+
+void display_results(int num, int success, int* test_success) {
+	if (success == EXIT_SUCCESS) {
+		(*test_success)++;
+		printf("✅ TEST %i : Successful\n", num);
+	}
+	else {
+		printf("❌ TEST %i : Failure\n", num);
+	}
+}
+
+void run_test(int num, int (*test)(void), int trials, int* test_success, int* test_total) {
+	int i;
+	int success = EXIT_SUCCESS;
+
+	for (i = 0; i < trials; i++) {
+		if (test() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(num, success, test_success);
+	(*test_total)++;
+}
+
+/********************/
+/* TESTS EXECUTIONS */
+/********************/
+
+int main() {
+
+	int test_success = 0;
+	int test_total = 0;
+	int k;
+
+	printf("╔══════════════════════════════════════╗\n");
+	printf("║   RUNNING KYBER-mini KEYCACHE TESTS  ║\n");
+	printf("╚══════════════════════════════════════╝\n");
+
+	if (generate_keys() == EXIT_FAILURE) {
+		printf("⚠️  Allocation failure\n");
+		return EXIT_FAILURE;
+	}
+
+	run_test(1, test_prepared_key, NUM_TRIALS, &test_success, &test_total);
+	run_test(2, test_invalid_key, NUM_TRIALS, &test_success, &test_total);
+	run_test(3, test_lru, NUM_TRIALS, &test_success, &test_total);
+	run_test(4, test_evicted_in_use, NUM_TRIALS, &test_success, &test_total);
+	run_test(5, test_threads, 10, &test_success, &test_total);
+
+	for (k = 0; k < NUM_KEYS; k++) {
+		polymat_secure_free(&keys[k].A);
+	}
+
+	/*****************/
+	/* FINAL SUMMARY */
+	/*****************/
+
+	printf("╔════════════════════════════════════════╗\n");
+	printf("║              FINAL SUMMARY             ║\n");
+	printf("╚════════════════════════════════════════╝\n");
+	printf("Successful tests : %i/%i\n", test_success, test_total);
+
+	if (test_success == test_total) {
+		printf("🎉 ALL TESTS WERE SUCCESSFUL 🎉\n");
+		return EXIT_SUCCESS;
+	}
+	else {
+		printf("⚠️  %i TEST(S) FAILED.\n", test_total - test_success);
+		return EXIT_FAILURE;
+	}
+
+}
@@ -0,0 +1,282 @@
+/**
+ * @file test_keystore.c
+ * @details Test the memory-mapped keystore file
+ * @author Gabriel Abauzit
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "consts.h"
+#include "reduce.h"
+#include "poly.h"
+#include "polyvec.h"
+#include "keystore.h"
+
+#ifndef NUM_TRIALS
+	#define NUM_TRIALS 20
+#endif
+
+#define MAX_KEYS 64
+#define VECTORS_PER_KEY 2
+
+uint8_t fingerprints[MAX_KEYS][KEYSTORE_FINGERPRINT_BYTES];
+polyvec_t vectors[MAX_KEYS * VECTORS_PER_KEY];
+char path[64];
+
+void random_polyvec(polyvec_t* f) {
+	int i, j;
+
+	for (i = 0; i < KYBER_K; i++) {
+		for (j = 0; j < KYBER_N; j++) {
+			f->vec[i].coeffs[j] = barrett_reduce((int16_t)(rand() % KYBER_Q));
+		}
+	}
+}
+
+// Writes a keystore of count random keys to path
+int write_random_keystore(uint64_t count) {
+	uint64_t i;
+	int j;
+
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < KEYSTORE_FINGERPRINT_BYTES; j++) {
+			fingerprints[i][j] = (uint8_t)rand();
+		}
+		for (j = 0; j < VECTORS_PER_KEY; j++) {
+			random_polyvec(&vectors[i * VECTORS_PER_KEY + j]);
+		}
+	}
+
+	return keystore_write(path, (const uint8_t (*)[KEYSTORE_FINGERPRINT_BYTES])fingerprints, vectors, count, VECTORS_PER_KEY);
+}
+
+// Flips one bit of the file at offset
+int corrupt(long offset) {
+	FILE* f = fopen(path, "r+b");
+	int c;
+
+	if (f == NULL) return EXIT_FAILURE;
+	fseek(f, offset, SEEK_SET);
+	c = fgetc(f);
+	fseek(f, offset, SEEK_SET);
+	fputc(c ^ 1, f);
+	fclose(f);
+
+	return EXIT_SUCCESS;
+}
+
+/***********************/
+/* WRITING AND READING */
+/***********************/
+
+// TEST 1 : every key written is found in place with the same vectors, unknown fingerprints are not found
+
+int test_roundtrip() {
+	keystore_t ks;
+	uint64_t count = (uint64_t)(rand() % MAX_KEYS);
+	uint64_t i;
+	const polyvec_t* v;
+	uint8_t unknown[KEYSTORE_FINGERPRINT_BYTES];
+	int j, success = EXIT_SUCCESS;
+
+	if (write_random_keystore(count) == EXIT_FAILURE) return EXIT_FAILURE;
+	if (keystore_open(&ks, path, KEYSTORE_VERIFY) == EXIT_FAILURE) return EXIT_FAILURE;
+
+	if (ks.header->count != count || ((uintptr_t)ks.data % KEYSTORE_ALIGN) != 0) success = EXIT_FAILURE;
+
+	for (i = 0; i < count; i++) {
+		v = keystore_find(&ks, fingerprints[i]);
+		if (v == NULL) {
+			success = EXIT_FAILURE;
+			continue;
+		}
+		for (j = 0; j < VECTORS_PER_KEY; j++) {
+			if (memcmp(&v[j], &vectors[i * VECTORS_PER_KEY + j], sizeof(polyvec_t)) != 0) success = EXIT_FAILURE;
+		}
+	}
+
+	memset(unknown, 0xFF, sizeof(unknown));
+	if (keystore_find(&ks, unknown) != NULL) success = EXIT_FAILURE;
+	if (keystore_get(&ks, count) != NULL) success = EXIT_FAILURE;
+
+	keystore_close(&ks);
+	return success;
+}
+
+// TEST 2 : repeated fingerprints are refused by the writer
+
+int test_duplicate() {
+	if (write_random_keystore(4) == EXIT_FAILURE) return EXIT_FAILURE;
+
+	memcpy(fingerprints[3], fingerprints[1], KEYSTORE_FINGERPRINT_BYTES);
+	if (keystore_write(path, (const uint8_t (*)[KEYSTORE_FINGERPRINT_BYTES])fingerprints, vectors, 4, VECTORS_PER_KEY) == EXIT_SUCCESS) return EXIT_FAILURE;
+
+	return EXIT_SUCCESS;
+}
+
+/**************/
+/* VALIDATION */
+/**************/
+
+// TEST 3 : a corrupted index or data byte is only detected by the checksum, which can be deferred
+
+int test_deferred_checksum() {
+	keystore_t ks;
+	uint64_t count = 1 + (uint64_t)(rand() % (MAX_KEYS - 1));
+	long offset = (long)sizeof(keystore_header_t) + rand() % (long)(count * (sizeof(keystore_index_t) + VECTORS_PER_KEY * sizeof(polyvec_t)));
+	int success = EXIT_SUCCESS;
+
+	if (write_random_keystore(count) == EXIT_FAILURE) return EXIT_FAILURE;
+	if (corrupt(offset) == EXIT_FAILURE) return EXIT_FAILURE;
+
+	if (keystore_open(&ks, path, KEYSTORE_VERIFY) == EXIT_SUCCESS) {
+		keystore_close(&ks);
+		success = EXIT_FAILURE;
+	}
+
+	if (keystore_open(&ks, path, 0) == EXIT_FAILURE) return EXIT_FAILURE;
+	if (keystore_verify(&ks) == EXIT_SUCCESS) success = EXIT_FAILURE;
+	keystore_close(&ks);
+
+	return success;
+}
+
+// TEST 4 : a corrupted header or a truncated file is refused when opening
+
+int test_bad_header() {
+	keystore_t ks;
+	uint64_t count = 1 + (uint64_t)(rand() % (MAX_KEYS - 1));
+	long fields[] = {0, 8, 12, 16, 24, 32, 40, 48};
+
+	if (write_random_keystore(count) == EXIT_FAILURE) return EXIT_FAILURE;
+	if (corrupt(fields[rand() % (int)(sizeof(fields) / sizeof(fields[0]))]) == EXIT_FAILURE) return EXIT_FAILURE;
+	if (keystore_open(&ks, path, 0) == EXIT_SUCCESS) {
+		keystore_close(&ks);
+		return EXIT_FAILURE;
+	}
+
+	if (write_random_keystore(count) == EXIT_FAILURE) return EXIT_FAILURE;
+	if (truncate(path, (off_t)(sizeof(keystore_header_t) + count * sizeof(keystore_index_t))) != 0) return EXIT_FAILURE;
+	if (keystore_open(&ks, path, 0) == EXIT_SUCCESS) {
+		keystore_close(&ks);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+// TEST 5 : a header whose data size only matches the file length once count * vectors_per_key * sizeof(polyvec_t)
+// wraps around 2^64 is refused, each factor being small enough on its own
+
+int test_size_overflow() {
+	keystore_t ks;
+	keystore_header_t h;
+	const uint64_t vector_bytes = sizeof(polyvec_t), count = 1ULL << 27;
+	// The smallest vectors_per_key whose data size wraps past 2^64 by more than count vectors
+	const uint64_t vectors_per_key = UINT64_MAX / (count * vector_bytes) + 2;
+	uint64_t length;
+	FILE* f;
+
+	if (write_random_keystore(1) == EXIT_FAILURE) return EXIT_FAILURE;
+	f = fopen(path, "r+b");
+	if (f == NULL || fread(&h, sizeof(h), 1, f) != 1) {
+		if (f != NULL) fclose(f);
+		return EXIT_FAILURE;
+	}
+
+	h.count = count;
+	h.vectors_per_key = (uint32_t)vectors_per_key;
+	h.data_offset = (h.index_offset + count * sizeof(keystore_index_t) + KEYSTORE_ALIGN - 1) & ~(uint64_t)(KEYSTORE_ALIGN - 1);
+	length = h.data_offset + count * vectors_per_key * vector_bytes;
+	rewind(f);
+	fwrite(&h, sizeof(h), 1, f);
+	fclose(f);
+
+	// A sparse file of about 2^37 bytes, nothing is written past the header
+	if (truncate(path, (off_t)length) != 0) {
+		printf("   the file system refuses a sparse file of %llu bytes, test skipped\n", (unsigned long long)length);
+		return EXIT_SUCCESS;
+	}
+	if (keystore_open(&ks, path, 0) == EXIT_SUCCESS) {
+		keystore_close(&ks);
+		remove(path);
+		return EXIT_FAILURE;
+	}
+
+	remove(path);
+	return EXIT_SUCCESS;
+}
+
+/**********************/
+/* DISPLAYING RESULTS */
+/**********************/
+
+void display_results(int num, int success, int* test_success) {
+	if (success == EXIT_SUCCESS) {
+		(*test_success)++;
+		printf("✅ TEST %i : Successful\n", num);
+	}
+	else {
+		printf("❌ TEST %i : Failure\n", num);
+	}
+}
+
+void run_test(int num, int (*test)(void), int trials, int* test_success, int* test_total) {
+	int i;
+	int success = EXIT_SUCCESS;
+
+	for (i = 0; i < trials; i++) {
+		if (test() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(num, success, test_success);
+	(*test_total)++;
+}
+
+/********************/
+/* TESTS EXECUTIONS */
+/********************/
+
+int main() {
+
+	int test_success = 0;
+	int test_total = 0;
+
+	printf("╔══════════════════════════════════════╗\n");
+	printf("║   RUNNING KYBER-mini KEYSTORE TESTS  ║\n");
+	printf("╚══════════════════════════════════════╝\n");
+
+	snprintf(path, sizeof(path), "/tmp/test_keystore_%ld.bin", (long)getpid());
+
+	run_test(1, test_roundtrip, NUM_TRIALS, &test_success, &test_total);
+	run_test(2, test_duplicate, NUM_TRIALS, &test_success, &test_total);
+	run_test(3, test_deferred_checksum, NUM_TRIALS, &test_success, &test_total);
+	run_test(4, test_bad_header, NUM_TRIALS, &test_success, &test_total);
+	run_test(5, test_size_overflow, 1, &test_success, &test_total);
+
+	remove(path);
+
+	/*****************/
+	/* FINAL SUMMARY */
+	/*****************/
+
+	printf("╔════════════════════════════════════════╗\n");
+	printf("║              FINAL SUMMARY             ║\n");
+	printf("╚════════════════════════════════════════╝\n");
+	printf("Successful tests : %i/%i\n", test_success, test_total);
+
+	if (test_success == test_total) {
+		printf("🎉 ALL TESTS WERE SUCCESSFUL 🎉\n");
+		return EXIT_SUCCESS;
+	}
+	else {
+		printf("⚠️  %i TEST(S) FAILED.\n", test_total - test_success);
+		return EXIT_FAILURE;
+	}
+
+}
@@ -10,6 +10,7 @@
 #include "consts.h"
 #include "reduce.h"
 #include "poly.h"
+#include "polyvec.h"
 #include "ntt.h"
 
 #ifndef NUM_TRIALS
@@ -144,6 +145,332 @@ int test_NTT_multiplication() {
 	return poly_equal(&prod_naif, &prod_ntt);
 }
 
+// TEST 6 : poly_dom_mult(a, b) = poly_mult(a, b) for all the input and output domains
+
+int test_poly_dom_mult() {
+	poly_t a = random_poly();
+	poly_t b = random_poly();
+	poly_t prod;
+	poly_dom_t a_dom, b_dom, r_dom, expected;
+	int da, db, dr;
+	int success = EXIT_SUCCESS;
+
+	poly_mult(&prod, &a, &b);
+
+	for (da = POLY_NORMAL; da <= POLY_NTT_MONTGOMERY; da++) {
+		for (db = POLY_NORMAL; db <= POLY_NTT_MONTGOMERY; db++) {
+			for (dr = POLY_NORMAL; dr <= POLY_NTT_MONTGOMERY; dr++) {
+				poly_dom_init(&a_dom, &a, POLY_NORMAL);
+				poly_dom_init(&b_dom, &b, POLY_NORMAL);
+				poly_dom_init(&expected, &prod, POLY_NORMAL);
+				poly_dom_convert(&a_dom, (poly_domain_t)da);
+				poly_dom_convert(&b_dom, (poly_domain_t)db);
+				poly_dom_convert(&expected, (poly_domain_t)dr);
+
+				poly_dom_mult(&r_dom, &a_dom, &b_dom, (poly_domain_t)dr);
+
+				if (r_dom.domain != expected.domain || poly_equal(&r_dom.poly, &expected.poly) == EXIT_FAILURE) {
+					success = EXIT_FAILURE;
+				}
+
+				// Going back to the normal domain gives the plain product
+				poly_dom_convert(&r_dom, POLY_NORMAL);
+				if (poly_equal(&r_dom.poly, &prod) == EXIT_FAILURE) {
+					success = EXIT_FAILURE;
+				}
+			}
+		}
+	}
+
+	return success;
+}
+
+// TEST 7 : poly_mult_cached(cache(a), b) = poly_mult(a, b)
+
+int test_poly_mult_cached() {
+	poly_t a = random_poly();
+	poly_t b = random_poly();
+	poly_t prod, prod_cached;
+	poly_ntt_cache_t* cache = poly_ntt_cache_new(&a);
+	int success;
+
+	if (cache == NULL) return EXIT_FAILURE;
+
+	poly_mult(&prod, &a, &b);
+	poly_mult_cached(&prod_cached, cache, &b);
+	success = poly_equal(&prod, &prod_cached);
+
+	poly_ntt_cache_secure_free(&cache);
+
+	return success;
+}
+
+// TEST 8 : polyvec_scalar_product_cached(cache(a), b) = sum of the poly_mult(a_i, b_i)
+
+int test_polyvec_scalar_product_cached() {
+	polyvec_t a, b;
+	poly_t prod, sum, sum_cached;
+	polyvec_ntt_cache_t* cache;
+	int i, success;
+
+	for (i = 0; i < KYBER_K; i++) {
+		a.vec[i] = random_poly();
+		b.vec[i] = random_poly();
+	}
+
+	cache = polyvec_ntt_cache_new(&a);
+	if (cache == NULL) return EXIT_FAILURE;
+
+	poly_zero(&sum);
+	for (i = 0; i < KYBER_K; i++) {
+		poly_mult(&prod, &a.vec[i], &b.vec[i]);
+		poly_add(&sum, &sum, &prod);
+	}
+	polyvec_scalar_product_cached(&sum_cached, cache, &b);
+	success = poly_equal(&sum, &sum_cached);
+
+	polyvec_ntt_cache_secure_free(&cache);
+
+	return success;
+}
+
+poly_t random_small_poly(int eta) {
+	int i;
+	poly_t f;
+
+	for (i = 0; i < KYBER_N; i++) {
+		f.coeffs[i] = (int16_t)(rand() % (2*eta + 1) - eta);
+	}
+
+	return f;
+}
+
+// TEST 9 : poly_ntt_inv_add_compress(f, e, m) = Compress_dv(NTT_inv(f) + e + Decompress_1(m))
+
+int test_poly_ntt_inv_add_compress() {
+	poly_t f = random_poly();
+	poly_t e = random_small_poly(KYBER_ETA2);
+	poly_t m, expected, fused;
+	int i;
+
+	for (i = 0; i < KYBER_N; i++) {
+		m.coeffs[i] = (int16_t)(rand() & 1);
+	}
+
+	poly_copy(&expected, &f);
+	NTT_inv_scaled(expected.coeffs, NTT_INV_FACTOR_R1);
+	poly_add(&expected, &expected, &e);
+	poly_decompress(&m, 1);
+	poly_add(&expected, &expected, &m);
+	poly_compress(&expected, KYBER_DV);
+
+	poly_compress(&m, 1);
+	poly_ntt_inv_add_compress(&fused, &f, &e, &m, KYBER_DV);
+
+	for (i = 0; i < KYBER_N; i++) {
+		if (expected.coeffs[i] != fused.coeffs[i]) return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+// TEST 10 : polyvec_ntt_inv_add_compress(f, e) = Compress_du(NTT_inv(f) + e)
+
+int test_polyvec_ntt_inv_add_compress() {
+	polyvec_t f, e, expected, fused;
+	int i, j;
+
+	for (i = 0; i < KYBER_K; i++) {
+		f.vec[i] = random_poly();
+		e.vec[i] = random_small_poly(KYBER_ETA2);
+		poly_copy(&expected.vec[i], &f.vec[i]);
+		NTT_inv_scaled(expected.vec[i].coeffs, NTT_INV_FACTOR_R1);
+	}
+
+	polyvec_add(&expected, &expected, &e);
+	polyvec_compress(&expected, KYBER_DU);
+
+	polyvec_ntt_inv_add_compress(&fused, &f, &e, KYBER_DU);
+
+	for (i = 0; i < KYBER_K; i++) {
+		for (j = 0; j < KYBER_N; j++) {
+			if (expected.vec[i].coeffs[j] != fused.vec[i].coeffs[j]) return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+// TEST 11 : polymat_ntt_product(A, v) = polyvec_ntt_product(A, v) and polymat_ntt_product(A, v, transposed) = polyvec_ntt_product(A^T, v)
+
+int test_polymat_ntt_product() {
+	polymat_t* A = polymat_new();
+	const polyvec_t* rows[KYBER_K];
+	polyvec_t v, expected, r;
+	int i, j, success = EXIT_SUCCESS;
+
+	if (A == NULL) return EXIT_FAILURE;
+
+	for (i = 0; i < KYBER_K; i++) {
+		v.vec[i] = random_poly();
+		for (j = 0; j < KYBER_K; j++) {
+			A->row[i].vec[j] = random_poly();
+		}
+		rows[i] = &A->row[i];
+	}
+
+	polyvec_ntt_product(&expected, rows, &v);
+	polymat_ntt_product(&r, A, &v, 0);
+	for (i = 0; i < KYBER_K; i++) {
+		if (poly_equal(&expected.vec[i], &r.vec[i]) == EXIT_FAILURE) success = EXIT_FAILURE;
+	}
+
+	polymat_ntt_product(&r, A, &v, 1);
+	polyvec_transpose((polyvec_t**)rows);
+	polyvec_ntt_product(&expected, rows, &v);
+	for (i = 0; i < KYBER_K; i++) {
+		if (poly_equal(&expected.vec[i], &r.vec[i]) == EXIT_FAILURE) success = EXIT_FAILURE;
+	}
+
+	polymat_secure_free(&A);
+
+	return success;
+}
+
+// TEST 12 : NTT_multiply_packed(pack(a), b) = NTT_multiply(a, b) and unpack(pack(a)) = a
+
+int test_NTT_multiply_packed() {
+	poly_t a = random_poly();
+	poly_t b = random_poly();
+	poly_t expected, r, unpacked;
+	poly_packed_t packed;
+
+	NTT(a.coeffs);
+	NTT(b.coeffs);
+	poly_pack(&packed, &a);
+
+	poly_unpack(&unpacked, &packed);
+	if (poly_equal(&a, &unpacked) == EXIT_FAILURE) return EXIT_FAILURE;
+
+	NTT_multiply(expected.coeffs, a.coeffs, b.coeffs);
+	NTT_multiply_packed(r.coeffs, packed.bytes, b.coeffs);
+
+	return memcmp(expected.coeffs, r.coeffs, sizeof(r.coeffs)) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// TEST 13 : polyvec_ntt_product_packed(pack(A), v) = polyvec_ntt_product(A, v)
+
+int test_polyvec_ntt_product_packed() {
+	polyvec_t A[KYBER_K];
+	polyvec_packed_t A_packed[KYBER_K];
+	const polyvec_t* rows[KYBER_K];
+	polyvec_t v, expected, r;
+	int i, j;
+
+	for (i = 0; i < KYBER_K; i++) {
+		v.vec[i] = random_poly();
+		for (j = 0; j < KYBER_K; j++) {
+			A[i].vec[j] = random_poly();
+		}
+		polyvec_pack(&A_packed[i], &A[i]);
+		rows[i] = &A[i];
+	}
+
+	polyvec_ntt_product(&expected, rows, &v);
+	polyvec_ntt_product_packed(&r, A_packed, &v);
+	for (i = 0; i < KYBER_K; i++) {
+		if (poly_equal(&expected.vec[i], &r.vec[i]) == EXIT_FAILURE) return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+// TEST 14 : polyvec_ntt_product_stream(A, v) = polymat_ntt_product(A, v), transposed or not, each entry being generated once
+
+int stream_calls[KYBER_K][KYBER_K];
+
+void stream_entry(poly_t* a, const int i, const int j, void* arg) {
+	const polymat_t* A = (const polymat_t*)arg;
+
+	stream_calls[i][j]++;
+	*a = A->row[i].vec[j];
+}
+
+int test_polyvec_ntt_product_stream() {
+	polymat_t* A = polymat_new();
+	polymat_stream_t stream = {stream_entry, NULL};
+	polyvec_t v, expected, r;
+	int i, j, transposed, success = EXIT_SUCCESS;
+
+	if (A == NULL) return EXIT_FAILURE;
+	stream.arg = A;
+
+	for (i = 0; i < KYBER_K; i++) {
+		v.vec[i] = random_poly();
+		for (j = 0; j < KYBER_K; j++) {
+			A->row[i].vec[j] = random_poly();
+		}
+	}
+
+	for (transposed = 0; transposed < 2; transposed++) {
+		memset(stream_calls, 0, sizeof(stream_calls));
+		polymat_ntt_product(&expected, A, &v, transposed);
+		polyvec_ntt_product_stream(&r, &stream, &v, transposed);
+		for (i = 0; i < KYBER_K; i++) {
+			if (poly_equal(&expected.vec[i], &r.vec[i]) == EXIT_FAILURE) success = EXIT_FAILURE;
+			for (j = 0; j < KYBER_K; j++) {
+				if (stream_calls[i][j] != 1) success = EXIT_FAILURE;
+			}
+		}
+	}
+
+	polymat_secure_free(&A);
+
+	return success;
+}
+
+// TEST 15 : a chain of poly_add_noreduce / poly_sub_noreduce reduced once = the same chain of poly_add / poly_sub,
+//           and the NTT products stay within POLY_BOUND_PRODUCT
+
+int test_noreduce_bounds() {
+	poly_t a = random_poly(), b = random_poly(), c = random_poly();
+	poly_t lazy, eager;
+	polyvec_t u, v;
+	int i;
+
+	poly_add_noreduce(&lazy, &a, &b);
+	poly_sub_noreduce(&lazy, &lazy, &c);
+	poly_add_noreduce(&lazy, &lazy, &a);
+	if (poly_within_bound(&lazy, 4 * POLY_BOUND_CANONICAL) == EXIT_FAILURE) return EXIT_FAILURE;
+	poly_reduce(&lazy);
+
+	poly_add(&eager, &a, &b);
+	poly_sub(&eager, &eager, &c);
+	poly_add(&eager, &eager, &a);
+	if (memcmp(lazy.coeffs, eager.coeffs, sizeof(eager.coeffs)) != 0) return EXIT_FAILURE;
+
+	for (i = 0; i < KYBER_K; i++) {
+		u.vec[i] = random_poly();
+		v.vec[i] = random_poly();
+	}
+	polyvec_ntt_scalar_product(&lazy, &u, &v);
+	if (poly_within_bound(&lazy, POLY_BOUND_PRODUCT) == EXIT_FAILURE) return EXIT_FAILURE;
+
+	// Worst case of the bound : every product term at -(q-1)
+	for (i = 0; i < KYBER_N; i++) {
+		a.coeffs[i] = -POLY_BOUND_BASEMUL;
+	}
+	poly_zero(&lazy);
+	for (i = 0; i < KYBER_K; i++) {
+		poly_add_noreduce(&lazy, &lazy, &a);
+	}
+	if (poly_within_bound(&lazy, POLY_BOUND_NTT_INV) == EXIT_FAILURE) return EXIT_FAILURE;
+	eager = lazy;
+	poly_reduce(&eager);
+	NTT_inv(lazy.coeffs);
+	NTT_inv(eager.coeffs);
+
+	return poly_equal(&lazy, &eager) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 /**********************/
 /* DISPLAYING RESULTS */
 /**********************/
@@ -224,6 +551,136 @@ int main() {
 	display_results(5, success, &test_success);
 	test_total++;
 
+	// TEST 6
+
+	success = EXIT_SUCCESS;
+
+	for (i = 0; i < NUM_TRIALS; i++) {
+		if (test_poly_dom_mult() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(6, success, &test_success);
+	test_total++;
+
+	// TEST 7
+
+	success = EXIT_SUCCESS;
+
+	for (i = 0; i < NUM_TRIALS; i++) {
+		if (test_poly_mult_cached() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(7, success, &test_success);
+	test_total++;
+
+	// TEST 8
+
+	success = EXIT_SUCCESS;
+
+	for (i = 0; i < NUM_TRIALS; i++) {
+		if (test_polyvec_scalar_product_cached() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(8, success, &test_success);
+	test_total++;
+
+	// TEST 9
+
+	success = EXIT_SUCCESS;
+
+	for (i = 0; i < NUM_TRIALS; i++) {
+		if (test_poly_ntt_inv_add_compress() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(9, success, &test_success);
+	test_total++;
+
+	// TEST 10
+
+	success = EXIT_SUCCESS;
+
+	for (i = 0; i < NUM_TRIALS; i++) {
+		if (test_polyvec_ntt_inv_add_compress() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(10, success, &test_success);
+	test_total++;
+
+	// TEST 11
+
+	success = EXIT_SUCCESS;
+
+	for (i = 0; i < NUM_TRIALS; i++) {
+		if (test_polymat_ntt_product() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(11, success, &test_success);
+	test_total++;
+
+	// TEST 12
+
+	success = EXIT_SUCCESS;
+
+	for (i = 0; i < NUM_TRIALS; i++) {
+		if (test_NTT_multiply_packed() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(12, success, &test_success);
+	test_total++;
+
+	// TEST 13
+
+	success = EXIT_SUCCESS;
+
+	for (i = 0; i < NUM_TRIALS; i++) {
+		if (test_polyvec_ntt_product_packed() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(13, success, &test_success);
+	test_total++;
+
+	// TEST 14
+
+	success = EXIT_SUCCESS;
+
+	for (i = 0; i < NUM_TRIALS; i++) {
+		if (test_polyvec_ntt_product_stream() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(14, success, &test_success);
+	test_total++;
+
+	// TEST 15
+
+	success = EXIT_SUCCESS;
+
+	for (i = 0; i < NUM_TRIALS; i++) {
+		if (test_noreduce_bounds() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(15, success, &test_success);
+	test_total++;
+
 	/*****************/
 	/* FINAL SUMMARY */
 	/*****************/
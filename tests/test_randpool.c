@@ -0,0 +1,247 @@
+/**
+ * @file test_randpool.c
+ * @details Test the randomness pool : refills, deterministic mode, fork and threads
+ * @author Gabriel Abauzit
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include "randpool.h"
+
+#ifndef NUM_TRIALS
+	#define NUM_TRIALS 100
+#endif
+
+/*********/
+/* DRAWS */
+/*********/
+
+// TEST 1 : consecutive seeds differ and cost one refill per RANDPOOL_BYTES
+
+int test_seeds() {
+	static uint8_t seeds[2 * RANDPOOL_BYTES / RANDPOOL_SEED_BYTES][RANDPOOL_SEED_BYTES];
+	const size_t n = sizeof(seeds) / sizeof(seeds[0]);
+	uint64_t before;
+	size_t i;
+
+	randpool_reseed();
+	before = randpool_refills();
+	for (i = 0; i < n; i++) {
+		if (randpool_seed(seeds[i]) == EXIT_FAILURE) return EXIT_FAILURE;
+	}
+	if (randpool_refills() - before != 2) return EXIT_FAILURE;
+
+	for (i = 1; i < n; i++) {
+		if (memcmp(seeds[i - 1], seeds[i], RANDPOOL_SEED_BYTES) == 0) return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+// TEST 2 : a draw longer than the pool spans several refills and is not made of repeated buffers
+
+int test_long_draw() {
+	static uint8_t out[3 * RANDPOOL_BYTES + 17];
+	uint64_t before;
+
+	randpool_reseed();
+	before = randpool_refills();
+	if (randpool_bytes(out, sizeof(out)) == EXIT_FAILURE) return EXIT_FAILURE;
+	if (randpool_refills() - before != 4) return EXIT_FAILURE;
+
+	if (memcmp(out, out + RANDPOOL_BYTES, RANDPOOL_BYTES) == 0) return EXIT_FAILURE;
+	if (memcmp(out + RANDPOOL_BYTES, out + 2 * RANDPOOL_BYTES, RANDPOOL_BYTES) == 0) return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
+
+/**********************/
+/* DETERMINISTIC MODE */
+/**********************/
+
+// TEST 3 : the same seed gives the same stream, another seed another one, and NULL goes back to the OS
+
+int test_deterministic() {
+	uint8_t det[RANDPOOL_SEED_BYTES] = {1, 2, 3}, other[RANDPOOL_SEED_BYTES] = {1, 2, 4};
+	uint8_t a[100], b[100], c[100], d[100];
+	int status = EXIT_SUCCESS;
+
+	randpool_deterministic(det);
+	randpool_bytes(a, sizeof(a));
+	randpool_deterministic(det);
+	randpool_bytes(b, sizeof(b));
+	randpool_deterministic(other);
+	randpool_bytes(c, sizeof(c));
+	randpool_deterministic(NULL);
+	randpool_bytes(d, sizeof(d));
+
+	if (memcmp(a, b, sizeof(a)) != 0) status = EXIT_FAILURE;
+	if (memcmp(a, c, sizeof(a)) == 0) status = EXIT_FAILURE;
+	if (memcmp(a, d, sizeof(a)) == 0) status = EXIT_FAILURE;
+	return status;
+}
+
+// TEST 4 : seeds differing in a few bytes give different streams, including bytes 8 apart
+
+int test_deterministic_seed_bits() {
+	uint8_t det[RANDPOOL_SEED_BYTES], other[RANDPOOL_SEED_BYTES];
+	uint8_t a[64], b[64];
+	const int k = rand() % (RANDPOOL_SEED_BYTES - 8);
+	const uint8_t delta = (uint8_t)(1 + rand() % 255);
+	int status = EXIT_SUCCESS;
+
+	randpool_seed(det);
+	memcpy(other, det, RANDPOOL_SEED_BYTES);
+	other[k] ^= delta;
+	other[k + 8] ^= delta;
+
+	randpool_deterministic(det);
+	randpool_bytes(a, sizeof(a));
+	randpool_deterministic(other);
+	randpool_bytes(b, sizeof(b));
+	if (memcmp(a, b, sizeof(a)) == 0) status = EXIT_FAILURE;
+
+	// Only bytes 0 and 8
+	memset(det, 0, RANDPOOL_SEED_BYTES);
+	memset(other, 0, RANDPOOL_SEED_BYTES);
+	other[0] = other[8] = 1;
+
+	randpool_deterministic(det);
+	randpool_bytes(a, sizeof(a));
+	randpool_deterministic(other);
+	randpool_bytes(b, sizeof(b));
+	if (memcmp(a, b, sizeof(a)) == 0) status = EXIT_FAILURE;
+
+	randpool_deterministic(NULL);
+	return status;
+}
+
+/*******************/
+/* FORK AND THREAD */
+/*******************/
+
+// TEST 5 : a forked child does not hand out the bytes buffered by its parent
+
+int test_fork() {
+	uint8_t warm[RANDPOOL_SEED_BYTES], parent[RANDPOOL_SEED_BYTES], child[RANDPOOL_SEED_BYTES];
+	int fds[2], status, received;
+	pid_t pid;
+
+	// The pool holds bytes when fork is called
+	randpool_seed(warm);
+
+	if (pipe(fds) != 0) return EXIT_FAILURE;
+	pid = fork();
+	if (pid < 0) return EXIT_FAILURE;
+	if (pid == 0) {
+		close(fds[0]);
+		status = randpool_seed(child) == EXIT_SUCCESS && write(fds[1], child, sizeof(child)) == (ssize_t)sizeof(child);
+		close(fds[1]);
+		_exit(status ? 0 : 1);
+	}
+
+	close(fds[1]);
+	randpool_seed(parent);
+	received = read(fds[0], child, sizeof(child)) == (ssize_t)sizeof(child);
+	close(fds[0]);
+	if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0 || !received) return EXIT_FAILURE;
+
+	return memcmp(parent, child, RANDPOOL_SEED_BYTES) != 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void* thread_seed(void* arg) {
+	randpool_seed((uint8_t*)arg);
+	return NULL;
+}
+
+// TEST 6 : each thread draws from its own pool, the deterministic mode gives them the same stream
+
+int test_threads() {
+	uint8_t det[RANDPOOL_SEED_BYTES] = {42};
+	uint8_t seeds[2][RANDPOOL_SEED_BYTES];
+	pthread_t threads[2];
+	int i, status = EXIT_SUCCESS;
+
+	for (i = 0; i < 2; i++) pthread_create(&threads[i], NULL, thread_seed, seeds[i]);
+	for (i = 0; i < 2; i++) pthread_join(threads[i], NULL);
+	if (memcmp(seeds[0], seeds[1], RANDPOOL_SEED_BYTES) == 0) status = EXIT_FAILURE;
+
+	randpool_deterministic(det);
+	for (i = 0; i < 2; i++) pthread_create(&threads[i], NULL, thread_seed, seeds[i]);
+	for (i = 0; i < 2; i++) pthread_join(threads[i], NULL);
+	if (memcmp(seeds[0], seeds[1], RANDPOOL_SEED_BYTES) != 0) status = EXIT_FAILURE;
+	randpool_deterministic(NULL);
+
+	return status;
+}
+
+/**********************/
+/* DISPLAYING RESULTS */
+/**********************/
+
+void display_results(int num, int success, int* test_success) {
+	if (success == EXIT_SUCCESS) {
+		(*test_success)++;
+		printf("✅ TEST %i : Successful\n", num);
+	}
+	else {
+		printf("❌ TEST %i : Failure\n", num);
+	}
+}
+
+void run_test(int num, int (*test)(void), int trials, int* test_success, int* test_total) {
+	int i;
+	int success = EXIT_SUCCESS;
+
+	for (i = 0; i < trials; i++) {
+		if (test() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(num, success, test_success);
+	(*test_total)++;
+}
+
+/********************/
+/* TESTS EXECUTIONS */
+/********************/
+
+int main() {
+
+	int test_success = 0;
+	int test_total = 0;
+
+	printf("╔══════════════════════════════════════╗\n");
+	printf("║   RUNNING KYBER-mini RANDPOOL TESTS  ║\n");
+	printf("╚══════════════════════════════════════╝\n");
+
+	run_test(1, test_seeds, NUM_TRIALS, &test_success, &test_total);
+	run_test(2, test_long_draw, NUM_TRIALS, &test_success, &test_total);
+	run_test(3, test_deterministic, NUM_TRIALS, &test_success, &test_total);
+	run_test(4, test_deterministic_seed_bits, NUM_TRIALS, &test_success, &test_total);
+	run_test(5, test_fork, 10, &test_success, &test_total);
+	run_test(6, test_threads, 10, &test_success, &test_total);
+
+	/*****************/
+	/* FINAL SUMMARY */
+	/*****************/
+
+	printf("╔════════════════════════════════════════╗\n");
+	printf("║              FINAL SUMMARY             ║\n");
+	printf("╚════════════════════════════════════════╝\n");
+	printf("Successful tests : %i/%i\n", test_success, test_total);
+
+	if (test_success == test_total) {
+		printf("🎉 ALL TESTS WERE SUCCESSFUL 🎉\n");
+		return EXIT_SUCCESS;
+	}
+	else {
+		printf("⚠️  %i TEST(S) FAILED.\n", test_total - test_success);
+		return EXIT_FAILURE;
+	}
+
+}
@@ -0,0 +1,197 @@
+/**
+ * @file test_reduce.c
+ * @details Exhaustive test of the reduction families on every 16-bit input
+ * @author Gabriel Abauzit
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "consts.h"
+#include "reduce.h"
+#include "ntt.h"
+
+// Representative of a mod q in [-(q-1)/2,(q-1)/2]
+int16_t centered(int64_t a) {
+	a %= KYBER_Q;
+	if (a > (KYBER_Q - 1) / 2) a -= KYBER_Q;
+	if (a < -(KYBER_Q - 1) / 2) a += KYBER_Q;
+	return (int16_t)a;
+}
+
+// Runs check on every 16-bit input with every entry of a 128 entries zeta table and of the basemul one
+int for_all_inputs(int (*check)(int16_t a, int i, int basemul)) {
+	int32_t a;
+	int i;
+
+	for (i = 0; i < 128; i++) {
+		for (a = INT16_MIN; a <= INT16_MAX; a++) {
+			if (check((int16_t)a, i, 0) == EXIT_FAILURE || check((int16_t)a, i, 1) == EXIT_FAILURE) return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+// zeta outside the Montgomery domain
+int16_t plain_zeta(int i, int basemul) {
+	return basemul ? zetas_basemul_shoup[i] : zetas_shoup[i];
+}
+
+/***********/
+/* BARRETT */
+/***********/
+
+// TEST 1 : barrett_reduce gives the representative in [-(q-1)/2,(q-1)/2] of every 16-bit input
+
+int test_barrett() {
+	int32_t a;
+
+	for (a = INT16_MIN; a <= INT16_MAX; a++) {
+		if (barrett_reduce((int16_t)a) != centered(a)) return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/**********/
+/* TABLES */
+/**********/
+
+// TEST 2 : the tables of every family hold the same zetas
+
+int test_tables() {
+	int i, basemul;
+	int16_t w, mont;
+	int32_t plantard, quot;
+	int64_t n;
+
+	for (i = 0; i < 128; i++) {
+		for (basemul = 0; basemul < 2; basemul++) {
+			w = plain_zeta(i, basemul);
+			mont = basemul ? zetas_basemul[i] : zetas[i];
+			quot = basemul ? zetas_basemul_shoup_quot[i] : zetas_shoup_quot[i];
+			plantard = basemul ? zetas_basemul_plantard[i] : zetas_plantard[i];
+
+			if (w != centered(w) || centered((int64_t)w * (1 << 16)) != mont) return EXIT_FAILURE;
+
+			// round(w * 2^16 / q), halves away from 0
+			n = (int64_t)w * 65536 + (w >= 0 ? KYBER_Q / 2 : -(KYBER_Q / 2));
+			if (quot != n / KYBER_Q) return EXIT_FAILURE;
+
+			// plantard * q = -2^32 * w (mod q) reduced in [-(q-1)/2,(q-1)/2], modulo 2^32
+			if ((uint32_t)plantard * (uint32_t)KYBER_Q != (uint32_t)(int32_t)centered(-(int64_t)w * (1LL << 32))) return EXIT_FAILURE;
+			if ((uint32_t)PLANTARD_QINV * (uint32_t)KYBER_Q != 1) return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/*****************************/
+/* MULTIPLICATIONS BY A ZETA */
+/*****************************/
+
+// TEST 3 : fqmul by the Montgomery zetas
+
+int check_montgomery(int16_t a, int i, int basemul) {
+	int16_t mont = basemul ? zetas_basemul[i] : zetas[i];
+
+	return fqmul(a, mont) == centered((int64_t)a * plain_zeta(i, basemul)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int test_montgomery() {
+	return for_all_inputs(check_montgomery);
+}
+
+// TEST 4 : shoup_mul gives the same result as fqmul
+
+int check_shoup(int16_t a, int i, int basemul) {
+	int16_t r = basemul ? shoup_mul(a, zetas_basemul_shoup[i], zetas_basemul_shoup_quot[i]) : shoup_mul(a, zetas_shoup[i], zetas_shoup_quot[i]);
+
+	return r == centered((int64_t)a * plain_zeta(i, basemul)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int test_shoup() {
+	return for_all_inputs(check_shoup);
+}
+
+// TEST 5 : plantard_mul gives the same result as fqmul, without a final reduction
+
+int check_plantard(int16_t a, int i, int basemul) {
+	int16_t r = basemul ? plantard_mul(a, zetas_basemul_plantard[i]) : plantard_mul(a, zetas_plantard[i]);
+
+	return r == centered((int64_t)a * plain_zeta(i, basemul)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int test_plantard() {
+	return for_all_inputs(check_plantard);
+}
+
+/**********************/
+/* DISPLAYING RESULTS */
+/**********************/
+
+void display_results(int num, int success, int* test_success) {
+	if (success == EXIT_SUCCESS) {
+		(*test_success)++;
+		printf("✅ TEST %i : Successful\n", num);
+	}
+	else {
+		printf("❌ TEST %i : Failure\n", num);
+	}
+}
+
+void run_test(int num, int (*test)(void), int trials, int* test_success, int* test_total) {
+	int i;
+	int success = EXIT_SUCCESS;
+
+	for (i = 0; i < trials; i++) {
+		if (test() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(num, success, test_success);
+	(*test_total)++;
+}
+
+/********************/
+/* TESTS EXECUTIONS */
+/********************/
+
+int main() {
+
+	int test_success = 0;
+	int test_total = 0;
+
+	printf("╔══════════════════════════════════════╗\n");
+	printf("║    RUNNING KYBER-mini REDUCE TESTS   ║\n");
+	printf("╚══════════════════════════════════════╝\n");
+
+	// Every input is covered, there is nothing random to repeat
+	run_test(1, test_barrett, 1, &test_success, &test_total);
+	run_test(2, test_tables, 1, &test_success, &test_total);
+	run_test(3, test_montgomery, 1, &test_success, &test_total);
+	run_test(4, test_shoup, 1, &test_success, &test_total);
+	run_test(5, test_plantard, 1, &test_success, &test_total);
+
+	/*****************/
+	/* FINAL SUMMARY */
+	/*****************/
+
+	printf("╔════════════════════════════════════════╗\n");
+	printf("║              FINAL SUMMARY             ║\n");
+	printf("╚════════════════════════════════════════╝\n");
+	printf("Successful tests : %i/%i\n", test_success, test_total);
+
+	if (test_success == test_total) {
+		printf("🎉 ALL TESTS WERE SUCCESSFUL 🎉\n");
+		return EXIT_SUCCESS;
+	}
+	else {
+		printf("⚠️  %i TEST(S) FAILED.\n", test_total - test_success);
+		return EXIT_FAILURE;
+	}
+
+}
@@ -0,0 +1,277 @@
+/**
+ * @file test_trace.c
+ * @details Test the trace-event timeline, built together with the sources and KYBER_TRACE (make test_trace)
+ * @author Gabriel Abauzit
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "consts.h"
+#include "poly.h"
+#include "polyvec.h"
+#include "trace.h"
+
+#ifndef KYBER_TRACE
+	#error "test_trace needs KYBER_TRACE, build it with make test_trace"
+#endif
+
+#define NUM_THREADS 4
+#define EVENTS_PER_THREAD 1000
+
+char path[64];
+
+// Events of the trace file, only the fields the tests look at
+typedef struct {
+	char name[64];
+	char phase;
+	double ts;
+	unsigned tid;
+} parsed_event_t;
+
+parsed_event_t parsed[NUM_THREADS * EVENTS_PER_THREAD * 2 + 64];
+
+// Reads back the file written by trace_flush, one event per line
+int parse_trace(int* count) {
+	FILE* f = fopen(path, "r");
+	char line[256];
+	parsed_event_t* e;
+	long pid;
+
+	*count = 0;
+	if (f == NULL) return EXIT_FAILURE;
+
+	if (fgets(line, sizeof(line), f) == NULL || strncmp(line, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 39) != 0) {
+		fclose(f);
+		return EXIT_FAILURE;
+	}
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (strcmp(line, "]}\n") == 0) {
+			fclose(f);
+			return EXIT_SUCCESS;
+		}
+		if (*count == (int)(sizeof(parsed) / sizeof(parsed[0]))) break;
+		e = &parsed[*count];
+		if (sscanf(line, "{\"name\":\"%63[^\"]\",\"ph\":\"%c\",\"ts\":%lf,\"pid\":%ld,\"tid\":%u}", e->name, &e->phase, &e->ts, &pid, &e->tid) != 5 || pid != (long)getpid()) {
+			fclose(f);
+			return EXIT_FAILURE;
+		}
+		(*count)++;
+	}
+
+	fclose(f);
+	return EXIT_FAILURE;
+}
+
+// Every thread has well nested begin/end pairs, with non-decreasing timestamps
+int check_nesting(int count) {
+	int i, j, depth;
+	const char* open[16];
+	double last;
+
+	for (i = 0; i < count; i++) {
+		// Events of a thread are contiguous in the file
+		if (i > 0 && parsed[i].tid == parsed[i - 1].tid) continue;
+		depth = 0;
+		last = 0;
+		for (j = i; j < count && parsed[j].tid == parsed[i].tid; j++) {
+			if (parsed[j].ts < last) return EXIT_FAILURE;
+			last = parsed[j].ts;
+			if (parsed[j].phase == 'B') {
+				if (depth == 16) return EXIT_FAILURE;
+				open[depth++] = parsed[j].name;
+			}
+			else if (parsed[j].phase != 'E' || depth == 0 || strcmp(open[--depth], parsed[j].name) != 0) {
+				return EXIT_FAILURE;
+			}
+		}
+		if (depth != 0) return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/**********/
+/* EVENTS */
+/**********/
+
+// TEST 1 : nothing is recorded while tracing is disabled
+
+int test_disabled() {
+	polyvec_t f = {0};
+	int count;
+
+	trace_reset();
+	trace_enable(0);
+	polyvec_ntt(&f);
+	polyvec_compress(&f, KYBER_DU);
+	if (trace_flush(path) == EXIT_FAILURE || parse_trace(&count) == EXIT_FAILURE) return EXIT_FAILURE;
+
+	return count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// TEST 2 : the instrumented stages are recorded as nested begin/end pairs
+
+int test_stages() {
+	polyvec_t f = {0}, g;
+	uint8_t bytes[KYBER_K * 32 * KYBER_DU];
+	const char* expected[] = {"polyvec_ntt", "polyvec_ntt_inv", "polyvec_compress", "polyvec_byte_encode"};
+	int count, i;
+
+	trace_reset();
+	trace_enable(1);
+	TRACE_BEGIN("test_stages");
+	polyvec_ntt(&f);
+	polyvec_ntt_inv(&f);
+	polyvec_copy(&g, &f);
+	polyvec_compress(&g, KYBER_DU);
+	polyvec_byte_encode(bytes, &g, KYBER_DU);
+	TRACE_END("test_stages");
+	trace_enable(0);
+
+	if (trace_flush(path) == EXIT_FAILURE || parse_trace(&count) == EXIT_FAILURE) return EXIT_FAILURE;
+	if (count != 10 || check_nesting(count) == EXIT_FAILURE) return EXIT_FAILURE;
+	for (i = 0; i < 4; i++) {
+		if (strcmp(parsed[1 + 2*i].name, expected[i]) != 0 || strcmp(parsed[2 + 2*i].name, expected[i]) != 0) return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+// TEST 3 : events of concurrent threads all end up in the file, each thread with its own id
+
+void* worker(void* arg) {
+	int i;
+
+	(void)arg;
+	for (i = 0; i < EVENTS_PER_THREAD / 2; i++) {
+		TRACE_BEGIN("outer");
+		TRACE_BEGIN("inner");
+		TRACE_END("inner");
+		TRACE_END("outer");
+	}
+
+	return NULL;
+}
+
+int test_threads() {
+	pthread_t threads[NUM_THREADS];
+	unsigned tids[NUM_THREADS];
+	int count, i, j, ntids = 0;
+
+	trace_reset();
+	trace_enable(1);
+	for (i = 0; i < NUM_THREADS; i++) {
+		if (pthread_create(&threads[i], NULL, worker, NULL) != 0) return EXIT_FAILURE;
+	}
+	for (i = 0; i < NUM_THREADS; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	trace_enable(0);
+
+	if (trace_flush(path) == EXIT_FAILURE || parse_trace(&count) == EXIT_FAILURE) return EXIT_FAILURE;
+	if (count != NUM_THREADS * EVENTS_PER_THREAD * 2 || check_nesting(count) == EXIT_FAILURE) return EXIT_FAILURE;
+
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < ntids && tids[j] != parsed[i].tid; j++);
+		if (j == ntids) {
+			if (ntids == NUM_THREADS) return EXIT_FAILURE;
+			tids[ntids++] = parsed[i].tid;
+		}
+	}
+
+	return ntids == NUM_THREADS && trace_dropped() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// TEST 4 : once the buffer of a thread is full, its events are dropped and counted
+
+int test_dropped() {
+	int i, count;
+
+	trace_reset();
+	trace_enable(1);
+	for (i = 0; i < TRACE_BUFFER_EVENTS + 10; i++) {
+		TRACE_BEGIN("fill");
+	}
+	trace_enable(0);
+
+	if (trace_dropped() != 10) return EXIT_FAILURE;
+	trace_reset();
+	if (trace_dropped() != 0 || trace_flush(path) == EXIT_FAILURE || parse_trace(&count) == EXIT_FAILURE) return EXIT_FAILURE;
+
+	return count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**********************/
+/* DISPLAYING RESULTS */
+/**********************/
+
+void display_results(int num, int success, int* test_success) {
+	if (success == EXIT_SUCCESS) {
+		(*test_success)++;
+		printf("✅ TEST %i : Successful\n", num);
+	}
+	else {
+		printf("❌ TEST %i : Failure\n", num);
+	}
+}
+
+void run_test(int num, int (*test)(void), int trials, int* test_success, int* test_total) {
+	int i;
+	int success = EXIT_SUCCESS;
+
+	for (i = 0; i < trials; i++) {
+		if (test() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(num, success, test_success);
+	(*test_total)++;
+}
+
+/********************/
+/* TESTS EXECUTIONS */
+/********************/
+
+int main() {
+
+	int test_success = 0;
+	int test_total = 0;
+
+	printf("╔══════════════════════════════════════╗\n");
+	printf("║    RUNNING KYBER-mini TRACE TESTS    ║\n");
+	printf("╚══════════════════════════════════════╝\n");
+
+	snprintf(path, sizeof(path), "/tmp/test_trace_%ld.json", (long)getpid());
+
+	run_test(1, test_disabled, 1, &test_success, &test_total);
+	run_test(2, test_stages, 10, &test_success, &test_total);
+	run_test(3, test_threads, 10, &test_success, &test_total);
+	run_test(4, test_dropped, 1, &test_success, &test_total);
+
+	trace_reset();
+	remove(path);
+
+	/*****************/
+	/* FINAL SUMMARY */
+	/*****************/
+
+	printf("╔════════════════════════════════════════╗\n");
+	printf("║              FINAL SUMMARY             ║\n");
+	printf("╚════════════════════════════════════════╝\n");
+	printf("Successful tests : %i/%i\n", test_success, test_total);
+
+	if (test_success == test_total) {
+		printf("🎉 ALL TESTS WERE SUCCESSFUL 🎉\n");
+		return EXIT_SUCCESS;
+	}
+	else {
+		printf("⚠️  %i TEST(S) FAILED.\n", test_total - test_success);
+		return EXIT_FAILURE;
+	}
+
+}
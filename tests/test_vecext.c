@@ -0,0 +1,247 @@
+/**
+ * @file test_vecext.c
+ * @details Test the vector extensions backend against the scalar reference
+ * @author Gabriel Abauzit
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "consts.h"
+#include "reduce.h"
+#include "poly.h"
+#include "ntt.h"
+#include "encode.h"
+#include "vecext.h"
+
+#ifndef NUM_TRIALS
+	#define NUM_TRIALS 1000
+#endif
+
+#ifdef VECEXT_AVAILABLE
+
+// Random inputs, with some of them set to the limit values 0 and +-(q-1)/2
+poly_t random_poly() {
+	int i;
+	poly_t f;
+	int kind = rand() % 8;
+
+	for (i = 0; i < KYBER_N; i++) {
+		switch (kind) {
+			case 0: f.coeffs[i] = 0; break;
+			case 1: f.coeffs[i] = (KYBER_Q - 1) / 2; break;
+			case 2: f.coeffs[i] = -(KYBER_Q - 1) / 2; break;
+			case 3: f.coeffs[i] = (rand() & 1) ? (KYBER_Q - 1) / 2 : -(KYBER_Q - 1) / 2; break;
+			default: f.coeffs[i] = barrett_reduce((int16_t)(rand() % KYBER_Q));
+		}
+	}
+
+	return f;
+}
+
+int same_coeffs(const int16_t* a, const int16_t* b) {
+	return memcmp(a, b, KYBER_N * sizeof(int16_t)) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**************/
+/* REDUCTIONS */
+/**************/
+
+// TEST 1 : barrett_reduce_vec = barrett_reduce for all int16 inputs
+
+int test_barrett_exhaustive() {
+	int32_t x;
+	int l;
+	vec16_t v = {0}, r;
+
+	for (x = INT16_MIN; x <= INT16_MAX; x += VECEXT_LANES) {
+		for (l = 0; l < VECEXT_LANES; l++) {
+			v[l] = (int16_t)(x + l);
+		}
+		r = barrett_reduce_vec(v);
+		for (l = 0; l < VECEXT_LANES; l++) {
+			if (r[l] != barrett_reduce(v[l])) return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+// TEST 2 : fqmul_vec = fqmul
+
+int test_fqmul() {
+	int l;
+	vec16_t a = {0}, b = {0}, r;
+
+	for (l = 0; l < VECEXT_LANES; l++) {
+		a[l] = (int16_t)(rand() % KYBER_Q - KYBER_Q / 2);
+		b[l] = (int16_t)(rand() % KYBER_Q - KYBER_Q / 2);
+	}
+	r = fqmul_vec(a, b);
+	for (l = 0; l < VECEXT_LANES; l++) {
+		if (r[l] != fqmul(a[l], b[l])) return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/*******/
+/* NTT */
+/*******/
+
+// TEST 3 : NTT_vecext = NTT_ref
+
+int test_NTT() {
+	poly_t f = random_poly();
+	poly_t g;
+
+	poly_copy(&g, &f);
+	NTT_ref(f.coeffs);
+	NTT_vecext(g.coeffs);
+
+	return same_coeffs(f.coeffs, g.coeffs);
+}
+
+// TEST 4 : NTT_inv_vecext = NTT_inv
+
+int test_NTT_inv() {
+	poly_t f = random_poly();
+	poly_t g;
+
+	poly_copy(&g, &f);
+	NTT_inv(f.coeffs);
+	NTT_inv_vecext(g.coeffs);
+
+	return same_coeffs(f.coeffs, g.coeffs);
+}
+
+// TEST 5 : NTT_multiply_vecext = NTT_multiply_ref
+
+int test_NTT_multiply() {
+	poly_t a = random_poly();
+	poly_t b = random_poly();
+	poly_t r, r_vec;
+
+	NTT_multiply_ref(r.coeffs, a.coeffs, b.coeffs);
+	NTT_multiply_vecext(r_vec.coeffs, a.coeffs, b.coeffs);
+
+	return same_coeffs(r.coeffs, r_vec.coeffs);
+}
+
+/********************************/
+/* ARITHMETIC OPERATIONS IN R_q */
+/********************************/
+
+// TEST 6 : poly_add_vecext = poly_add and poly_sub_vecext = poly_sub
+
+int test_add_sub() {
+	poly_t a = random_poly();
+	poly_t b = random_poly();
+	poly_t r, r_vec;
+
+	poly_add(&r, &a, &b);
+	poly_add_vecext(&r_vec, &a, &b);
+	if (same_coeffs(r.coeffs, r_vec.coeffs) == EXIT_FAILURE) return EXIT_FAILURE;
+
+	poly_sub(&r, &a, &b);
+	poly_sub_vecext(&r_vec, &a, &b);
+	return same_coeffs(r.coeffs, r_vec.coeffs);
+}
+
+/***************/
+/* COMPRESSION */
+/***************/
+
+// TEST 7 : poly_compress_vecext = poly_compress_ref for all d < 12
+
+int test_compress() {
+	poly_t f = random_poly();
+	poly_t g, g_vec;
+	unsigned d;
+
+	for (d = 1; d < 12; d++) {
+		poly_copy(&g, &f);
+		poly_copy(&g_vec, &f);
+		poly_compress_ref(&g, d);
+		poly_compress_vecext(&g_vec, d);
+		if (same_coeffs(g.coeffs, g_vec.coeffs) == EXIT_FAILURE) return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+#endif
+
+/**********************/
+/* DISPLAYING RESULTS */
+/**********************/
+
+void display_results(int num, int success, int* test_success) {
+	if (success == EXIT_SUCCESS) {
+		(*test_success)++;
+		printf("✅ TEST %i : Successful\n", num);
+	}
+	else {
+		printf("❌ TEST %i : Failure\n", num);
+	}
+}
+
+void run_test(int num, int (*test)(void), int trials, int* test_success, int* test_total) {
+	int i;
+	int success = EXIT_SUCCESS;
+
+	for (i = 0; i < trials; i++) {
+		if (test() == EXIT_FAILURE) {
+			success = EXIT_FAILURE;
+		}
+	}
+
+	display_results(num, success, test_success);
+	(*test_total)++;
+}
+
+/********************/
+/* TESTS EXECUTIONS */
+/********************/
+
+int main() {
+
+	int test_success = 0;
+	int test_total = 0;
+
+	printf("╔══════════════════════════════════════╗\n");
+	printf("║    RUNNING KYBER-mini VECEXT TESTS   ║\n");
+	printf("╚══════════════════════════════════════╝\n");
+
+#ifdef VECEXT_AVAILABLE
+	run_test(1, test_barrett_exhaustive, 1, &test_success, &test_total);
+	run_test(2, test_fqmul, NUM_TRIALS, &test_success, &test_total);
+	run_test(3, test_NTT, NUM_TRIALS, &test_success, &test_total);
+	run_test(4, test_NTT_inv, NUM_TRIALS, &test_success, &test_total);
+	run_test(5, test_NTT_multiply, NUM_TRIALS, &test_success, &test_total);
+	run_test(6, test_add_sub, NUM_TRIALS, &test_success, &test_total);
+	run_test(7, test_compress, NUM_TRIALS, &test_success, &test_total);
+#else
+	printf("Vector extensions are not available with this compiler, nothing to test\n");
+#endif
+
+	/*****************/
+	/* FINAL SUMMARY */
+	/*****************/
+
+	printf("╔════════════════════════════════════════╗\n");
+	printf("║              FINAL SUMMARY             ║\n");
+	printf("╚════════════════════════════════════════╝\n");
+	printf("Successful tests : %i/%i\n", test_success, test_total);
+
+	if (test_success == test_total) {
+		printf("🎉 ALL TESTS WERE SUCCESSFUL 🎉\n");
+		return EXIT_SUCCESS;
+	}
+	else {
+		printf("⚠️  %i TEST(S) FAILED.\n", test_total - test_success);
+		return EXIT_FAILURE;
+	}
+
+}
@@ -0,0 +1,79 @@
+#!/bin/sh
+# Usage : tools/amalgamate.sh <include dir> <src dir> <output dir>
+#
+# Writes <output dir>/kyber.h, all the headers of <include dir> in dependency order, and <output dir>/kyber.c, all the
+# sources of <src dir> in a single translation unit built with KYBER_AMALGAMATED (see consts.h).
+# The local #include lines are blanked and #line directives kept, so that diagnostics point to the original files.
+
+set -e
+
+inc=$1
+src=$2
+out=$3
+
+if [ -z "$inc" ] || [ -z "$src" ] || [ -z "$out" ]; then
+	echo "Usage : $0 <include dir> <src dir> <output dir>" >&2
+	exit 1
+fi
+
+mkdir -p "$out"
+
+# A header is emitted once all the local headers it includes have been
+order=""
+remaining=$(cd "$inc" && ls *.h)
+while [ -n "$remaining" ]; do
+	next=""
+	progress=0
+	for h in $remaining; do
+		ready=1
+		for dep in $(sed -n 's/^#include "\(.*\)".*/\1/p' "$inc/$h"); do
+			case " $order " in
+				*" $dep "*) ;;
+				*) ready=0 ;;
+			esac
+		done
+		if [ $ready = 1 ]; then
+			order="$order $h"
+			progress=1
+		else
+			next="$next $h"
+		fi
+	done
+	if [ $progress = 0 ]; then
+		echo "$0 : cyclic or missing includes in$next" >&2
+		exit 1
+	fi
+	remaining=$next
+done
+
+{
+	echo "/**"
+	echo " * @file kyber.h"
+	echo " * @brief Amalgamated header, generated by tools/amalgamate.sh from $inc/, do not edit"
+	echo " */"
+	echo
+	echo "#ifndef KYBER_AMALGAMATED_H"
+	echo "#define KYBER_AMALGAMATED_H"
+	for h in $order; do
+		echo
+		echo "#line 1 \"$inc/$h\""
+		sed 's/^#include ".*//' "$inc/$h"
+	done
+	echo
+	echo "#endif"
+} > "$out/kyber.h"
+
+{
+	echo "/**"
+	echo " * @file kyber.c"
+	echo " * @brief Amalgamated sources, generated by tools/amalgamate.sh from $src/, do not edit"
+	echo " */"
+	echo
+	echo "#define KYBER_AMALGAMATED 1"
+	echo "#include \"kyber.h\""
+	for c in $(cd "$src" && ls *.c); do
+		echo
+		echo "#line 1 \"$src/$c\""
+		sed 's/^#include ".*//' "$src/$c"
+	done
+} > "$out/kyber.c"
@@ -0,0 +1,91 @@
+/**
+ * @file keystore_build.c
+ * @details Builds a keystore file from keys in their FIPS 203 byte encoding
+ * @author Gabriel Abauzit
+ *
+ * Usage : keystore_build [-n vectors_per_key] <input> <output>
+ *
+ * The input is a sequence of records, each one made of a 32-byte fingerprint followed by vectors_per_key vectors
+ * encoded with ByteEncode_12 (KYBER_K * 384 bytes each) in the NTT domain, e.g. the t part of ek.
+ * Records with a coefficient out of [0, q) are rejected, as well as repeated fingerprints.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "polyvec.h"
+#include "keystore.h"
+
+#define VECTOR_BYTES (KYBER_K * POLY_PACKED_BYTES)
+
+int main(int argc, char** argv) {
+	uint32_t vectors_per_key = 1;
+	const char* input;
+	const char* output;
+	FILE* f;
+	long size;
+	uint8_t* bytes;
+	uint8_t (*fingerprints)[KEYSTORE_FINGERPRINT_BYTES];
+	polyvec_t* vectors;
+	size_t record_bytes, count, i, j;
+	const uint8_t* record;
+	int argi = 1;
+
+	if (argc == 5 && strcmp(argv[1], "-n") == 0) {
+		vectors_per_key = (uint32_t)strtoul(argv[2], NULL, 10);
+		argi = 3;
+	}
+	if (argc != argi + 2 || vectors_per_key == 0) {
+		fprintf(stderr, "Usage : %s [-n vectors_per_key] <input> <output>\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	input = argv[argi];
+	output = argv[argi + 1];
+
+	f = fopen(input, "rb");
+	if (f == NULL || fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0 || fseek(f, 0, SEEK_SET) != 0) {
+		fprintf(stderr, "Cannot read %s\n", input);
+		return EXIT_FAILURE;
+	}
+
+	record_bytes = KEYSTORE_FINGERPRINT_BYTES + vectors_per_key * VECTOR_BYTES;
+	if ((size_t)size % record_bytes != 0) {
+		fprintf(stderr, "%s is not made of whole records of %zu bytes\n", input, record_bytes);
+		fclose(f);
+		return EXIT_FAILURE;
+	}
+	count = (size_t)size / record_bytes;
+
+	bytes = (uint8_t*)malloc((size_t)size + 1);
+	fingerprints = malloc((count + 1) * KEYSTORE_FINGERPRINT_BYTES);
+	vectors = (polyvec_t*)malloc((count * vectors_per_key + 1) * sizeof(polyvec_t));
+	if (bytes == NULL || fingerprints == NULL || vectors == NULL || fread(bytes, 1, (size_t)size, f) != (size_t)size) {
+		fprintf(stderr, "Cannot read %s\n", input);
+		fclose(f);
+		return EXIT_FAILURE;
+	}
+	fclose(f);
+
+	for (i = 0; i < count; i++) {
+		record = bytes + i * record_bytes;
+		memcpy(fingerprints[i], record, KEYSTORE_FINGERPRINT_BYTES);
+		for (j = 0; j < vectors_per_key; j++) {
+			if (polyvec_decode12_checked(&vectors[i * vectors_per_key + j], record + KEYSTORE_FINGERPRINT_BYTES + j * VECTOR_BYTES) == EXIT_FAILURE) {
+				fprintf(stderr, "Record %zu : coefficient out of [0, q)\n", i);
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	if (keystore_write(output, (const uint8_t (*)[KEYSTORE_FINGERPRINT_BYTES])fingerprints, vectors, count, vectors_per_key) == EXIT_FAILURE) {
+		fprintf(stderr, "Cannot write %s (repeated fingerprint or I/O error)\n", output);
+		return EXIT_FAILURE;
+	}
+
+	printf("%zu keys written to %s\n", count, output);
+
+	free(bytes);
+	free(fingerprints);
+	free(vectors);
+	return EXIT_SUCCESS;
+}
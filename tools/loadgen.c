@@ -0,0 +1,416 @@
+/**
+ * @file loadgen.c
+ * @details Load generator : keygen, encaps and decaps from several threads, with latency percentiles
+ * @author Gabriel Abauzit
+ *
+ * Usage : loadgen [-t threads] [-d seconds] [-r ops_per_second] [-m keygen:encaps:decaps] [-p parameter_set]
+ *
+ * Each thread runs a closed loop : it starts its next operation when the previous one is done, or at its next slot
+ * when a target rate is given. In the latter case the latency is measured from the slot, so that an operation delayed
+ * by a slow one before it is counted as late instead of being left out.
+ *
+ * The library has no hash function nor sampler : G, H, J, the expansion of A and the CBD noise are stand-ins derived
+ * from a splitmix64 stream. The numbers cover the arithmetic of the library, and the seeds drawn from randpool, not the
+ * cost of SHA-3.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "polyvec.h"
+#include "keycache.h"
+#include "encaps.h"
+#include "decaps.h"
+#include "randpool.h"
+
+// Log-linear histogram as in HdrHistogram : 2^HIST_SUB_BITS buckets per power of two, under 1% of relative error
+#define HIST_SUB_BITS 7
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS) * HIST_SUB)
+
+// Ciphertexts each thread encapsulates at startup and decapsulates in turn
+#define LOADGEN_CIPHERTEXTS 64
+
+typedef enum {
+    OP_KEYGEN,
+    OP_ENCAPS,
+    OP_DECAPS,
+    OPS
+} op_t;
+
+static const char* op_names[OPS] = {"keygen", "encaps", "decaps"};
+
+typedef struct {
+    uint64_t counts[HIST_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+} histogram_t;
+
+typedef struct {
+    unsigned weights[OPS];
+    double rate;                          // operations per second of each thread, 0 for as fast as possible
+    double seconds;
+} config_t;
+
+typedef struct {
+    pthread_t thread;
+    const config_t* config;
+    uint64_t seed;
+    histogram_t hist[OPS];
+    uint64_t begin;                       // measured window, after the keygen and the first encapsulations
+    uint64_t end;
+    int status;
+} worker_t;
+
+/*************/
+/* HISTOGRAM */
+/*************/
+
+static size_t hist_index(const uint64_t v) {
+    int msb;
+
+    if (v < HIST_SUB) return (size_t)v;
+    msb = 63 - __builtin_clzll(v);
+    return (size_t)(msb - HIST_SUB_BITS + 1) * HIST_SUB + (size_t)((v >> (msb - HIST_SUB_BITS)) - HIST_SUB);
+}
+
+// Highest value of a bucket
+static uint64_t hist_value(const size_t index) {
+    size_t exp = index / HIST_SUB, sub = index % HIST_SUB;
+
+    if (exp == 0) return sub;
+    return ((uint64_t)(HIST_SUB + sub + 1) << (exp - 1)) - 1;
+}
+
+static void hist_record(histogram_t* h, const uint64_t v) {
+    h->counts[hist_index(v)]++;
+    h->total++;
+    if (v > h->max) h->max = v;
+}
+
+static void hist_merge(histogram_t* r, const histogram_t* h) {
+    size_t i;
+
+    for (i = 0; i < HIST_BUCKETS; i++) {
+        r->counts[i] += h->counts[i];
+    }
+    r->total += h->total;
+    if (h->max > r->max) r->max = h->max;
+}
+
+static uint64_t hist_percentile(const histogram_t* h, const double p) {
+    uint64_t rank = (uint64_t)(p / 100.0 * (double)h->total + 0.5), seen = 0;
+    size_t i;
+
+    if (rank == 0) rank = 1;
+    for (i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) return hist_value(i) < h->max ? hist_value(i) : h->max;
+    }
+    return h->max;
+}
+
+/***************/
+/* STAND-INS   */
+/***************/
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t stream_init(const uint8_t* a, const size_t a_len, const uint8_t* b, const size_t b_len) {
+    uint64_t state = 0xcbf29ce484222325ULL;
+    size_t i;
+
+    for (i = 0; i < a_len; i++) state = (state ^ a[i]) * 0x100000001b3ULL;
+    for (i = 0; i < b_len; i++) state = (state ^ b[i]) * 0x100000001b3ULL;
+    return state;
+}
+
+static uint64_t stream_next(uint64_t* state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static void stream_bytes(uint64_t* state, uint8_t* out, const size_t len) {
+    size_t i;
+
+    for (i = 0; i < len; i++) out[i] = (uint8_t)stream_next(state);
+}
+
+static void stream_small_poly(uint64_t* state, poly_t* f, const int eta) {
+    int i;
+
+    for (i = 0; i < KYBER_N; i++) {
+        f->coeffs[i] = (int16_t)((int)(stream_next(state) % (uint64_t)(2 * eta + 1)) - eta);
+    }
+}
+
+// SampleNTT(XOF(rho || j || i))
+static void stream_entry(poly_t* a, const int i, const int j, void* arg) {
+    uint8_t ij[2] = {(uint8_t)j, (uint8_t)i};
+    uint64_t state = stream_init((const uint8_t*)arg, 32, ij, 2);
+    int k;
+
+    for (k = 0; k < KYBER_N; k++) {
+        a->coeffs[k] = (int16_t)(stream_next(&state) % KYBER_Q);
+    }
+}
+
+static void stream_derive(uint8_t K[DECAPS_KEY_BYTES], polyvec_t* r, polyvec_t* e1, poly_t* e2, const uint8_t m[KYBER_N / 8], const uint8_t ek_hash[KEYCACHE_FINGERPRINT_BYTES], void* arg) {
+    uint64_t state = stream_init(m, KYBER_N / 8, ek_hash, KEYCACHE_FINGERPRINT_BYTES);
+    int i;
+
+    (void)arg;
+    stream_bytes(&state, K, DECAPS_KEY_BYTES);
+    for (i = 0; i < KYBER_K; i++) stream_small_poly(&state, &r->vec[i], KYBER_ETA1);
+    for (i = 0; i < KYBER_K; i++) stream_small_poly(&state, &e1->vec[i], KYBER_ETA2);
+    stream_small_poly(&state, e2, KYBER_ETA2);
+}
+
+static void stream_reject(uint8_t K_bar[DECAPS_KEY_BYTES], const uint8_t ct[CIPHERTEXT_BYTES], void* arg) {
+    uint64_t state = stream_init((const uint8_t*)arg, 32, ct, CIPHERTEXT_BYTES);
+
+    stream_bytes(&state, K_bar, DECAPS_KEY_BYTES);
+}
+
+/**************/
+/* OPERATIONS */
+/**************/
+
+// A key pair as a server holds it : the encoded public key, the matrix, and the key prepared for decapsulation
+typedef struct {
+    uint8_t rho[32];
+    uint8_t z[32];
+    uint8_t t_bytes[ENCAPS_T_BYTES];
+    polymat_t A;
+    prepared_key_t dk;
+} keypair_t;
+
+// ML-KEM.KeyGen : d and z from randpool, A expanded from rho, t = A s + e
+static int keygen(keypair_t* kp) {
+    uint8_t d[RANDPOOL_SEED_BYTES], sigma[32], s_bytes[KEYCACHE_VECTOR_BYTES], ek_hash[KEYCACHE_FINGERPRINT_BYTES];
+    polyvec_t s_hat, e, t_hat;
+    polyvec_packed_t packed;
+    uint64_t state;
+    int i, j;
+
+    if (randpool_seed(d) == EXIT_FAILURE || randpool_seed(kp->z) == EXIT_FAILURE) return EXIT_FAILURE;
+    state = stream_init(d, sizeof(d), NULL, 0);
+    stream_bytes(&state, kp->rho, 32);
+    stream_bytes(&state, sigma, 32);
+
+    for (i = 0; i < KYBER_K; i++) {
+        for (j = 0; j < KYBER_K; j++) {
+            stream_entry(&kp->A.row[i].vec[j], i, j, kp->rho);
+        }
+    }
+    state = stream_init(sigma, sizeof(sigma), NULL, 0);
+    for (i = 0; i < KYBER_K; i++) {
+        stream_small_poly(&state, &s_hat.vec[i], KYBER_ETA1);
+        stream_small_poly(&state, &e.vec[i], KYBER_ETA1);
+    }
+
+    polyvec_ntt(&s_hat);
+    polyvec_ntt(&e);
+    polymat_ntt_product(&t_hat, &kp->A, &s_hat, 0);
+    for (i = 0; i < KYBER_K; i++) {
+        poly_to_montgomery(&t_hat.vec[i]);
+    }
+    polyvec_add(&t_hat, &t_hat, &e);
+
+    polyvec_pack(&packed, &s_hat);
+    memcpy(s_bytes, packed.vec, KEYCACHE_VECTOR_BYTES);
+    polyvec_pack(&packed, &t_hat);
+    memcpy(kp->t_bytes, packed.vec, ENCAPS_T_BYTES);
+
+    state = stream_init(kp->t_bytes, ENCAPS_T_BYTES, kp->rho, 32);
+    stream_bytes(&state, ek_hash, sizeof(ek_hash));
+    return prepared_key_init(&kp->dk, ek_hash, s_bytes, kp->t_bytes, &kp->A);
+}
+
+// ML-KEM.Encaps to a peer whose key arrives with the handshake : the context is built for this single encryption
+static int encaps(uint8_t ct[CIPHERTEXT_BYTES], uint8_t K[DECAPS_KEY_BYTES], encaps_ctx_t* ctx, const keypair_t* peer) {
+    uint8_t m[RANDPOOL_SEED_BYTES];
+    polyvec_t r, e1;
+    poly_t e2;
+
+    if (randpool_seed(m) == EXIT_FAILURE) return EXIT_FAILURE;
+    if (encaps_ctx_init(ctx, peer->t_bytes, &peer->A, peer->dk.fingerprint) == EXIT_FAILURE) return EXIT_FAILURE;
+    stream_derive(K, &r, &e1, &e2, m, ctx->ek_hash, NULL);
+    encaps_ctx_encrypt(ct, ctx, m, &r, &e1, &e2);
+    return EXIT_SUCCESS;
+}
+
+/***********/
+/* WORKERS */
+/***********/
+
+typedef struct {
+    keypair_t kp;                         // decapsulation key and peer key of the encapsulations
+    keypair_t scratch;                    // output of the keygens
+    encaps_ctx_t ctx;
+    uint8_t cts[LOADGEN_CIPHERTEXTS][CIPHERTEXT_BYTES];
+    uint8_t keys[LOADGEN_CIPHERTEXTS][DECAPS_KEY_BYTES];
+} worker_state_t;
+
+static void* worker_run(void* arg) {
+    worker_t* w = (worker_t*)arg;
+    const config_t* c = w->config;
+    worker_state_t* st = (worker_state_t*)aligned_alloc(POLYMAT_ALIGN, sizeof(worker_state_t));
+    decaps_primitives_t prim = {stream_derive, stream_reject, NULL};
+    uint8_t K[DECAPS_KEY_BYTES];
+    uint64_t choice = w->seed, interval, slot, start, end, deadline;
+    unsigned total_weight = c->weights[OP_KEYGEN] + c->weights[OP_ENCAPS] + c->weights[OP_DECAPS], pick;
+    size_t next_ct = 0, i;
+    op_t op;
+
+    w->status = EXIT_FAILURE;
+    if (st == NULL) return NULL;
+
+    if (keygen(&st->kp) == EXIT_FAILURE) goto done;
+    prim.arg = st->kp.z;
+    for (i = 0; i < LOADGEN_CIPHERTEXTS; i++) {
+        if (encaps(st->cts[i], st->keys[i], &st->ctx, &st->kp) == EXIT_FAILURE) goto done;
+    }
+
+    interval = c->rate > 0 ? (uint64_t)(1e9 / c->rate) : 0;
+    slot = now_ns();
+    deadline = slot + (uint64_t)(c->seconds * 1e9);
+    w->begin = slot;
+
+    while ((start = now_ns()) < deadline) {
+        if (interval > 0) {
+            if (start < slot) {
+                struct timespec ts = {(time_t)((slot - start) / 1000000000ULL), (long)((slot - start) % 1000000000ULL)};
+                nanosleep(&ts, NULL);
+            }
+            start = slot;
+            slot += interval;
+        }
+
+        pick = (unsigned)(stream_next(&choice) % total_weight);
+        op = pick < c->weights[OP_KEYGEN] ? OP_KEYGEN : pick < c->weights[OP_KEYGEN] + c->weights[OP_ENCAPS] ? OP_ENCAPS : OP_DECAPS;
+
+        switch (op) {
+            case OP_KEYGEN:
+                if (keygen(&st->scratch) == EXIT_FAILURE) goto done;
+                break;
+            case OP_ENCAPS:
+                if (encaps(st->cts[next_ct], K, &st->ctx, &st->kp) == EXIT_FAILURE) goto done;
+                memcpy(st->keys[next_ct], K, DECAPS_KEY_BYTES);
+                break;
+            default:
+                kem_dec(&st->kp.dk, &prim, st->cts[next_ct], K);
+                if (memcmp(K, st->keys[next_ct], DECAPS_KEY_BYTES) != 0) {
+                    fprintf(stderr, "Decapsulation gave a wrong key\n");
+                    goto done;
+                }
+                break;
+        }
+        next_ct = (next_ct + 1) % LOADGEN_CIPHERTEXTS;
+
+        end = now_ns();
+        hist_record(&w->hist[op], end - start);
+    }
+    w->status = EXIT_SUCCESS;
+
+done:
+    w->end = now_ns();
+    memset(st, 0, sizeof(worker_state_t));
+    free(st);
+    return NULL;
+}
+
+/**********/
+/* REPORT */
+/**********/
+
+static void report_line(const char* name, const histogram_t* h, const double seconds) {
+    if (h->total == 0) {
+        printf("%-8s %10s\n", name, "-");
+        return;
+    }
+    printf("%-8s %10llu %12.0f %10.1f %10.1f %10.1f %10.1f %10.1f\n", name, (unsigned long long)h->total, (double)h->total / seconds,
+        hist_percentile(h, 50.0) / 1e3, hist_percentile(h, 90.0) / 1e3, hist_percentile(h, 99.0) / 1e3,
+        hist_percentile(h, 99.9) / 1e3, h->max / 1e3);
+}
+
+static int parse_mix(const char* s, unsigned weights[OPS]) {
+    return sscanf(s, "%u:%u:%u", &weights[OP_KEYGEN], &weights[OP_ENCAPS], &weights[OP_DECAPS]) == 3
+        && weights[OP_KEYGEN] + weights[OP_ENCAPS] + weights[OP_DECAPS] > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char** argv) {
+    config_t config = {{1, 1, 1}, 0, 5};
+    unsigned threads = 1, param_set = 256 * KYBER_K, t;
+    double rate = 0;
+    worker_t* workers;
+    histogram_t* merged;
+    uint64_t begin = UINT64_MAX, end = 0;
+    double elapsed;
+    int i, k, status = EXIT_SUCCESS;
+
+    for (i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-t") == 0) threads = (unsigned)strtoul(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "-d") == 0) config.seconds = strtod(argv[i + 1], NULL);
+        else if (strcmp(argv[i], "-r") == 0) rate = strtod(argv[i + 1], NULL);
+        else if (strcmp(argv[i], "-m") == 0 && parse_mix(argv[i + 1], config.weights) == EXIT_SUCCESS) continue;
+        else if (strcmp(argv[i], "-p") == 0) param_set = (unsigned)strtoul(argv[i + 1], NULL, 10);
+        else break;
+    }
+    if (i != argc || threads == 0 || config.seconds <= 0 || rate < 0) {
+        fprintf(stderr, "Usage : %s [-t threads] [-d seconds] [-r ops_per_second] [-m keygen:encaps:decaps] [-p parameter_set]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (param_set != 256 * KYBER_K) {
+        fprintf(stderr, "This build is ML-KEM-%d, the parameter set is chosen by KYBER_K in consts.h\n", 256 * KYBER_K);
+        return EXIT_FAILURE;
+    }
+    config.rate = rate / threads;
+
+    workers = (worker_t*)calloc(threads, sizeof(worker_t));
+    merged = (histogram_t*)calloc(OPS, sizeof(histogram_t));
+    if (workers == NULL || merged == NULL) return EXIT_FAILURE;
+
+    printf("ML-KEM-%d, %u thread(s), %.1f s, mix %u:%u:%u, ", 256 * KYBER_K, threads, config.seconds,
+        config.weights[OP_KEYGEN], config.weights[OP_ENCAPS], config.weights[OP_DECAPS]);
+    if (rate > 0) printf("target %.0f ops/s\n", rate);
+    else printf("as fast as possible\n");
+
+    for (t = 0; t < threads; t++) {
+        workers[t].config = &config;
+        workers[t].seed = 0x2545F4914F6CDD1DULL * (t + 1);
+        if (pthread_create(&workers[t].thread, NULL, worker_run, &workers[t]) != 0) return EXIT_FAILURE;
+    }
+    for (t = 0; t < threads; t++) {
+        pthread_join(workers[t].thread, NULL);
+        if (workers[t].status == EXIT_FAILURE) status = EXIT_FAILURE;
+        for (k = 0; k < OPS; k++) {
+            hist_merge(&merged[k], &workers[t].hist[k]);
+        }
+        // begin stays 0 if the setup failed
+        if (workers[t].begin == 0) continue;
+        if (workers[t].begin < begin) begin = workers[t].begin;
+        if (workers[t].end > end) end = workers[t].end;
+    }
+    // The rates only count the time the workers spent in their loop, not their setup
+    elapsed = end > begin ? (double)(end - begin) / 1e9 : 1.0;
+
+    printf("%-8s %10s %12s %10s %10s %10s %10s %10s\n", "op", "count", "ops/s", "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+    for (k = 0; k < OPS; k++) {
+        report_line(op_names[k], &merged[k], elapsed);
+    }
+
+    free(workers);
+    free(merged);
+    return status;
+}